@@ -48,6 +48,13 @@ CRT_MONITOR=false
 
 UI_SCALE=4
 
+-- synthesize the sound on the audio thread
+-- from up to AUDIO_RING queued ticks,
+-- 0 sends whole frames of samples instead
+AUDIO_RING=0
+-- samples the device asks for at once
+AUDIO_BUFFER=256
+
 ---------------------------
 function TIC()
 	cls()
@@ -0,0 +1,52 @@
+-- title:  remap
+-- author: Nesbox
+-- desc:   map remap callback drawing sprites over the tiles
+-- script: lua
+-- input:  gamepad
+
+-- checkerboard tiles and a map made of them
+for i=0,3 do
+	for p=0,63 do
+		poke4(0x4000*2+i*64+p,(p//8+p%8)%2==0 and i+2 or i+8)
+	end
+end
+
+for y=0,16 do
+	for x=0,29 do
+		mset(x,y,(x+y)%4)
+	end
+end
+
+t=0
+
+function TIC()
+	cls(0)
+	rect(t%240,20,40,40,12)
+
+	-- spr and rect inside the callback have to land between the map cells
+	-- and the draws around the map call
+	map(0,0,30,17,0,0,-1,1,function(tile,x,y)
+		if (x+y+t//8)%7==0 then
+			spr(3-tile,x*8+4,y*8+4,0)
+		end
+		if x==y then
+			rect(x*8,y*8,4,4,t%16)
+		end
+		return (tile+t//30)%4
+	end)
+
+	-- the batched callback gets and returns flat tables of
+	-- {tile,x,y} and {tile,flip,rotate} triples
+	map(0,0,10,4,0,104,-1,1,function(cells)
+		local res={}
+		for i=1,#cells,3 do
+			spr(cells[i],cells[i+1]*8+2,104+cells[i+2]*8+2,0)
+			res[i],res[i+1],res[i+2]=(cells[i]+1)%4,t//16%4,0
+		end
+		return res
+	end,true)
+
+	circ(120,68,20+t%20,5)
+	print("remap",100,60,15)
+	t=t+1
+end
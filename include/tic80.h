@@ -62,6 +62,9 @@ typedef struct
 
 	u32* screen;
 	tic80_pixel_color_format screen_format;
+
+	// number of screen rows changed by the last tick, zero if the frame is the same as the previous one
+	s32 dirty;
 	
 } tic80;
 
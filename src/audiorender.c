@@ -0,0 +1,227 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "audiorender.h"
+#include "tools.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(TIC80_THREADS)
+#   if defined(_WIN32)
+#       include <windows.h>
+#   else
+#       include <pthread.h>
+#       include <unistd.h>
+#   endif
+#endif
+
+// a track that jumps back forever is cut after 10 minutes
+#define MAX_FRAMES (TIC80_FRAMERATE * 60 * 10)
+
+typedef struct
+{
+    const tic_audio_source* source;
+    tic_audio_job* jobs;
+    s32 count;
+    s32 first;
+    s32 step;
+    bool ok;
+} Worker;
+
+static bool appendSamples(tic_audio_job* job, const tic_mem* tic, s32* capacity)
+{
+    s32 frames = tic->samples.size / sizeof(s16) / TIC_STEREO_CHANNELS;
+
+    if(job->count + frames > *capacity)
+    {
+        s32 size = MAX(*capacity * 2, job->count + frames);
+        s16* samples = realloc(job->samples, size * TIC_STEREO_CHANNELS * sizeof(s16));
+
+        if(!samples) return false;
+
+        job->samples = samples;
+        *capacity = size;
+    }
+
+    memcpy(job->samples + job->count * TIC_STEREO_CHANNELS, tic->samples.buffer, frames * TIC_STEREO_CHANNELS * sizeof(s16));
+    job->count += frames;
+
+    return true;
+}
+
+// same steps as the studio export, ticks of the sound only
+static bool renderSfx(tic_mem* tic, tic_audio_job* job)
+{
+    const tic_sample* effect = &tic->ram.sfx.samples.data[job->index];
+    s32 capacity = 0;
+
+    enum{Channel = 0};
+    tic_api_sfx(tic, job->index, effect->note, effect->octave, -1, Channel, MAX_VOLUME, SFX_DEF_SPEED);
+
+    for(s32 ticks = 0, pos = 0; pos < SFX_TICKS; pos = tic_tool_sfx_pos(effect->speed, ++ticks))
+    {
+        tic_core_tick_start(tic);
+        tic_core_tick_end(tic);
+
+        if(!appendSamples(job, tic, &capacity))
+            return false;
+    }
+
+    return true;
+}
+
+static bool renderMusic(tic_mem* tic, const tic_audio_source* source, tic_audio_job* job)
+{
+    const tic_sound_state* state = &tic->ram.sound_state;
+    s32 capacity = 0;
+
+    tic_api_music(tic, job->index, -1, -1, false, source->sustain);
+
+    for(s32 frame = 0; state->flag.music_state == tic_music_play && frame < MAX_FRAMES; frame++)
+    {
+        tic_core_tick_start(tic);
+
+        for (s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+            if(source->mute[i])
+                tic->ram.registers[i].volume = 0;
+
+        tic_core_tick_end(tic);
+
+        if(!appendSamples(job, tic, &capacity))
+            return false;
+    }
+
+    return true;
+}
+
+static void work(Worker* worker)
+{
+    const tic_audio_source* source = worker->source;
+
+    for(s32 i = worker->first; i < worker->count; i += worker->step)
+    {
+        tic_audio_job* job = &worker->jobs[i];
+        tic_mem* tic = tic_core_create(source->samplerate);
+
+        job->samples = NULL;
+        job->count = 0;
+
+        if(!tic)
+        {
+            worker->ok = false;
+            continue;
+        }
+
+        tic->ram.sfx = *source->sfx;
+        tic->ram.music = *source->music;
+
+        if(!(job->sfx ? renderSfx(tic, job) : renderMusic(tic, source, job)))
+            worker->ok = false;
+
+        tic_core_close(tic);
+    }
+}
+
+#if defined(TIC80_THREADS)
+
+static s32 getCores()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    return sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI workThread(LPVOID data) {work(data); return 0;}
+#else
+static void* workThread(void* data) {work(data); return NULL;}
+#endif
+
+bool tic_audio_render(const tic_audio_source* source, tic_audio_job* jobs, s32 count)
+{
+    enum {MaxThreads = 64};
+
+    if(count <= 0) return true;
+
+    // the jobs are dealt to the threads in turn, the first one runs on the calling thread
+    s32 threads = CLAMP(getCores(), 1, MIN(count, MaxThreads));
+    Worker workers[MaxThreads];
+    bool started[MaxThreads] = {false};
+
+#if defined(_WIN32)
+    HANDLE handles[MaxThreads];
+#else
+    pthread_t handles[MaxThreads];
+#endif
+
+    for(s32 i = 0; i < threads; i++)
+    {
+        workers[i] = (Worker){source, jobs, count, i, threads, true};
+
+        if(i == 0) continue;
+
+#if defined(_WIN32)
+        started[i] = (handles[i] = CreateThread(NULL, 0, workThread, &workers[i], 0, NULL)) != NULL;
+#else
+        started[i] = pthread_create(&handles[i], NULL, workThread, &workers[i]) == 0;
+#endif
+    }
+
+    work(&workers[0]);
+
+    bool ok = workers[0].ok;
+
+    for(s32 i = 1; i < threads; i++)
+    {
+        if(started[i])
+        {
+#if defined(_WIN32)
+            WaitForSingleObject(handles[i], INFINITE);
+            CloseHandle(handles[i]);
+#else
+            pthread_join(handles[i], NULL);
+#endif
+        }
+        else work(&workers[i]);
+
+        ok &= workers[i].ok;
+    }
+
+    return ok;
+}
+
+#else
+
+bool tic_audio_render(const tic_audio_source* source, tic_audio_job* jobs, s32 count)
+{
+    Worker worker = {source, jobs, count, 0, 1, true};
+    work(&worker);
+    return worker.ok;
+}
+
+#endif
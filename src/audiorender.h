@@ -0,0 +1,50 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "ticapi.h"
+
+// renders music tracks and sfx offline, every job gets its own machine and the jobs run in parallel
+
+typedef struct
+{
+    bool sfx;           // the index is an sfx instead of a music track
+    s32 index;
+
+    // interleaved stereo samples allocated by the renderer, the caller frees them
+    s16* samples;
+    s32 count;          // stereo frames
+} tic_audio_job;
+
+typedef struct
+{
+    const tic_sfx* sfx;
+    const tic_music* music;
+    s32 samplerate;
+    bool sustain;
+    bool mute[TIC_SOUND_CHANNELS];  // music channels rendered silent
+} tic_audio_source;
+
+// returns false if any job ran out of memory, the finished ones keep their samples
+bool tic_audio_render(const tic_audio_source* source, tic_audio_job* jobs, s32 count);
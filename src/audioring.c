@@ -0,0 +1,100 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "audioring.h"
+
+#include <stdlib.h>
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+struct tic_audio_ring
+{
+    u32 mask;
+    volatile u32 write;     // only the pushing thread stores it
+    volatile u32 read;      // only the popping thread stores it
+    tic_sound_snapshot items[];
+};
+
+// the other thread sees the item before the index that publishes it
+#if defined(_MSC_VER)
+static inline u32 loadIndex(volatile u32* index) {return InterlockedCompareExchange((volatile LONG*)index, 0, 0);}
+static inline void storeIndex(volatile u32* index, u32 value) {InterlockedExchange((volatile LONG*)index, value);}
+#elif defined(__GNUC__) || defined(__clang__)
+static inline u32 loadIndex(volatile u32* index) {return __atomic_load_n(index, __ATOMIC_ACQUIRE);}
+static inline void storeIndex(volatile u32* index, u32 value) {__atomic_store_n(index, value, __ATOMIC_RELEASE);}
+#else
+static inline u32 loadIndex(volatile u32* index) {return *index;}
+static inline void storeIndex(volatile u32* index, u32 value) {*index = value;}
+#endif
+
+tic_audio_ring* tic_audio_ring_create(s32 capacity)
+{
+    u32 size = 1;
+
+    while(size < (u32)capacity)
+        size <<= 1;
+
+    tic_audio_ring* ring = calloc(1, sizeof(tic_audio_ring) + sizeof(tic_sound_snapshot) * size);
+
+    if(ring)
+        ring->mask = size - 1;
+
+    return ring;
+}
+
+void tic_audio_ring_delete(tic_audio_ring* ring)
+{
+    free(ring);
+}
+
+s32 tic_audio_ring_capacity(const tic_audio_ring* ring)
+{
+    return ring->mask + 1;
+}
+
+bool tic_audio_ring_push(tic_audio_ring* ring, const tic_sound_snapshot* snapshot)
+{
+    u32 write = ring->write;
+
+    if(write - loadIndex(&ring->read) > ring->mask)
+        return false;
+
+    ring->items[write & ring->mask] = *snapshot;
+    storeIndex(&ring->write, write + 1);
+
+    return true;
+}
+
+bool tic_audio_ring_pop(tic_audio_ring* ring, tic_sound_snapshot* snapshot)
+{
+    u32 read = ring->read;
+
+    if(read == loadIndex(&ring->write))
+        return false;
+
+    *snapshot = ring->items[read & ring->mask];
+    storeIndex(&ring->read, read + 1);
+
+    return true;
+}
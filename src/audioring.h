@@ -0,0 +1,45 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ticapi.h"
+
+// sound registers of every tick on their way from the script thread to the audio thread,
+// one thread pushes and the other one pops without any lock
+
+typedef struct
+{
+    tic_sound_register registers[TIC_SOUND_CHANNELS];
+    tic_stereo_volume stereo;
+} tic_sound_snapshot;
+
+typedef struct tic_audio_ring tic_audio_ring;
+
+// the capacity is rounded up to a power of two
+tic_audio_ring* tic_audio_ring_create(s32 capacity);
+void tic_audio_ring_delete(tic_audio_ring* ring);
+s32 tic_audio_ring_capacity(const tic_audio_ring* ring);
+
+// the push fails if the ring is full and the pop if it is empty
+bool tic_audio_ring_push(tic_audio_ring* ring, const tic_sound_snapshot* snapshot);
+bool tic_audio_ring_pop(tic_audio_ring* ring, tic_sound_snapshot* snapshot);
@@ -98,6 +98,23 @@ static void readConfigUiScale(Config* config, lua_State* lua)
     lua_pop(lua, 1);
 }
 
+static void readConfigAudio(Config* config, lua_State* lua)
+{
+    lua_getglobal(lua, "AUDIO_RING");
+
+    if(lua_isinteger(lua, -1))
+        config->data.audio.ring = (s32)lua_tointeger(lua, -1);
+
+    lua_pop(lua, 1);
+
+    lua_getglobal(lua, "AUDIO_BUFFER");
+
+    if(lua_isinteger(lua, -1))
+        config->data.audio.buffer = (s32)lua_tointeger(lua, -1);
+
+    lua_pop(lua, 1);
+}
+
 static void readConfigCrtShader(Config* config, lua_State* lua)
 {
     lua_getglobal(lua, "CRT_SHADER");
@@ -279,6 +296,7 @@ static void readConfig(Config* config)
             readConfigShowSync(config, lua);
             readConfigCrtMonitor(config, lua);
             readConfigUiScale(config, lua);
+            readConfigAudio(config, lua);
             readTheme(config, lua);
             readConfigCrtShader(config, lua);
         }
@@ -1566,6 +1566,22 @@ static void exportMusic(Console* console, s32 track)
     }
 }
 
+// every track or sfx is rendered in parallel and saved next to the cart instead of downloaded one by one
+static void exportAllAudio(Console* console, bool sfx)
+{
+    s32 saved = studioExportAllAudio(sfx);
+
+    if(saved >= 0)
+    {
+        char buf[STUDIO_TEXT_BUFFER_WIDTH];
+        sprintf(buf, "\n%i %s saved to the current folder", saved, sfx ? "sfx" : "tracks");
+        printBack(console, buf);
+    }
+    else printError(console, sfx ? "\nsfx exporting error :(" : "\nmusic exporting error :(");
+
+    commandDone(console);
+}
+
 static void exportSprites(Console* console)
 {
     enum
@@ -1986,6 +2002,10 @@ static void onConsoleExportCommand(Console* console, const char* param)
         {
             exportSfx(console, 0);
         }
+        else if(strcmp(param, "sfx all") == 0)
+        {
+            exportAllAudio(console, true);
+        }
         else if(memcmp(param, "sfx ", sizeof "sfx") == 0)
         {
             s32 sfx = atoi(param + sizeof "sfx");
@@ -1998,6 +2018,10 @@ static void onConsoleExportCommand(Console* console, const char* param)
         {
             exportMusic(console, 0);
         }
+        else if(strcmp(param, "music all") == 0)
+        {
+            exportAllAudio(console, false);
+        }
         else if(memcmp(param, "music ", sizeof "music") == 0)
         {
             s32 track = atoi(param + sizeof "music");
@@ -2374,6 +2398,226 @@ static void onConsoleVRamCommand(Console* console, const char* param)
     commandDone(console);
 }
 
+static int compareFrameTime(const void* a, const void* b)
+{
+    double left = *(const double*)a, right = *(const double*)b;
+    return left < right ? -1 : left > right;
+}
+
+static void printProfileInfo(Console* console, const char* name, double* times, s32 count)
+{
+    qsort(times, count, sizeof times[0], compareFrameTime);
+
+    char buf[STUDIO_TEXT_BUFFER_WIDTH];
+    sprintf(buf, "\n| %-7s | %6.2f | %6.2f | %6.2f |", name, 
+        times[(count - 1) * 50 / 100], times[(count - 1) * 90 / 100], times[(count - 1) * 99 / 100]);
+    printTable(console, buf);
+}
+
+static void printProfileStats(Console* console)
+{
+    const tic_profile* profile = &console->tic->profile;
+
+    static const char* Labels[] =
+    {
+#define PROFILE_PHASE_DEF(_, label) label,
+        TIC_PROFILE_LIST(PROFILE_PHASE_DEF)
+#undef PROFILE_PHASE_DEF
+    };
+
+    // only the frames where the cart was running
+    u32 frames[TIC_PROFILE_FRAMES];
+    s32 count = 0;
+
+    for(u32 i = 1; i < TIC_PROFILE_FRAMES && i <= profile->frame; i++)
+    {
+        u32 frame = (profile->frame - i) % TIC_PROFILE_FRAMES;
+        if(profile->frames[frame][tic_profile_tick])
+            frames[count++] = frame;
+    }
+
+    if(count == 0)
+    {
+        printError(console, "\nno frames profiled, type 'profile' and run the cart");
+        return;
+    }
+
+    printLine(console);
+
+    printTable(console, "\n+------------------------------------+" \
+                        "\n|     FRAME TIME (MS) PERCENTILES    |" \
+                        "\n+---------+--------+--------+--------+" \
+                        "\n| PHASE   |  P50   |  P90   |  P99   |" \
+                        "\n+---------+--------+--------+--------+");
+
+    double times[TIC_PROFILE_FRAMES];
+
+    for(s32 p = 0; p < tic_profile_phases; p++)
+    {
+        for(s32 i = 0; i < count; i++)
+            times[i] = profile->frames[frames[i]][p] * 1000.0 / profile->freq;
+
+        printProfileInfo(console, Labels[p], times, count);
+    }
+
+    for(s32 i = 0; i < count; i++)
+    {
+        u64 total = 0;
+        for(s32 p = 0; p < tic_profile_phases; p++)
+            total += profile->frames[frames[i]][p];
+
+        times[i] = total * 1000.0 / profile->freq;
+    }
+
+    printTable(console, "\n+---------+--------+--------+--------+");
+    printProfileInfo(console, "TOTAL", times, count);
+    printTable(console, "\n+---------+--------+--------+--------+");
+
+    char buf[STUDIO_TEXT_BUFFER_WIDTH];
+    sprintf(buf, "\n%i frames", count);
+    printBack(console, buf);
+}
+
+static void onConsoleProfileCommand(Console* console, const char* param)
+{
+    if(param == NULL)
+    {
+        showProfiler(!isProfilerShown());
+        printBack(console, isProfilerShown() 
+            ? "\nprofiler is on, F10 to toggle" 
+            : "\nprofiler is off");
+    }
+    else if(strcmp(param, "stats") == 0)
+        printProfileStats(console);
+    else printError(console, "\nusage: profile [stats]");
+
+    commandDone(console);
+}
+
+static void onConsoleOverdrawCommand(Console* console, const char* param)
+{
+    if(param == NULL)
+    {
+        showOverdraw(!isOverdrawShown());
+        printBack(console, isOverdrawShown() 
+            ? "\noverdraw view is on while the cart runs, F12 to toggle" 
+            : "\noverdraw view is off");
+    }
+    else if(strcmp(param, "stats") == 0)
+    {
+        const tic_overdraw* overdraw = &console->tic->overdraw;
+
+        if(overdraw->covered)
+        {
+            char buf[STUDIO_TEXT_BUFFER_WIDTH];
+            sprintf(buf, "\npixels written %u, %.2f per covered pixel", 
+                overdraw->pixels, (double)overdraw->pixels / overdraw->covered);
+            printBack(console, buf);
+            sprintf(buf, "\ncovered %u of %i, peak %u, tiles %u", 
+                overdraw->covered, TIC80_WIDTH * TIC80_HEIGHT, overdraw->peak, overdraw->tiles);
+            printBack(console, buf);
+        }
+        else printError(console, "\nno frames counted, type 'overdraw' and run the cart");
+    }
+    else printError(console, "\nusage: overdraw [stats]");
+
+    commandDone(console);
+}
+
+// Chrome trace event format, opens in chrome://tracing and Perfetto
+static bool saveTrace(const char* path, const tic_profile* profile)
+{
+    FILE* file = fopen(path, "w");
+
+    if(!file) return false;
+
+    static const char* Phases[] =
+    {
+#define PROFILE_PHASE_DEF(_, label) label,
+        TIC_PROFILE_LIST(PROFILE_PHASE_DEF)
+#undef PROFILE_PHASE_DEF
+    };
+
+    static const char* ApiNames[] =
+    {
+#define API_NAME_DEF(name, ...) #name,
+        TIC_API_LIST(API_NAME_DEF)
+#undef API_NAME_DEF
+    };
+
+    const tic_trace_event* events = profile->trace.events;
+    s32 count = profile->trace.count;
+
+    u64 origin = count ? events[0].start : 0;
+    for(s32 i = 1; i < count; i++)
+        origin = MIN(origin, events[i].start);
+
+    fprintf(file, "{\"traceEvents\":[");
+
+    for(s32 i = 0; i < count; i++)
+    {
+        const tic_trace_event* event = &events[i];
+        double ts = (event->start - origin) * 1000000.0 / profile->freq;
+        double dur = event->duration * 1000000.0 / profile->freq;
+
+        fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1", 
+            i ? "," : "", 
+            event->lang ? ApiNames[event->id] : Phases[event->id], 
+            event->lang ? "api" : "frame", ts, dur);
+
+        if(event->lang)
+            fprintf(file, ",\"args\":{\"lang\":\"%s\"}", event->lang);
+
+        fprintf(file, "}");
+    }
+
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+
+    return true;
+}
+
+static void onConsoleTraceCommand(Console* console, const char* param)
+{
+    const tic_profile* profile = &console->tic->profile;
+
+    if(param && (strcmp(param, "start") == 0 || strcmp(param, "start api") == 0))
+    {
+        bool api = strcmp(param, "start api") == 0;
+        startTrace(api);
+
+        printBack(console, api 
+            ? "\ntrace started, API calls are recorded\nfrom the next run" 
+            : "\ntrace started");
+    }
+    else if(param && strncmp(param, "stop", 4) == 0 && (param[4] == '\0' || param[4] == ' '))
+    {
+        if(profile->trace.active)
+        {
+            const char* name = param[4] ? param + 5 : "trace.json";
+            stopTrace();
+
+            if(saveTrace(fsGetFilePath(console->fs, name), profile))
+            {
+                char buf[STUDIO_TEXT_BUFFER_WIDTH * 2];
+                snprintf(buf, sizeof buf, "\n%s saved, %i events", name, profile->trace.count);
+                printBack(console, buf);
+
+                if(profile->trace.dropped)
+                {
+                    snprintf(buf, sizeof buf, "\n%i events dropped, buffer is full", profile->trace.dropped);
+                    printError(console, buf);
+                }
+            }
+            else printError(console, "\ntrace saving error :(");
+        }
+        else printError(console, "\ntrace is not started");
+    }
+    else printError(console, "\nusage: trace start [api] | stop [file]");
+
+    commandDone(console);
+}
+
 static const struct
 {
     const char* command;
@@ -2389,6 +2633,9 @@ static const struct
 #endif
     {"ram",     NULL, "show 80K RAM layout",        onConsoleRamCommand},
     {"vram",    NULL, "show 16K VRAM layout",       onConsoleVRamCommand},
+    {"profile", NULL, "show frame profiler",        onConsoleProfileCommand},
+    {"overdraw", NULL, "show pixel overdraw",       onConsoleOverdrawCommand},
+    {"trace",   NULL, "record trace.json",          onConsoleTraceCommand},
     {"exit",    "quit", "exit the application",     onConsoleExitCommand},
     {"new",     NULL, "create new cart",            onConsoleNewCommand},
     {"load",    NULL, "load cart",                  onConsoleLoadCommand},
@@ -3100,6 +3347,25 @@ static bool checkUIScale(Console* console, const char* param, const char* value)
     return done;
 }
 
+static bool checkAudio(Console* console, const char* param, const char* value)
+{
+    bool done = false;
+    s32 size = atoi(value);
+
+    if(strcmp(param, "-audioring") == 0 && size >= 0)
+    {
+        console->config->data.audio.ring = size;
+        done = true;
+    }
+    else if(strcmp(param, "-audiobuffer") == 0 && size > 0)
+    {
+        console->config->data.audio.buffer = size;
+        done = true;
+    }
+
+    return done;
+}
+
 static bool checkCommand(Console* console, const char* argument)
 {
     char* command = alloca(strlen(argument));
@@ -3227,7 +3493,8 @@ void initConsole(Console* console, tic_mem* tic, FileSystem* fs, Config* config,
                 if(cmdInjectCode(console, first, second)
                     || cmdInjectSprites(console, first, second)
                     || cmdInjectMap(console, first, second)
-                    || checkUIScale(console, first, second))
+                    || checkUIScale(console, first, second)
+                    || checkAudio(console, first, second))
                     argp |= mask;
             }
         }
@@ -3257,6 +3524,9 @@ void initConsole(Console* console, tic_mem* tic, FileSystem* fs, Config* config,
                 else if(strcmp(arg, "-crt-monitor") == 0)
                     console->crtMonitor = true;
 
+                else if(strcmp(arg, "-drawthread") == 0)
+                    tic_core_draw_thread(console->tic, true);
+
                 else continue;
 
                 argp |= 0b1 << i;
@@ -0,0 +1,343 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "drawlist.h"
+
+#include <stdlib.h>
+
+#if defined(TIC80_THREADS)
+
+#if defined(_WIN32)
+#include <windows.h>
+#define THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#define THREAD_LOCAL __thread
+#endif
+
+enum
+{
+    Capacity = 4096,    // commands in the ring, a power of two
+    Batch = 64,         // commands recorded before the worker is woken up
+};
+
+struct tic_drawlist
+{
+    tic_mem* memory;
+    tic_draw_command items[Capacity];
+
+    // only the script thread writes these
+    u32 write;
+    u32 published;
+    u32 seen;           // done as it was when the script thread took the lock last time
+    bool recording;
+    bool pending;       // something was recorded since the last flush
+
+    // guarded by the lock
+    u32 done;
+    bool quit;
+
+#if defined(_WIN32)
+    HANDLE thread;
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE ready;
+    CONDITION_VARIABLE drained;
+#else
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_cond_t drained;
+#endif
+};
+
+static THREAD_LOCAL bool Worker = false;
+
+#if defined(_WIN32)
+
+static inline void lockList(tic_drawlist* list) {EnterCriticalSection(&list->lock);}
+static inline void unlockList(tic_drawlist* list) {LeaveCriticalSection(&list->lock);}
+static inline void waitReady(tic_drawlist* list) {SleepConditionVariableCS(&list->ready, &list->lock, INFINITE);}
+static inline void waitDrained(tic_drawlist* list) {SleepConditionVariableCS(&list->drained, &list->lock, INFINITE);}
+static inline void signalReady(tic_drawlist* list) {WakeConditionVariable(&list->ready);}
+static inline void signalDrained(tic_drawlist* list) {WakeConditionVariable(&list->drained);}
+
+#else
+
+static inline void lockList(tic_drawlist* list) {pthread_mutex_lock(&list->lock);}
+static inline void unlockList(tic_drawlist* list) {pthread_mutex_unlock(&list->lock);}
+static inline void waitReady(tic_drawlist* list) {pthread_cond_wait(&list->ready, &list->lock);}
+static inline void waitDrained(tic_drawlist* list) {pthread_cond_wait(&list->drained, &list->lock);}
+static inline void signalReady(tic_drawlist* list) {pthread_cond_signal(&list->ready);}
+static inline void signalDrained(tic_drawlist* list) {pthread_cond_signal(&list->drained);}
+
+#endif
+
+static void draw(tic_mem* memory, const tic_draw_command* cmd)
+{
+    switch(cmd->type)
+    {
+    case tic_draw_cls:
+        tic_api_cls(memory, cmd->cls.color);
+        break;
+    case tic_draw_pix:
+        tic_api_pix(memory, cmd->pix.x, cmd->pix.y, cmd->pix.color, false);
+        break;
+    case tic_draw_line:
+        tic_api_line(memory, cmd->line.x1, cmd->line.y1, cmd->line.x2, cmd->line.y2, cmd->line.color);
+        break;
+    case tic_draw_rect:
+        tic_api_rect(memory, cmd->rect.x, cmd->rect.y, cmd->rect.width, cmd->rect.height, cmd->rect.color);
+        break;
+    case tic_draw_rectb:
+        tic_api_rectb(memory, cmd->rect.x, cmd->rect.y, cmd->rect.width, cmd->rect.height, cmd->rect.color);
+        break;
+    case tic_draw_clip:
+        tic_api_clip(memory, cmd->rect.x, cmd->rect.y, cmd->rect.width, cmd->rect.height);
+        break;
+    case tic_draw_circ:
+        tic_api_circ(memory, cmd->circ.x, cmd->circ.y, cmd->circ.radius, cmd->circ.color);
+        break;
+    case tic_draw_circb:
+        tic_api_circb(memory, cmd->circ.x, cmd->circ.y, cmd->circ.radius, cmd->circ.color);
+        break;
+    case tic_draw_tri:
+        tic_api_tri(memory, cmd->tri.x1, cmd->tri.y1, cmd->tri.x2, cmd->tri.y2, cmd->tri.x3, cmd->tri.y3, cmd->tri.color);
+        break;
+    case tic_draw_target:
+        tic_api_target(memory, cmd->target.index);
+        break;
+    case tic_draw_spr:
+        {
+            const tic_draw_colors* colors = &cmd->spr.colors;
+            tic_api_spr(memory, cmd->spr.index, cmd->spr.x, cmd->spr.y, cmd->spr.w, cmd->spr.h,
+                (u8*)colors->data, colors->count, cmd->spr.scale, cmd->spr.flip, cmd->spr.rotate);
+        }
+        break;
+    case tic_draw_map:
+        {
+            const tic_draw_colors* colors = &cmd->map.colors;
+            tic_api_map(memory, cmd->map.x, cmd->map.y, cmd->map.width, cmd->map.height, cmd->map.sx, cmd->map.sy,
+                (u8*)colors->data, colors->count, cmd->map.scale, NULL, NULL);
+        }
+        break;
+    case tic_draw_textri:
+        {
+            const tic_draw_colors* colors = &cmd->textri.colors;
+            tic_api_textri(memory, cmd->textri.x1, cmd->textri.y1, cmd->textri.x2, cmd->textri.y2, cmd->textri.x3, cmd->textri.y3,
+                cmd->textri.u1, cmd->textri.v1, cmd->textri.u2, cmd->textri.v2, cmd->textri.u3, cmd->textri.v3,
+                cmd->textri.use_map, (u8*)colors->data, colors->count, cmd->textri.z1, cmd->textri.z2, cmd->textri.z3, cmd->textri.depth);
+        }
+        break;
+    case tic_draw_blit:
+        {
+            const tic_draw_colors* colors = &cmd->blit.colors;
+            tic_api_blit(memory, cmd->blit.src, cmd->blit.x, cmd->blit.y, (u8*)colors->data, colors->count,
+                cmd->blit.dst, cmd->blit.remap ? cmd->blit.map : NULL);
+        }
+        break;
+    case tic_draw_print:
+        tic_api_print(memory, cmd->text.text, cmd->text.x, cmd->text.y, cmd->text.color, cmd->text.fixed, cmd->text.scale, cmd->text.alt);
+        break;
+    case tic_draw_font:
+        tic_api_font(memory, cmd->text.text, cmd->text.x, cmd->text.y, cmd->text.color, cmd->text.w, cmd->text.h, cmd->text.fixed, cmd->text.scale, cmd->text.alt);
+        break;
+    }
+}
+
+static void work(tic_drawlist* list)
+{
+    Worker = true;
+
+    lockList(list);
+
+    for(;;)
+    {
+        while(list->done == list->published && !list->quit)
+            waitReady(list);
+
+        if(list->done == list->published) break;
+
+        u32 start = list->done, end = list->published;
+        unlockList(list);
+
+        for(u32 i = start; i != end; i++)
+            draw(list->memory, &list->items[i % Capacity]);
+
+        lockList(list);
+        list->done = end;
+        signalDrained(list);
+    }
+
+    unlockList(list);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI workThread(LPVOID data) {work(data); return 0;}
+#else
+static void* workThread(void* data) {work(data); return NULL;}
+#endif
+
+static void publish(tic_drawlist* list)
+{
+    lockList(list);
+    list->published = list->write;
+    list->seen = list->done;
+    signalReady(list);
+    unlockList(list);
+}
+
+tic_drawlist* tic_drawlist_create(tic_mem* memory)
+{
+    tic_drawlist* list = calloc(1, sizeof(tic_drawlist));
+
+    if(list)
+    {
+        list->memory = memory;
+
+#if defined(_WIN32)
+        InitializeCriticalSection(&list->lock);
+        InitializeConditionVariable(&list->ready);
+        InitializeConditionVariable(&list->drained);
+
+        list->thread = CreateThread(NULL, 0, workThread, list, 0, NULL);
+
+        if(!list->thread)
+        {
+            DeleteCriticalSection(&list->lock);
+            free(list);
+            list = NULL;
+        }
+#else
+        pthread_mutex_init(&list->lock, NULL);
+        pthread_cond_init(&list->ready, NULL);
+        pthread_cond_init(&list->drained, NULL);
+
+        if(pthread_create(&list->thread, NULL, workThread, list) != 0)
+        {
+            pthread_cond_destroy(&list->drained);
+            pthread_cond_destroy(&list->ready);
+            pthread_mutex_destroy(&list->lock);
+            free(list);
+            list = NULL;
+        }
+#endif
+    }
+
+    return list;
+}
+
+void tic_drawlist_delete(tic_drawlist* list)
+{
+    if(!list) return;
+
+    lockList(list);
+    list->published = list->write;
+    list->quit = true;
+    signalReady(list);
+    unlockList(list);
+
+#if defined(_WIN32)
+    WaitForSingleObject(list->thread, INFINITE);
+    CloseHandle(list->thread);
+    DeleteCriticalSection(&list->lock);
+#else
+    pthread_join(list->thread, NULL);
+    pthread_cond_destroy(&list->drained);
+    pthread_cond_destroy(&list->ready);
+    pthread_mutex_destroy(&list->lock);
+#endif
+
+    free(list);
+}
+
+void tic_drawlist_begin(tic_drawlist* list)
+{
+    if(list) list->recording = true;
+}
+
+void tic_drawlist_end(tic_drawlist* list)
+{
+    if(!list) return;
+
+    list->recording = false;
+
+    if(list->pending && list->published != list->write)
+        publish(list);
+}
+
+bool tic_drawlist_recording(const tic_drawlist* list)
+{
+    return list && list->recording && !Worker;
+}
+
+void tic_drawlist_push(tic_drawlist* list, const tic_draw_command* command)
+{
+    // the ring is full, the worker has to free some room
+    if(list->write - list->seen == Capacity)
+    {
+        lockList(list);
+        list->published = list->write;
+        signalReady(list);
+
+        while(list->write - list->done == Capacity)
+            waitDrained(list);
+
+        list->seen = list->done;
+        unlockList(list);
+    }
+
+    list->items[list->write % Capacity] = *command;
+    list->write++;
+    list->pending = true;
+
+    if(list->write - list->published >= Batch)
+        publish(list);
+}
+
+void tic_drawlist_flush(tic_drawlist* list)
+{
+    if(!list || Worker || !list->pending) return;
+
+    lockList(list);
+    list->published = list->write;
+    signalReady(list);
+
+    while(list->done != list->write)
+        waitDrained(list);
+
+    list->seen = list->done;
+    unlockList(list);
+
+    list->pending = false;
+}
+
+#else
+
+tic_drawlist* tic_drawlist_create(tic_mem* memory) {return NULL;}
+void tic_drawlist_delete(tic_drawlist* list) {}
+void tic_drawlist_begin(tic_drawlist* list) {}
+void tic_drawlist_end(tic_drawlist* list) {}
+bool tic_drawlist_recording(const tic_drawlist* list) {return false;}
+void tic_drawlist_push(tic_drawlist* list, const tic_draw_command* command) {}
+void tic_drawlist_flush(tic_drawlist* list) {}
+
+#endif
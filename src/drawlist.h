@@ -0,0 +1,93 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ticapi.h"
+
+// draw calls made by TIC() are recorded here and rasterized by a worker thread,
+// the script thread waits for the worker before anything reads or writes the RAM
+
+#define TIC_DRAW_TEXT_SIZE 64
+
+typedef enum
+{
+    tic_draw_cls,
+    tic_draw_pix,
+    tic_draw_line,
+    tic_draw_rect,
+    tic_draw_rectb,
+    tic_draw_spr,
+    tic_draw_map,
+    tic_draw_circ,
+    tic_draw_circb,
+    tic_draw_tri,
+    tic_draw_textri,
+    tic_draw_clip,
+    tic_draw_target,
+    tic_draw_blit,
+    tic_draw_print,
+    tic_draw_font,
+} tic_draw_type;
+
+typedef struct
+{
+    u8 data[TIC_PALETTE_SIZE];
+    s32 count;
+} tic_draw_colors;
+
+typedef struct
+{
+    tic_draw_type type;
+
+    union
+    {
+        struct {u8 color;} cls;
+        struct {s32 x, y; u8 color;} pix;
+        struct {s32 x1, y1, x2, y2; u8 color;} line;
+        struct {s32 x, y, width, height; u8 color;} rect;   // rect, rectb and clip
+        struct {s32 x, y, radius; u8 color;} circ;          // circ and circb
+        struct {s32 x1, y1, x2, y2, x3, y3; u8 color;} tri;
+        struct {s32 index;} target;
+        struct {s32 index, x, y, w, h, scale; tic_flip flip; tic_rotate rotate; tic_draw_colors colors;} spr;
+        struct {s32 x, y, width, height, sx, sy, scale; tic_draw_colors colors;} map;
+        struct {float x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, z1, z2, z3; bool use_map, depth; tic_draw_colors colors;} textri;
+        struct {s32 src, x, y, dst; bool remap; u8 map[TIC_PALETTE_SIZE]; tic_draw_colors colors;} blit;
+        struct {char text[TIC_DRAW_TEXT_SIZE]; s32 x, y, w, h, scale; u8 color; bool fixed, alt;} text;
+    };
+} tic_draw_command;
+
+typedef struct tic_drawlist tic_drawlist;
+
+// NULL if the build has no threads
+tic_drawlist* tic_drawlist_create(tic_mem* memory);
+void tic_drawlist_delete(tic_drawlist* list);
+
+void tic_drawlist_begin(tic_drawlist* list);
+void tic_drawlist_end(tic_drawlist* list);
+
+// true if the calling thread records instead of drawing
+bool tic_drawlist_recording(const tic_drawlist* list);
+void tic_drawlist_push(tic_drawlist* list, const tic_draw_command* command);
+
+// waits until the worker has drawn everything recorded, does nothing on the worker itself
+void tic_drawlist_flush(tic_drawlist* list);
@@ -143,9 +143,75 @@ static duk_ret_t duk_rectb(duk_context* duk)
     return 0;
 }
 
+static duk_ret_t duk_target(duk_context* duk)
+{
+    tic_mem* tic = (tic_mem*)getDukMachine(duk);
+    tic_api_target(tic, duk_opt_int(duk, 0, -1));
+
+    return 0;
+}
+
+// reads a number or an array of up to 16 numbers
+static s32 getDukColors(duk_context* duk, duk_idx_t index, u8* colors)
+{
+    s32 count = 0;
+
+    if(duk_is_array(duk, index))
+    {
+        for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+        {
+            duk_get_prop_index(duk, index, i);
+            bool valid = !duk_is_null_or_undefined(duk, -1);
+            if(valid) colors[count++] = duk_to_int(duk, -1);
+            duk_pop(duk);
+            if(!valid) break;
+        }
+    }
+    else if(!duk_is_null_or_undefined(duk, index))
+        colors[count++] = duk_to_int(duk, index);
+
+    return count;
+}
+
+static duk_ret_t duk_blit(duk_context* duk)
+{
+    s32 src = duk_to_int(duk, 0);
+    s32 x = duk_opt_int(duk, 1, 0);
+    s32 y = duk_opt_int(duk, 2, 0);
+    u8 colors[TIC_PALETTE_SIZE];
+    s32 count = getDukColors(duk, 3, colors);
+    s32 dst = duk_opt_int(duk, 4, -1);
+    u8 remap[TIC_PALETTE_SIZE];
+    bool hasRemap = duk_is_array(duk, 5);
+
+    if(hasRemap)
+        for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+        {
+            duk_get_prop_index(duk, 5, i);
+            remap[i] = duk_is_number(duk, -1) ? duk_to_int(duk, -1) : i;
+            duk_pop(duk);
+        }
+
+    tic_mem* tic = (tic_mem*)getDukMachine(duk);
+    tic_api_blit(tic, src, x, y, colors, count, dst, hasRemap ? remap : NULL);
+
+    return 0;
+}
+
+static duk_ret_t duk_oam(duk_context* duk)
+{
+    s32 address = duk_to_int(duk, 0);
+    s32 count = duk_to_int(duk, 1);
+
+    tic_mem* tic = (tic_mem*)getDukMachine(duk);
+    tic_api_oam(tic, address, count);
+
+    return 0;
+}
+
 static duk_ret_t duk_spr(duk_context* duk)
 {
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     s32 index = duk_opt_int(duk, 0, 0);
@@ -393,6 +459,45 @@ static void remapCallback(void* data, s32 x, s32 y, RemapResult* result)
     duk_pop(duk);
 }
 
+// remap(cells) gets [id, x, y, id, x, y, ...] for all the visible cells
+// and returns [id, flip, rotate, ...] in the same order
+static void remapBatchCallback(void* data, RemapCell* cells, s32 count)
+{
+    RemapData* remap = (RemapData*)data;
+    duk_context* duk = remap->duk;
+
+    duk_push_heapptr(duk, remap->remap);
+    duk_idx_t idx = duk_push_array(duk);
+
+    for(s32 i = 0; i < count; i++)
+    {
+        duk_push_int(duk, cells[i].result.index);
+        duk_put_prop_index(duk, idx, i * 3 + 0);
+        duk_push_int(duk, cells[i].x);
+        duk_put_prop_index(duk, idx, i * 3 + 1);
+        duk_push_int(duk, cells[i].y);
+        duk_put_prop_index(duk, idx, i * 3 + 2);
+    }
+
+    if(duk_pcall(duk, 1) == DUK_EXEC_SUCCESS && duk_is_array(duk, -1))
+    {
+        for(s32 i = 0; i < count; i++)
+        {
+            RemapResult* result = &cells[i].result;
+
+            duk_get_prop_index(duk, -1, i * 3 + 0);
+            result->index = duk_to_int(duk, -1);
+            duk_get_prop_index(duk, -2, i * 3 + 1);
+            result->flip = duk_to_int(duk, -1);
+            duk_get_prop_index(duk, -3, i * 3 + 2);
+            result->rotate = duk_to_int(duk, -1);
+            duk_pop_3(duk);
+        }
+    }
+
+    duk_pop(duk);
+}
+
 static duk_ret_t duk_map(duk_context* duk)
 {
     s32 x = duk_opt_int(duk, 0, 0);
@@ -403,7 +508,7 @@ static duk_ret_t duk_map(duk_context* duk)
     s32 sy = duk_opt_int(duk, 5, 0);
     s32 scale = duk_opt_int(duk, 7, 1);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     {
@@ -445,7 +550,10 @@ static duk_ret_t duk_map(duk_context* duk)
 
         RemapData data = {duk, remap};
 
-        tic_api_map((tic_mem*)getDukMachine(duk), x, y, w, h, sx, sy, colors, count, scale, remapCallback, &data);
+        if(duk_to_boolean(duk, 9))
+            tic_core_map_batch(tic, x, y, w, h, sx, sy, colors, count, scale, remapBatchCallback, &data);
+        else
+            tic_api_map(tic, x, y, w, h, sx, sy, colors, count, scale, remapCallback, &data);
     }
 
     return 0;
@@ -516,6 +624,77 @@ static duk_ret_t duk_poke4(duk_context* duk)
     return 0;
 }
 
+typedef void(*PeekBuffer)(tic_mem*, s32 address, u8* buffer, s32 size);
+typedef void(*PokeBuffer)(tic_mem*, s32 address, const u8* buffer, s32 size);
+
+// returns the range as a Uint8Array
+static duk_ret_t peekDukBuffer(duk_context* duk, PeekBuffer peek, s32 limit)
+{
+    s32 address = duk_to_int(duk, 0);
+    s32 size = duk_to_int(duk, 1);
+
+    if(size < 0 || size > limit)
+        return duk_error(duk, DUK_ERR_RANGE_ERROR, "invalid buffer size\n");
+
+    tic_mem* tic = (tic_mem*)getDukMachine(duk);
+    peek(tic, address, duk_push_fixed_buffer(duk, size), size);
+    duk_push_buffer_object(duk, -1, 0, size, DUK_BUFOBJ_UINT8ARRAY);
+
+    return 1;
+}
+
+// accepts a typed array, an ArrayBuffer or an array of numbers
+static duk_ret_t pokeDukBuffer(duk_context* duk, PokeBuffer poke, s32 limit)
+{
+    s32 address = duk_to_int(duk, 0);
+    tic_mem* tic = (tic_mem*)getDukMachine(duk);
+
+    if(duk_is_buffer_data(duk, 1))
+    {
+        duk_size_t size = 0;
+        const u8* data = duk_get_buffer_data(duk, 1, &size);
+
+        poke(tic, address, data, (s32)MIN(size, (duk_size_t)limit));
+    }
+    else if(duk_is_array(duk, 1))
+    {
+        s32 size = (s32)MIN(duk_get_length(duk, 1), (duk_size_t)limit);
+        u8* data = duk_push_fixed_buffer(duk, size);
+
+        for(s32 i = 0; i < size; i++)
+        {
+            duk_get_prop_index(duk, 1, i);
+            data[i] = duk_to_int(duk, -1);
+            duk_pop(duk);
+        }
+
+        poke(tic, address, data, size);
+    }
+    else return duk_error(duk, DUK_ERR_TYPE_ERROR, "invalid buffer, use a typed array or an array\n");
+
+    return 0;
+}
+
+static duk_ret_t duk_peekbuf(duk_context* duk)
+{
+    return peekDukBuffer(duk, tic_api_peekbuf, sizeof(tic_ram));
+}
+
+static duk_ret_t duk_pokebuf(duk_context* duk)
+{
+    return pokeDukBuffer(duk, tic_api_pokebuf, sizeof(tic_ram));
+}
+
+static duk_ret_t duk_peek4buf(duk_context* duk)
+{
+    return peekDukBuffer(duk, tic_api_peek4buf, sizeof(tic_ram) * 2);
+}
+
+static duk_ret_t duk_poke4buf(duk_context* duk)
+{
+    return pokeDukBuffer(duk, tic_api_poke4buf, sizeof(tic_ram) * 2);
+}
+
 static duk_ret_t duk_memcpy(duk_context* duk)
 {
     s32 dest = duk_to_int(duk, 0);
@@ -708,7 +887,7 @@ static duk_ret_t duk_textri(duk_context* duk)
     tic_mem* tic = (tic_mem*)getDukMachine(duk);
     bool use_map = duk_opt_boolean(duk, 12, false);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
     {
         if(!duk_is_null_or_undefined(duk, 13))
@@ -739,6 +918,13 @@ static duk_ret_t duk_textri(duk_context* duk)
         }
     }
 
+    float z[3] = {0};
+    bool depth = !duk_is_null_or_undefined(duk, 16);
+
+    if(depth)
+        for(s32 i = 0; i < COUNT_OF(z); i++)
+            z[i] = (float)duk_to_number(duk, i + 14);
+
     tic_api_textri(tic, pt[0], pt[1],   //  xy 1
                         pt[2], pt[3],   //  xy 2
                         pt[4], pt[5],   //  xy 3
@@ -746,7 +932,8 @@ static duk_ret_t duk_textri(duk_context* duk)
                         pt[8], pt[9],   //  uv 2
                         pt[10], pt[11],//  uv 3
                         use_map, // usemap
-                        colors, count);    //  chroma
+                        colors, count,    //  chroma
+                        z[0], z[1], z[2], depth);
 
     return 0;
 }
@@ -766,6 +953,39 @@ static duk_ret_t duk_clip(duk_context* duk)
     return 0;
 }
 
+static duk_ret_t duk_raster(duk_context* duk)
+{
+    tic_mem* tic = (tic_mem*)getDukMachine(duk);
+
+    // missing arguments come as undefined, null is taken the same way
+    if(duk_is_null_or_undefined(duk, 0))
+        tic_api_raster(tic, -1, 0, -1, -1, 0);
+    else
+    {
+        // missing fields leave the row as it is
+        s32 row = duk_to_int(duk, 0);
+        s32 x = duk_is_null_or_undefined(duk, 1) ? TIC_RASTER_KEEP : duk_to_int(duk, 1);
+        s32 border = duk_is_null_or_undefined(duk, 2) ? TIC_RASTER_KEEP : duk_to_int(duk, 2);
+        s32 color = duk_is_null_or_undefined(duk, 3) ? -1 : duk_to_int(duk, 3);
+        u32 rgb = duk_is_null_or_undefined(duk, 4) ? 0 : duk_to_uint(duk, 4);
+
+        tic_api_raster(tic, row, x, border, color, rgb);
+    }
+
+    return 0;
+}
+
+static duk_ret_t duk_rasterbuf(duk_context* duk)
+{
+    s32 address = duk_to_int(duk, 0);
+    s32 count = duk_to_int(duk, 1);
+
+    tic_mem* tic = (tic_mem*)getDukMachine(duk);
+    tic_api_rasterbuf(tic, address, count);
+
+    return 0;
+}
+
 static duk_ret_t duk_music(duk_context* duk)
 {
     tic_mem* tic = (tic_mem*)getDukMachine(duk);
@@ -838,14 +1058,36 @@ static duk_ret_t duk_fset(duk_context* duk)
     return 0;
 }
 
-static u64 ForceExitCounter = 0;
-
 s32 duk_timeout_check(void* udata)
 {
     tic_machine* machine = (tic_machine*)udata;
     tic_tick_data* tick = machine->data;
 
-    return ForceExitCounter++ > 1000 ? tick->forceExit && tick->forceExit(tick->data) : false;
+    return machine->forceExitCounter++ > 1000 ? tick->forceExit && tick->forceExit(tick->data) : false;
+}
+
+// API functions recording trace spans, registered instead of the plain ones while tracing
+#define API_TRACE_DEF(name, ...)                                    \
+    static duk_ret_t duk_trace_ ## name(duk_context* duk)           \
+    {                                                               \
+        tic_mem* tic = (tic_mem*)getDukMachine(duk);                \
+        u64 start = tic_core_trace_begin(tic);                      \
+        duk_ret_t res = duk_ ## name(duk);                          \
+        tic_core_trace_end(tic, tic_api_index_ ## name, start);     \
+        return res;                                                 \
+    }
+TIC_API_LIST(API_TRACE_DEF)
+#undef API_TRACE_DEF
+
+// Math.random on the generator of the machine, 53 random bits like the builtin one
+static duk_ret_t duk_random(duk_context* duk)
+{
+    tic_mem* tic = (tic_mem*)getDukMachine(duk);
+    u64 bits = ((u64)tic_core_random(tic) << 21) ^ (tic_core_random(tic) >> 11);
+
+    duk_push_number(duk, bits / 9007199254740992.0);
+
+    return 1;
 }
 
 static void initDuktape(tic_machine* machine)
@@ -861,15 +1103,46 @@ static void initDuktape(tic_machine* machine)
         duk_pop(duk);
     }
 
-#define API_FUNC_DEF(name, paramsCount, ...) {duk_ ## name, paramsCount, #name},
-    static const struct{duk_c_function func; s32 params; const char* name;} ApiItems[] = {TIC_API_LIST(API_FUNC_DEF)};
+#define API_FUNC_DEF(name, paramsCount, ...) {duk_ ## name, duk_trace_ ## name, paramsCount, #name},
+    static const struct{duk_c_function func; duk_c_function trace; s32 params; const char* name;} ApiItems[] = {TIC_API_LIST(API_FUNC_DEF)};
 #undef API_FUNC_DEF
 
+    bool trace = machine->memory.profile.trace.api;
+
     for (s32 i = 0; i < COUNT_OF(ApiItems); i++)
     {
-        duk_push_c_function(machine->js, ApiItems[i].func, ApiItems[i].params);
+        duk_push_c_function(machine->js, trace ? ApiItems[i].trace : ApiItems[i].func, ApiItems[i].params);
         duk_put_global_string(machine->js, ApiItems[i].name);
     }
+
+    duk_get_global_string(duk, "Math");
+    duk_push_c_function(duk, duk_random, 0);
+    duk_put_prop_string(duk, -2, "random");
+    duk_pop(duk);
+}
+
+// TIC, SCN, the old scanline and OVR are looked up after the code is loaded and after every TIC() call
+// and kept in the stash by index, so a cart can reassign them from TIC(), the machine doesn't call
+// the ones that aren't defined
+static void resolveJavascriptCallbacks(tic_machine* machine)
+{
+    duk_context* duk = machine->js;
+
+    static const char* const Names[] = {TIC_FN, SCN_FN, "scanline", OVR_FN};
+    bool defined[COUNT_OF(Names)];
+
+    duk_push_global_stash(duk);
+
+    for(s32 i = 0; i < COUNT_OF(Names); i++)
+    {
+        duk_get_global_string(duk, Names[i]);
+        defined[i] = duk_is_function(duk, -1);
+        duk_put_prop_index(duk, -2, i);
+    }
+
+    duk_pop(duk);
+
+    tic_core_script_callbacks(&machine->memory, defined[1] || defined[2], defined[3]);
 }
 
 static bool initJavascript(tic_mem* tic, const char* code)
@@ -886,20 +1159,24 @@ static bool initJavascript(tic_mem* tic, const char* code)
         return false;
     }
 
+    resolveJavascriptCallbacks(machine);
+
     return true;
 }
 
 static void callJavascriptTick(tic_mem* tic)
 {
-    ForceExitCounter = 0;
-
     tic_machine* machine = (tic_machine*)tic;
+    machine->forceExitCounter = 0;
 
     duk_context* duk = machine->js;
 
     if(duk)
     {
-        if(duk_get_global_string(duk, TIC_FN))
+        duk_push_global_stash(duk);
+        duk_get_prop_index(duk, -1, 0);
+
+        if(duk_is_function(duk, -1))
         {
             if(duk_pcall(duk, 0) != DUK_EXEC_SUCCESS)
             {
@@ -908,32 +1185,36 @@ static void callJavascriptTick(tic_mem* tic)
         }
         else machine->data->error(machine->data->data, "'function TIC()...' isn't found :(");
 
-        duk_pop(duk);
+        duk_pop_2(duk);
+
+        resolveJavascriptCallbacks(machine);
     }
 }
 
-static void callJavascriptScanlineName(tic_mem* tic, s32 row, void* data, const char* name)
+static void callJavascriptScanline(tic_mem* tic, s32 row, void* data)
 {
     tic_machine* machine = (tic_machine*)tic;
     duk_context* duk = machine->js;
 
-    if(duk_get_global_string(duk, name))
+    duk_push_global_stash(duk);
+
+    // SCN and the old scanline
+    for(s32 i = 1; i < 3; i++)
     {
-        duk_push_int(duk, row);
+        duk_get_prop_index(duk, -1, i);
 
-        if(duk_pcall(duk, 1) != 0)
-            machine->data->error(machine->data->data, duk_safe_to_stacktrace(duk, -1));
-    }
+        if(duk_is_function(duk, -1))
+        {
+            duk_push_int(duk, row);
 
-    duk_pop(duk);
-}
+            if(duk_pcall(duk, 1) != 0)
+                machine->data->error(machine->data->data, duk_safe_to_stacktrace(duk, -1));
+        }
 
-static void callJavascriptScanline(tic_mem* tic, s32 row, void* data)
-{
-    callJavascriptScanlineName(tic, row, data, SCN_FN);
+        duk_pop(duk);
+    }
 
-    // try to call old scanline
-    callJavascriptScanlineName(tic, row, data, "scanline");
+    duk_pop(duk);
 }
 
 static void callJavascriptOverline(tic_mem* tic, void* data)
@@ -941,13 +1222,16 @@ static void callJavascriptOverline(tic_mem* tic, void* data)
     tic_machine* machine = (tic_machine*)tic;
     duk_context* duk = machine->js;
 
-    if(duk_get_global_string(duk, OVR_FN))
+    duk_push_global_stash(duk);
+    duk_get_prop_index(duk, -1, 3);
+
+    if(duk_is_function(duk, -1))
     {
         if(duk_pcall(duk, 0) != 0)
             machine->data->error(machine->data->data, duk_safe_to_stacktrace(duk, -1));
     }
 
-    duk_pop(duk);
+    duk_pop_2(duk);
 }
 
 static const char* const JsKeywords [] =
@@ -1046,6 +1330,8 @@ static const tic_script_config JsSyntaxConfig =
 
     .keywords           = JsKeywords,
     .keywordsCount      = COUNT_OF(JsKeywords),
+
+    .name               = "js",
 };
 
 const tic_script_config* getJsScriptConfig()
@@ -123,6 +123,101 @@ static s32 lua_poke4(lua_State* lua)
     return 0;
 }
 
+typedef void(*PeekBuffer)(tic_mem*, s32 address, u8* buffer, s32 size);
+typedef void(*PokeBuffer)(tic_mem*, s32 address, const u8* buffer, s32 size);
+
+// returns the range as a string, string.byte() unpacks it
+static s32 peekLuaBuffer(lua_State* lua, PeekBuffer peek, s32 limit, const char* usage)
+{
+    s32 top = lua_gettop(lua);
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+
+    if(top == 2)
+    {
+        s32 address = getLuaNumber(lua, 1);
+        s32 size = getLuaNumber(lua, 2);
+
+        if(size >= 0 && size <= limit)
+        {
+            u8* buffer = malloc(MAX(size, 1));
+
+            if(buffer)
+            {
+                peek(tic, address, buffer, size);
+                lua_pushlstring(lua, (const char*)buffer, size);
+                free(buffer);
+                return 1;
+            }
+        }
+    }
+
+    luaL_error(lua, "%s", usage);
+    return 0;
+}
+
+// accepts a string or a table of integers
+static s32 pokeLuaBuffer(lua_State* lua, PokeBuffer poke, s32 limit, const char* usage)
+{
+    s32 top = lua_gettop(lua);
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+
+    if(top == 2)
+    {
+        s32 address = getLuaNumber(lua, 1);
+
+        if(lua_type(lua, 2) == LUA_TSTRING)
+        {
+            size_t size = 0;
+            const char* data = lua_tolstring(lua, 2, &size);
+
+            poke(tic, address, (const u8*)data, (s32)MIN(size, (size_t)limit));
+            return 0;
+        }
+        else if(lua_istable(lua, 2))
+        {
+            s32 size = (s32)MIN(lua_rawlen(lua, 2), (size_t)limit);
+            u8* buffer = malloc(MAX(size, 1));
+
+            if(buffer)
+            {
+                for(s32 i = 0; i < size; i++)
+                {
+                    lua_rawgeti(lua, 2, i + 1);
+                    buffer[i] = getLuaNumber(lua, -1);
+                    lua_pop(lua, 1);
+                }
+
+                poke(tic, address, buffer, size);
+                free(buffer);
+                return 0;
+            }
+        }
+    }
+
+    luaL_error(lua, "%s", usage);
+    return 0;
+}
+
+static s32 lua_peekbuf(lua_State* lua)
+{
+    return peekLuaBuffer(lua, tic_api_peekbuf, sizeof(tic_ram), "invalid parameters, peekbuf(addr,size)\n");
+}
+
+static s32 lua_pokebuf(lua_State* lua)
+{
+    return pokeLuaBuffer(lua, tic_api_pokebuf, sizeof(tic_ram), "invalid parameters, pokebuf(addr,data)\n");
+}
+
+static s32 lua_peek4buf(lua_State* lua)
+{
+    return peekLuaBuffer(lua, tic_api_peek4buf, sizeof(tic_ram) * 2, "invalid parameters, peek4buf(addr,size)\n");
+}
+
+static s32 lua_poke4buf(lua_State* lua)
+{
+    return pokeLuaBuffer(lua, tic_api_poke4buf, sizeof(tic_ram) * 2, "invalid parameters, poke4buf(addr,data)\n");
+}
+
 static s32 lua_cls(lua_State* lua)
 {
     s32 top = lua_gettop(lua);
@@ -303,7 +398,7 @@ static s32 lua_textri(lua_State* lua)
             pt[i] = (float)lua_tonumber(lua, i + 1);
 
         tic_mem* tic = (tic_mem*)getLuaMachine(lua);
-        static u8 colors[TIC_PALETTE_SIZE];
+        u8 colors[TIC_PALETTE_SIZE];
         s32 count = 0;
         bool use_map = false;
 
@@ -311,7 +406,7 @@ static s32 lua_textri(lua_State* lua)
         if (top >= 13)
             use_map = lua_toboolean(lua, 13);
         //  check for chroma 
-        if(top >= 14)
+        if(top >= 14 && !lua_isnil(lua, 14))
         {
             if(lua_istable(lua, 14))
             {
@@ -338,6 +433,14 @@ static s32 lua_textri(lua_State* lua)
             }
         }
 
+        //  check for depth
+        float z[3] = {0};
+        bool depth = top >= 17;
+
+        if(depth)
+            for(s32 i = 0; i < COUNT_OF(z); i++)
+                z[i] = (float)lua_tonumber(lua, i + 15);
+
         tic_api_textri(tic, pt[0], pt[1],   //  xy 1
                                     pt[2], pt[3],   //  xy 2
                                     pt[4], pt[5],   //  xy 3
@@ -345,9 +448,10 @@ static s32 lua_textri(lua_State* lua)
                                     pt[8], pt[9],   //  uv 2
                                     pt[10], pt[11], //  uv 3
                                     use_map,        // use map
-                                    colors, count);        // chroma
+                                    colors, count,  // chroma
+                                    z[0], z[1], z[2], depth);
     }
-    else luaL_error(lua, "invalid parameters, textri(x1,y1,x2,y2,x3,y3,u1,v1,u2,v2,u3,v3,[use_map=false],[chroma=off])\n");
+    else luaL_error(lua, "invalid parameters, textri(x1,y1,x2,y2,x3,y3,u1,v1,u2,v2,u3,v3,[use_map=false],[chroma=off],[z1,z2,z3])\n");
     return 0;
 }
 
@@ -378,6 +482,46 @@ static s32 lua_clip(lua_State* lua)
     return 0;
 }
 
+static s32 lua_raster(lua_State* lua)
+{
+    s32 top = lua_gettop(lua);
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+
+    if(top == 0)
+        tic_api_raster(tic, -1, 0, -1, -1, 0);
+    else if(top != 4)
+    {
+        // missing or nil fields leave the row as it is
+        s32 row = getLuaNumber(lua, 1);
+        s32 x = top >= 2 && !lua_isnil(lua, 2) ? getLuaNumber(lua, 2) : TIC_RASTER_KEEP;
+        s32 border = top >= 3 && !lua_isnil(lua, 3) ? getLuaNumber(lua, 3) : TIC_RASTER_KEEP;
+        s32 color = top >= 5 && !lua_isnil(lua, 4) ? getLuaNumber(lua, 4) : -1;
+        u32 rgb = top >= 5 ? getLuaNumber(lua, 5) : 0;
+
+        tic_api_raster(tic, row, x, border, color, rgb);
+    }
+    else luaL_error(lua, "invalid parameters, use raster(row,[x],[border],[color,rgb]) or raster()\n");
+
+    return 0;
+}
+
+static s32 lua_rasterbuf(lua_State* lua)
+{
+    s32 top = lua_gettop(lua);
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+
+    if(top == 2)
+    {
+        s32 address = getLuaNumber(lua, 1);
+        s32 count = getLuaNumber(lua, 2);
+
+        tic_api_rasterbuf(tic, address, count);
+    }
+    else luaL_error(lua, "invalid parameters, rasterbuf(addr,count)\n");
+
+    return 0;
+}
+
 static s32 lua_btnp(lua_State* lua)
 {
     tic_machine* machine = getLuaMachine(lua);
@@ -436,6 +580,86 @@ static s32 lua_btn(lua_State* lua)
     return 1;
 }
 
+static s32 lua_target(lua_State* lua)
+{
+    s32 top = lua_gettop(lua);
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+
+    tic_api_target(tic, top >= 1 ? getLuaNumber(lua, 1) : -1);
+
+    return 0;
+}
+
+// reads a number or a table of up to 16 numbers
+static s32 getLuaColors(lua_State* lua, s32 index, u8* colors)
+{
+    s32 count = 0;
+
+    if(lua_istable(lua, index))
+    {
+        for(s32 i = 1; i <= TIC_PALETTE_SIZE; i++)
+        {
+            lua_rawgeti(lua, index, i);
+            bool valid = lua_isnumber(lua, -1);
+            if(valid) colors[count++] = getLuaNumber(lua, -1);
+            lua_pop(lua, 1);
+            if(!valid) break;
+        }
+    }
+    else if(lua_isnumber(lua, index))
+        colors[count++] = getLuaNumber(lua, index);
+
+    return count;
+}
+
+static s32 lua_blit(lua_State* lua)
+{
+    s32 top = lua_gettop(lua);
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+
+    if(top >= 1)
+    {
+        s32 src = getLuaNumber(lua, 1);
+        s32 x = top >= 2 ? getLuaNumber(lua, 2) : 0;
+        s32 y = top >= 3 ? getLuaNumber(lua, 3) : 0;
+        u8 colors[TIC_PALETTE_SIZE];
+        s32 count = top >= 4 ? getLuaColors(lua, 4, colors) : 0;
+        s32 dst = top >= 5 && !lua_isnil(lua, 5) ? getLuaNumber(lua, 5) : -1;
+        u8 remap[TIC_PALETTE_SIZE];
+        bool hasRemap = top >= 6 && lua_istable(lua, 6);
+
+        if(hasRemap)
+            for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+            {
+                lua_rawgeti(lua, 6, i + 1);
+                remap[i] = lua_isnumber(lua, -1) ? getLuaNumber(lua, -1) : i;
+                lua_pop(lua, 1);
+            }
+
+        tic_api_blit(tic, src, x, y, colors, count, dst, hasRemap ? remap : NULL);
+    }
+    else luaL_error(lua, "invalid parameters, blit(src,[x=0],[y=0],[colorkey=-1],[dst=-1],[remap])\n");
+
+    return 0;
+}
+
+static s32 lua_oam(lua_State* lua)
+{
+    s32 top = lua_gettop(lua);
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+
+    if(top == 2)
+    {
+        s32 address = getLuaNumber(lua, 1);
+        s32 count = getLuaNumber(lua, 2);
+
+        tic_api_oam(tic, address, count);
+    }
+    else luaL_error(lua, "invalid parameters, oam(addr,count)\n");
+
+    return 0;
+}
+
 static s32 lua_spr(lua_State* lua)
 {
     s32 top = lua_gettop(lua);
@@ -448,7 +672,7 @@ static s32 lua_spr(lua_State* lua)
     s32 scale = 1;
     tic_flip flip = tic_no_flip;
     tic_rotate rotate = tic_no_rotate;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(top >= 1) 
@@ -578,6 +802,45 @@ static void remapCallback(void* data, s32 x, s32 y, RemapResult* result)
     result->rotate = getLuaNumber(lua, -1);
 }
 
+// remap(cells) gets {id, x, y, id, x, y, ...} for all the visible cells
+// and returns {id, flip, rotate, ...} in the same order
+static void remapBatchCallback(void* data, RemapCell* cells, s32 count)
+{
+    RemapData* remap = (RemapData*)data;
+    lua_State* lua = remap->lua;
+
+    lua_rawgeti(lua, LUA_REGISTRYINDEX, remap->reg);
+    lua_createtable(lua, count * 3, 0);
+
+    for(s32 i = 0; i < count; i++)
+    {
+        lua_pushinteger(lua, cells[i].result.index);
+        lua_rawseti(lua, -2, i * 3 + 1);
+        lua_pushinteger(lua, cells[i].x);
+        lua_rawseti(lua, -2, i * 3 + 2);
+        lua_pushinteger(lua, cells[i].y);
+        lua_rawseti(lua, -2, i * 3 + 3);
+    }
+
+    if(lua_pcall(lua, 1, 1, 0) == LUA_OK && lua_istable(lua, -1))
+    {
+        for(s32 i = 0; i < count; i++)
+        {
+            RemapResult* result = &cells[i].result;
+
+            lua_rawgeti(lua, -1, i * 3 + 1);
+            result->index = getLuaNumber(lua, -1);
+            lua_rawgeti(lua, -2, i * 3 + 2);
+            result->flip = getLuaNumber(lua, -1);
+            lua_rawgeti(lua, -3, i * 3 + 3);
+            result->rotate = getLuaNumber(lua, -1);
+            lua_pop(lua, 3);
+        }
+    }
+
+    lua_pop(lua, 1);
+}
+
 static s32 lua_map(lua_State* lua)
 {
     s32 x = 0;
@@ -587,7 +850,7 @@ static s32 lua_map(lua_State* lua)
     s32 sx = 0;
     s32 sy = 0;
     s32 scale = 1;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     s32 top = lua_gettop(lua);
@@ -641,13 +904,19 @@ static s32 lua_map(lua_State* lua)
                         {
                             if (lua_isfunction(lua, 9))
                             {
+                                bool batch = top >= 10 && lua_toboolean(lua, 10);
+
+                                lua_pushvalue(lua, 9);
                                 s32 remap = luaL_ref(lua, LUA_REGISTRYINDEX);
 
                                 RemapData data = {lua, remap};
 
                                 tic_mem* tic = (tic_mem*)getLuaMachine(lua);
 
-                                tic_api_map(tic, x, y, w, h, sx, sy, colors, count, scale, remapCallback, &data);
+                                if(batch)
+                                    tic_core_map_batch(tic, x, y, w, h, sx, sy, colors, count, scale, remapBatchCallback, &data);
+                                else
+                                    tic_api_map(tic, x, y, w, h, sx, sy, colors, count, scale, remapCallback, &data);
 
                                 luaL_unref(lua, LUA_REGISTRYINDEX, data.reg);
 
@@ -1233,6 +1502,47 @@ static s32 lua_loadfile(lua_State *lua)
     return 0;
 }
 
+// math.random and math.randomseed of Lua 5.3 on the generator of the machine
+static s32 lua_random(lua_State *lua)
+{
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+    lua_Integer low, up;
+    double r = tic_core_random(tic) / 4294967296.0;
+
+    switch (lua_gettop(lua))
+    {
+    case 0:
+        lua_pushnumber(lua, (lua_Number)r);
+        return 1;
+    case 1:
+        low = 1;
+        up = luaL_checkinteger(lua, 1);
+        break;
+    case 2:
+        low = luaL_checkinteger(lua, 1);
+        up = luaL_checkinteger(lua, 2);
+        break;
+    default:
+        return luaL_error(lua, "wrong number of arguments");
+    }
+
+    luaL_argcheck(lua, low <= up, 1, "interval is empty");
+    luaL_argcheck(lua, low >= 0 || up <= LUA_MAXINTEGER + low, 1, "interval too large");
+
+    lua_pushinteger(lua, low + (lua_Integer)(r * ((lua_Number)(up - low) + 1.0)));
+
+    return 1;
+}
+
+static s32 lua_randomseed(lua_State *lua)
+{
+    tic_mem* tic = (tic_mem*)getLuaMachine(lua);
+
+    tic_core_random_seed(tic, (u64)(lua_Integer)luaL_checknumber(lua, 1));
+
+    return 0;
+}
+
 static void lua_open_builtins(lua_State *lua)
 {
     static const luaL_Reg loadedlibs[] =
@@ -1264,21 +1574,49 @@ static void checkForceExit(lua_State *lua, lua_Debug *luadebug)
         luaL_error(lua, "script execution was interrupted");
 }
 
+// API functions recording trace spans, registered instead of the plain ones while tracing
+#define API_TRACE_DEF(name, ...)                                    \
+    static s32 lua_trace_ ## name(lua_State* lua)                   \
+    {                                                               \
+        tic_mem* tic = (tic_mem*)getLuaMachine(lua);                \
+        u64 start = tic_core_trace_begin(tic);                      \
+        s32 res = lua_ ## name(lua);                                \
+        tic_core_trace_end(tic, tic_api_index_ ## name, start);     \
+        return res;                                                 \
+    }
+TIC_API_LIST(API_TRACE_DEF)
+#undef API_TRACE_DEF
+
 static void initAPI(tic_machine* machine)
 {
     lua_pushlightuserdata(machine->lua, machine);
     lua_setglobal(machine->lua, TicMachine);
 
-#define API_FUNC_DEF(name, ...) {lua_ ## name, #name},
-    static const struct{lua_CFunction func; const char* name;} ApiItems[] = {TIC_API_LIST(API_FUNC_DEF)};
+    for(s32 i = 0; i < COUNT_OF(machine->luaCallbackRefs); i++)
+        machine->luaCallbackRefs[i] = LUA_NOREF;
+
+#define API_FUNC_DEF(name, ...) {lua_ ## name, lua_trace_ ## name, #name},
+    static const struct{lua_CFunction func; lua_CFunction trace; const char* name;} ApiItems[] = {TIC_API_LIST(API_FUNC_DEF)};
 #undef API_FUNC_DEF
 
+    bool trace = machine->memory.profile.trace.api;
+
     for (s32 i = 0; i < COUNT_OF(ApiItems); i++)
-        registerLuaFunction(machine, ApiItems[i].func, ApiItems[i].name);
+        registerLuaFunction(machine, trace ? ApiItems[i].trace : ApiItems[i].func, ApiItems[i].name);
 
     registerLuaFunction(machine, lua_dofile, "dofile");
     registerLuaFunction(machine, lua_loadfile, "loadfile");
 
+    lua_getglobal(machine->lua, LUA_MATHLIBNAME);
+    if(lua_istable(machine->lua, -1))
+    {
+        lua_pushcfunction(machine->lua, lua_random);
+        lua_setfield(machine->lua, -2, "random");
+        lua_pushcfunction(machine->lua, lua_randomseed);
+        lua_setfield(machine->lua, -2, "randomseed");
+    }
+    lua_pop(machine->lua, 1);
+
     lua_sethook(machine->lua, &checkForceExit, LUA_MASKCOUNT, LUA_LOC_STACK);
 }
 
@@ -1293,6 +1631,107 @@ static void closeLua(tic_mem* tic)
     }
 }
 
+typedef struct
+{
+    u8* data;
+    s32 size;
+} LuaChunk;
+
+static s32 writeChunk(lua_State* lua, const void* buffer, size_t size, void* data)
+{
+    LuaChunk* chunk = data;
+    u8* grown = realloc(chunk->data, chunk->size + size);
+
+    if(!grown) return 1;
+
+    memcpy(grown + chunk->size, buffer, size);
+    chunk->data = grown;
+    chunk->size += size;
+
+    return 0;
+}
+
+// the function on top of the stack is dumped with its debug info, so the errors keep their lines
+static void saveChunk(tic_machine* machine, const char* name, const char* code)
+{
+    tic_tick_data* data = machine->data;
+
+    if(!data->saveCache) return;
+
+    LuaChunk chunk = {NULL, 0};
+
+    if(lua_dump(machine->lua, writeChunk, &chunk, 0) == 0 && chunk.data)
+        data->saveCache(data->data, name, code, chunk.data, chunk.size);
+
+    free(chunk.data);
+}
+
+// pushes the cached function of the code, a chunk of another Lua build fails to load and is ignored
+static bool loadChunk(tic_machine* machine, const char* name, const char* code)
+{
+    tic_tick_data* data = machine->data;
+
+    if(!data->loadCache) return false;
+
+    s32 size = 0;
+    void* buffer = data->loadCache(data->data, name, code, &size);
+
+    if(!buffer) return false;
+
+    bool done = luaL_loadbufferx(machine->lua, buffer, size, name, "b") == LUA_OK;
+
+    if(!done)
+        lua_pop(machine->lua, 1);
+
+    free(buffer);
+
+    return done;
+}
+
+// TIC, SCN, the old scanline and OVR are looked up after the code is loaded or evaluated and
+// after every TIC() call, so a cart can reassign them from TIC(), the machine doesn't call
+// the ones that aren't defined
+static void resolveLuaCallbacks(tic_machine* machine)
+{
+    lua_State* lua = machine->lua;
+    s32* refs = machine->luaCallbackRefs;
+
+    static const char* const Names[] = {TIC_FN, SCN_FN, "scanline", OVR_FN};
+
+    for(s32 i = 0; i < COUNT_OF(Names); i++)
+    {
+        lua_getglobal(lua, Names[i]);
+
+        if(lua_isfunction(lua, -1))
+        {
+            if(refs[i] != LUA_NOREF)
+            {
+                lua_rawgeti(lua, LUA_REGISTRYINDEX, refs[i]);
+                bool same = lua_rawequal(lua, -1, -2);
+                lua_pop(lua, 1);
+
+                if(same)
+                {
+                    lua_pop(lua, 1);
+                    continue;
+                }
+
+                luaL_unref(lua, LUA_REGISTRYINDEX, refs[i]);
+            }
+
+            refs[i] = luaL_ref(lua, LUA_REGISTRYINDEX);
+        }
+        else
+        {
+            lua_pop(lua, 1);
+            luaL_unref(lua, LUA_REGISTRYINDEX, refs[i]);
+            refs[i] = LUA_NOREF;
+        }
+    }
+
+    tic_core_script_callbacks(&machine->memory, refs[1] != LUA_NOREF || refs[2] != LUA_NOREF, refs[3] != LUA_NOREF);
+}
+
 static bool initLua(tic_mem* tic, const char* code)
 {
     tic_machine* machine = (tic_machine*)tic;
@@ -1309,13 +1748,26 @@ static bool initLua(tic_mem* tic, const char* code)
 
         lua_settop(lua, 0);
 
-        if(luaL_loadstring(lua, code) != LUA_OK || lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
+        if(!loadChunk(machine, "lua", code))
+        {
+            if(luaL_loadstring(lua, code) != LUA_OK)
+            {
+                machine->data->error(machine->data->data, lua_tostring(lua, -1));
+                return false;
+            }
+
+            saveChunk(machine, "lua", code);
+        }
+
+        if(lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
         {
             machine->data->error(machine->data->data, lua_tostring(lua, -1));
             return false;
         }
     }
 
+    resolveLuaCallbacks(machine);
+
     return true;
 }
 
@@ -1362,62 +1814,51 @@ static void callLuaTick(tic_mem* tic)
 
     if(lua)
     {
-        lua_getglobal(lua, TIC_FN);
-        if(lua_isfunction(lua, -1)) 
+        if(machine->luaCallbackRefs[0] != LUA_NOREF)
         {
+            lua_rawgeti(lua, LUA_REGISTRYINDEX, machine->luaCallbackRefs[0]);
             if(docall(lua, 0, 0) != LUA_OK) 
                 machine->data->error(machine->data->data, lua_tostring(lua, -1));
         }
-        else 
-        {       
-            lua_pop(lua, 1);
-            machine->data->error(machine->data->data, "'function TIC()...' isn't found :(");
-        }
+        else machine->data->error(machine->data->data, "'function TIC()...' isn't found :(");
+
+        resolveLuaCallbacks(machine);
     }
 }
 
-static void callLuaScanlineName(tic_mem* tic, s32 row, void* data, const char* name)
+static void callLuaScanline(tic_mem* tic, s32 row, void* data)
 {
     tic_machine* machine = (tic_machine*)tic;
     lua_State* lua = machine->lua;
 
     if (lua)
     {
-        lua_getglobal(lua, name);
-        if(lua_isfunction(lua, -1))
+        // SCN and the old scanline
+        for(s32 i = 1; i < 3; i++)
         {
+            s32 ref = machine->luaCallbackRefs[i];
+
+            if(ref == LUA_NOREF) continue;
+
+            lua_rawgeti(lua, LUA_REGISTRYINDEX, ref);
             lua_pushinteger(lua, row);
             if(docall(lua, 1, 0) != LUA_OK)
                 machine->data->error(machine->data->data, lua_tostring(lua, -1));
         }
-        else lua_pop(lua, 1);
     }
 }
 
-static void callLuaScanline(tic_mem* tic, s32 row, void* data)
-{
-    callLuaScanlineName(tic, row, data, SCN_FN);
-
-    // try to call old scanline
-    callLuaScanlineName(tic, row, data, "scanline");
-}
-
 static void callLuaOverline(tic_mem* tic, void* data)
 {
     tic_machine* machine = (tic_machine*)tic;
     lua_State* lua = machine->lua;
 
-    if (lua)
+    if (lua && machine->luaCallbackRefs[3] != LUA_NOREF)
     {
-        const char* OvrFunc = OVR_FN;
+        lua_rawgeti(lua, LUA_REGISTRYINDEX, machine->luaCallbackRefs[3]);
 
-        lua_getglobal(lua, OvrFunc);
-        if(lua_isfunction(lua, -1)) 
-        {
-            if(docall(lua, 0, 0) != LUA_OK)
-                machine->data->error(machine->data->data, lua_tostring(lua, -1));
-        }
-        else lua_pop(lua, 1);
+        if(docall(lua, 0, 0) != LUA_OK)
+            machine->data->error(machine->data->data, lua_tostring(lua, -1));
     }
 
 }
@@ -1504,6 +1945,8 @@ static void evalLua(tic_mem* tic, const char* code) {
     {
         machine->data->error(machine->data->data, lua_tostring(lua, -1));
     }
+
+    resolveLuaCallbacks(machine);
 }
 
 static const tic_script_config LuaSyntaxConfig = 
@@ -1527,6 +1970,8 @@ static const tic_script_config LuaSyntaxConfig =
 
     .keywords           = LuaKeywords,
     .keywordsCount      = COUNT_OF(LuaKeywords),
+
+    .name               = "lua",
 };
 
 const tic_script_config* getLuaScriptConfig()
@@ -1541,14 +1986,17 @@ const tic_script_config* getLuaScriptConfig()
 #define MOON_CODE(...) #__VA_ARGS__
 
 static const char* execute_moonscript_src = MOON_CODE(
-    local fn, err = require('moonscript.base').loadstring(...)
+    local code, err = require('moonscript.base').to_lua(...)
 
-    if not fn then
+    if not code then
         error(err)
     end
-    return fn()
+    return code
 );
 
+// the chunk name moonscript.base.loadstring() gives the code
+#define MOON_CHUNK_NAME "=(moonscript.loadstring)"
+
 static void setloaded(lua_State* l, char* name)
 {
     s32 top = lua_gettop(l);
@@ -1564,6 +2012,56 @@ static void setloaded(lua_State* l, char* name)
     lua_settop(l, top);
 }
 
+// pushes the function of the code, the Lua made by the transpiler is cached too
+static bool loadMoonscript(tic_machine* machine, const char* code)
+{
+    lua_State* moon = machine->lua;
+    tic_tick_data* data = machine->data;
+
+    s32 size = 0;
+    char* source = data->loadCache ? data->loadCache(data->data, "moon.lua", code, &size) : NULL;
+    s32 status;
+
+    if(source)
+    {
+        status = luaL_loadbuffer(moon, source, size, MOON_CHUNK_NAME);
+        free(source);
+    }
+    else
+    {
+        if (luaL_loadbuffer(moon, execute_moonscript_src, strlen(execute_moonscript_src), "execute_moonscript") != LUA_OK)
+        {
+            machine->data->error(machine->data->data, "failed to load moonscript compiler");
+            return false;
+        }
+
+        lua_pushstring(moon, code);
+        if (lua_pcall(moon, 1, 1, 0) != LUA_OK)
+        {
+            const char* msg = lua_tostring(moon, -1);
+            machine->data->error(machine->data->data, msg ? msg : "failed to compile moonscript");
+            return false;
+        }
+
+        size_t length = 0;
+        const char* lua = lua_tolstring(moon, -1, &length);
+
+        if(data->saveCache)
+            data->saveCache(data->data, "moon.lua", code, lua, (s32)length);
+
+        status = luaL_loadbuffer(moon, lua, length, MOON_CHUNK_NAME);
+        lua_remove(moon, -2);
+    }
+
+    if(status != LUA_OK)
+    {
+        machine->data->error(machine->data->data, lua_tostring(moon, -1));
+        return false;
+    }
+
+    return true;
+}
+
 static bool initMoonscript(tic_mem* tic, const char* code)
 {
     tic_machine* machine = (tic_machine*)tic;
@@ -1590,14 +2088,15 @@ static bool initMoonscript(tic_mem* tic, const char* code)
 
         lua_call(moon, 0, 0);
 
-        if (luaL_loadbuffer(moon, execute_moonscript_src, strlen(execute_moonscript_src), "execute_moonscript") != LUA_OK)
+        if(!loadChunk(machine, "moon", code))
         {
-            machine->data->error(machine->data->data, "failed to load moonscript compiler");
-            return false;
+            if(!loadMoonscript(machine, code))
+                return false;
+
+            saveChunk(machine, "moon", code);
         }
 
-        lua_pushstring(moon, code);
-        if (lua_pcall(moon, 1, 1, 0) != LUA_OK)
+        if (lua_pcall(moon, 0, 0, 0) != LUA_OK)
         {
             const char* msg = lua_tostring(moon, -1);
 
@@ -1609,6 +2108,8 @@ static bool initMoonscript(tic_mem* tic, const char* code)
         }
     }
 
+    resolveLuaCallbacks(machine);
+
     return true;
 }
 
@@ -1694,6 +2195,8 @@ static const tic_script_config MoonSyntaxConfig =
 
     .keywords           = MoonKeywords,
     .keywordsCount      = COUNT_OF(MoonKeywords),
+
+    .name               = "moon",
 };
 
 const tic_script_config* getMoonScriptConfig()
@@ -1715,6 +2218,69 @@ static const char* execute_fennel_src = FENNEL_CODE(
   if(not ok) then return msg end
 );
 
+static const char* compile_fennel_src = FENNEL_CODE(
+  local opts = {filename="game", correlate=true, allowedGlobals=false}
+  local ok, code = pcall(require('fennel').compileString, ..., opts)
+  if(not ok) then return nil, code end
+  return code
+);
+
+// the chunk name fennel.eval() gives the code
+#define FENNEL_CHUNK_NAME "@game"
+
+// pushes the function of the code, the Lua made by the compiler is cached too
+static bool loadFennel(tic_machine* machine, const char* code)
+{
+    lua_State* fennel = machine->lua;
+    tic_tick_data* data = machine->data;
+
+    s32 size = 0;
+    char* source = data->loadCache ? data->loadCache(data->data, "fnl.lua", code, &size) : NULL;
+    s32 status;
+
+    if(source)
+    {
+        status = luaL_loadbuffer(fennel, source, size, FENNEL_CHUNK_NAME);
+        free(source);
+    }
+    else
+    {
+        if (luaL_loadbuffer(fennel, compile_fennel_src, strlen(compile_fennel_src), "compile_fennel") != LUA_OK)
+        {
+            machine->data->error(machine->data->data, "failed to load fennel compiler");
+            return false;
+        }
+
+        lua_pushstring(fennel, code);
+        lua_call(fennel, 1, 2);
+
+        if(!lua_isstring(fennel, -2))
+        {
+            machine->data->error(machine->data->data, lua_tostring(fennel, -1));
+            return false;
+        }
+
+        lua_pop(fennel, 1);
+
+        size_t length = 0;
+        const char* lua = lua_tolstring(fennel, -1, &length);
+
+        if(data->saveCache)
+            data->saveCache(data->data, "fnl.lua", code, lua, (s32)length);
+
+        status = luaL_loadbuffer(fennel, lua, length, FENNEL_CHUNK_NAME);
+        lua_remove(fennel, -2);
+    }
+
+    if(status != LUA_OK)
+    {
+        machine->data->error(machine->data->data, lua_tostring(fennel, -1));
+        return false;
+    }
+
+    return true;
+}
+
 static bool initFennel(tic_mem* tic, const char* code)
 {
     tic_machine* machine = (tic_machine*)tic;
@@ -1739,23 +2305,23 @@ static bool initFennel(tic_mem* tic, const char* code)
 
         lua_call(fennel, 0, 0);
 
-        if (luaL_loadbuffer(fennel, execute_fennel_src, strlen(execute_fennel_src), "execute_fennel") != LUA_OK)
+        if(!loadChunk(machine, "fnl", code))
         {
-            machine->data->error(machine->data->data, "failed to load fennel compiler");
-            return false;
-        }
+            if(!loadFennel(machine, code))
+                return false;
 
-        lua_pushstring(fennel, code);
-        lua_call(fennel, 1, 1);
-        const char* err = lua_tostring(fennel, -1);
+            saveChunk(machine, "fnl", code);
+        }
 
-        if (err)
+        if (lua_pcall(fennel, 0, 0, 0) != LUA_OK)
         {
-            machine->data->error(machine->data->data, err);
+            machine->data->error(machine->data->data, lua_tostring(fennel, -1));
             return false;
         }
     }
 
+    resolveLuaCallbacks(machine);
+
     return true;
 }
 
@@ -1846,6 +2412,8 @@ static void evalFennel(tic_mem* tic, const char* code) {
     {
         machine->data->error(machine->data->data, err);
     }
+
+    resolveLuaCallbacks(machine);
 }
 
 
@@ -1870,6 +2438,8 @@ static const tic_script_config FennelSyntaxConfig =
 
     .keywords           = FennelKeywords,
     .keywordsCount      = COUNT_OF(FennelKeywords),
+
+    .name               = "fennel",
 };
 
 const tic_script_config* getFennelConfig()
@@ -23,7 +23,10 @@
 #pragma once
 
 #include "ticapi.h"
+#include "drawlist.h"
+#include "audioring.h"
 #include "tools.h"
+#include "tilesheet.h"
 #include "blip_buf.h"
 #include "quickjs.h"
 
@@ -34,6 +37,35 @@ typedef struct
     s32 amp;        /* current amplitude in delta buffer */
 }tic_sound_register_data;
 
+// amplitudes of every waveform value on both sides, decoded again when the waveform or the volumes change
+typedef struct
+{
+    tic_waveform waveform;
+    u8 volume;
+    u8 left;
+    u8 right;
+    bool valid;
+    s32 amps[TIC_STEREO_CHANNELS][WAVE_VALUES];
+} tic_sound_wave;
+
+// everything the synthesis changes, it belongs to the audio thread while the audio ring is on
+typedef struct
+{
+    struct
+    {
+        blip_buffer_t* left;
+        blip_buffer_t* right;
+    } blip;
+
+    struct
+    {
+        tic_sound_register_data left[TIC_SOUND_CHANNELS];
+        tic_sound_register_data right[TIC_SOUND_CHANNELS];
+    } registers;
+
+    tic_sound_wave waves[TIC_SOUND_CHANNELS];
+} tic_sound_synth;
+
 typedef struct
 {
     s32 tick;
@@ -49,6 +81,18 @@ typedef struct
     s32 duration;
 } tic_channel_data;
 
+// a tic_track_row with the bitfields unpacked
+typedef struct
+{
+    u8 note;
+    u8 octave;
+    u8 command;
+    u8 param1;
+    u8 param2;
+    u8 sfx;
+    s16 param;      // param1 and param2 as one value
+} tic_music_row;
+
 typedef struct
 {
     struct
@@ -79,7 +123,7 @@ typedef struct
 
     struct
     {
-        const tic_track_row* row;
+        const tic_music_row* row;
         s32 ticks;
     } delay;
 
@@ -100,6 +144,22 @@ typedef struct
     s32 beat;
 } tic_jump_command;
 
+typedef struct
+{
+    bool set;
+    s8 x;           // added to the horizontal screen offset
+    s8 border;      // border color, -1 keeps the VRAM one
+    u16 mask;       // palette entries replaced on the row
+    tic_palette palette;
+} tic_raster_row;
+
+// per-row overrides the blit applies while converting the screen, see tic_api_raster
+typedef struct
+{
+    bool active;
+    tic_raster_row rows[TIC80_HEIGHT];
+} tic_raster;
+
 typedef struct
 {
 
@@ -119,12 +179,6 @@ typedef struct
 
     tic_clip_data clip;
 
-    struct
-    {
-        tic_sound_register_data left[TIC_SOUND_CHANNELS];
-        tic_sound_register_data right[TIC_SOUND_CHANNELS];
-    } registers;
-
     struct
     {
         tic_channel_data channels[TIC_SOUND_CHANNELS];
@@ -150,15 +204,126 @@ typedef struct
         tic_palette palette;
     } ovr;
 
+    tic_raster raster;
+
     void (*setpix)(tic_mem* memory, s32 x, s32 y, u8 color);
     u8 (*getpix)(tic_mem* memory, s32 x, s32 y);
     void (*drawhline)(tic_mem* memory, s32 xl, s32 xr, s32 y, u8 color);
 
+    struct
+    {
+        s32 index;      // offscreen target the primitives draw to, -1 for the screen
+        u8* data;       // pixels the DMA functions write to
+        bool* dirty;    // rows the DMA functions mark as changed
+        bool ovr;       // the screen is the OVR layer
+    } target;
+
     u32 synced;
 
     bool initialized;
 } tic_machine_state_data;
 
+typedef struct
+{
+    tic_palette src;
+    tic80_pixel_color_format fmt;
+
+    u32 colors[TIC_PALETTE_SIZE];
+    u32 pairs[TIC_PALETTE_SIZE * TIC_PALETTE_SIZE][2];
+    u8 planes[sizeof(u32)][TIC_PALETTE_SIZE];
+
+    // incremented on every rebuild, so equal versions mean equal colors
+    u32 version;
+} tic_blit_palette;
+
+typedef struct
+{
+    u32 palette;
+    s16 x;
+    s8 y;
+    u8 border;
+} tic_blit_row;
+
+typedef struct
+{
+    bool vram[TIC80_HEIGHT];                // VRAM rows written since the last blit
+    bool ovr[TIC80_HEIGHT];                 // screen rows drawn over by OVR since the last blit
+    bool changed[TIC80_FULLHEIGHT];         // screen buffer rows changed since the last blit started
+    tic_blit_row rows[TIC80_FULLHEIGHT];    // state every screen buffer row was converted with
+    bool target[TIC80_HEIGHT];              // rows drawn to offscreen targets, never read
+} tic_dirty_rows;
+
+// left and right edges of the shape on every row, used to fill circles and flat triangles
+typedef struct
+{
+    s16 Left[TIC80_HEIGHT];
+    s16 Right[TIC80_HEIGHT];    
+} tic_sides_buffer;
+
+// colors used by every column of the glyphs drawn by print() and font(),
+// the proportional width of a glyph is found by masking them with the opaque colors
+typedef struct
+{
+    u32 tag;                        // glyph number and bpp, 0 if the slot is empty
+    u16 columns[TIC_SPRITESIZE];
+} tic_glyph;
+
+typedef struct
+{
+    tic_glyph items[2048];
+} tic_glyph_cache;
+
+// the whole map rendered with unmapped tile colors, allocated by the first map() call that can use it
+typedef struct
+{
+    u16* cells;             // tile index | tile generation << 8 every cell was rendered with, 0 if not rendered yet
+    u8* pixels;             // TIC_MAP_WIDTH x TIC_MAP_HEIGHT tiles as nibbles
+    u8 generation[256];     // per tile index, bumped by the writes to its tile and never 0
+    u8 segment;             // blit segment the cells were rendered with
+} tic_map_layer;
+
+// the sprite sheet of the blit segment decoded to one byte per pixel for textri(),
+// a row of tiles is decoded by the first triangle sampling it
+typedef struct
+{
+    u8 pixels[TIC_SPRITESHEET_SIZE * TIC_SPRITE_BANKS][TIC_SPRITESHEET_SIZE];
+    bool valid[TIC_SPRITESHEET_SIZE * TIC_SPRITE_BANKS / TIC_SPRITESIZE];
+    u8 segment;
+} tic_sheet_texture;
+
+typedef struct
+{
+    bool valid;
+    s32 rows;                                       // rows played in every frame
+    s32 start[MUSIC_PATTERN_ROWS + 1];              // first tick of every row
+    s32 seek[MUSIC_PATTERN_ROWS + 1];               // tick a jump or music() to the row starts from
+    u8 patterns[MUSIC_FRAMES][TIC_SOUND_CHANNELS];
+    bool empty[MUSIC_FRAMES];                       // no pattern on any channel
+} tic_music_track;
+
+typedef struct
+{
+    bool valid;
+    tic_music_row rows[MUSIC_PATTERN_ROWS];
+} tic_music_pattern;
+
+// the music RAM unpacked for processMusic, a track or a pattern is decoded again
+// by the first tick that needs it after its RAM was written
+typedef struct
+{
+    tic_music_track tracks[MUSIC_TRACKS];
+    tic_music_pattern patterns[MUSIC_PATTERNS];
+} tic_music_cache;
+
+// writes to every screen pixel since the frame started, the blit shows them as a heatmap
+// instead of the colors while the overdraw view is on
+typedef struct
+{
+    u16 counts[TIC80_WIDTH * TIC80_HEIGHT];
+    u32 pixels;
+    u32 tiles;
+} tic_overdraw_counts;
+
 typedef struct
 {
     tic_mem memory; // it should be first
@@ -167,16 +332,33 @@ typedef struct
     {
 #if defined(TIC_BUILD_WITH_LUA) || defined(TIC_BUILD_WITH_MOON) || defined(TIC_BUILD_WITH_FENNEL)
         struct lua_State* lua;
+
+        // registry refs of TIC, SCN, the legacy scanline and OVR callbacks
+        s32 luaCallbackRefs[4];
 #endif
 
 #if defined(TIC_BUILD_WITH_JS)
         struct duk_hthread* js;
         JSRuntime* qjs_rt;
         JSContext* qjs;
+        JSValue qjsTick;
+        JSValue qjsScanline;
+        JSValue qjsOverline;
+        u64 forceExitCounter;
 #endif
 
 #if defined(TIC_BUILD_WITH_WREN)
         struct WrenVM* wren;
+
+        struct
+        {
+            struct WrenHandle* game;
+            struct WrenHandle* create;
+            struct WrenHandle* update;
+            struct WrenHandle* scanline;
+            struct WrenHandle* overline;
+            bool loaded;
+        } wrenHandles;
 #endif  
 
 #if defined(TIC_BUILD_WITH_SQUIRREL)
@@ -185,18 +367,35 @@ typedef struct
 
     };
 
+    tic_sound_synth synth;
+    s32 samplerate;
+
     struct
     {
-        blip_buffer_t* left;
-        blip_buffer_t* right;
-    } blip;
-    
-    s32 samplerate;
+        tic_audio_ring* ring;           // NULL unless the audio thread synthesizes the sound
+        tic_sound_snapshot current;     // registers the audio thread plays
+        s32 clocks;                     // clocks of the current registers left to play
+        s32 starved;                    // ticks played again since the ring ran empty
+    } audio;
 
     tic_tick_data* data;
 
     tic_machine_state_data state;
 
+    tic_tilecache tilecache;
+    tic_music_cache musiccache;
+    tic_blit_palette blitpal;
+    bool blitScalar;                    // the SIMD blit kernels are skipped, see tic_core_blit_simd
+    tic_dirty_rows dirty;
+    tic_sides_buffer sides;
+    tic_map_layer maplayer;
+    tic_glyph_cache glyphs;
+    tic_sheet_texture texture;
+    tic_drawlist* drawlist;             // NULL unless the draw thread is enabled
+    u64 random;                         // generator of the script random functions, see tic_core_random
+    tic_overdraw_counts overdraw;
+    tic_screen targets[TIC_TARGETS];
+
     struct
     {
         tic_machine_state_data state;   
@@ -414,7 +414,7 @@ static void drawSheetReg(Map* map, s32 x, s32 y)
         }
     }
 
-    tiles2ram(&tic->ram, getBankTiles());
+    tiles2ram(tic, getBankTiles());
     for(s32 j = 0, index = 0; j < rect.h; j += TIC_SPRITESIZE)
         for(s32 i = 0; i < rect.w; i += TIC_SPRITESIZE, index++)
             tic_api_spr(tic, index, x + i, y + j, 1, 1, NULL, 0, 1, tic_no_flip, tic_no_rotate);
@@ -490,7 +490,7 @@ static void drawTileCursor(Map* map)
         s32 sx = map->sheet.rect.x;
         s32 sy = map->sheet.rect.y;
 
-        tiles2ram(&tic->ram, getBankTiles());
+        tiles2ram(tic, getBankTiles());
 
         for(s32 j = 0, ty=pos.y; j < map->sheet.rect.h; j++, ty+=TIC_SPRITESIZE)
             for(s32 i = 0, tx=pos.x; i < map->sheet.rect.w; i++, tx+=TIC_SPRITESIZE)
@@ -653,7 +653,7 @@ static void drawPasteData(Map* map)
         mx += -map->scroll.x;
         my += -map->scroll.y;
 
-        tiles2ram(&tic->ram, getBankTiles());
+        tiles2ram(tic, getBankTiles());
         for(s32 j = 0; j < h; j++)
             for(s32 i = 0; i < w; i++)
                 tic_api_spr(tic, data[i + j * w], mx + i*TIC_SPRITESIZE, my + j*TIC_SPRITESIZE, 1, 1, NULL, 0, 1, tic_no_flip, tic_no_rotate);
@@ -933,7 +933,7 @@ static void drawMapReg(Map* map)
     tic_mem* tic = map->tic;
 
     map2ram(&tic->ram, map->src);
-    tiles2ram(&tic->ram, getBankTiles());
+    tiles2ram(tic, getBankTiles());
     tic_api_map(tic, map->scroll.x / TIC_SPRITESIZE, map->scroll.y / TIC_SPRITESIZE,
         TIC_MAP_SCREEN_WIDTH + 1, TIC_MAP_SCREEN_HEIGHT + 1, -scrollX, -scrollY, 0, 0, 1, NULL, NULL);
 
@@ -125,7 +125,7 @@ static void drawDialog(Menu* menu)
 
     {
         u8 chromakey = 14;
-        tiles2ram(&tic->ram, &getConfig()->cart->bank0.tiles);
+        tiles2ram(tic, &getConfig()->cart->bank0.tiles);
         tic_api_spr(tic, 0, rect.x+6, rect.y-4, 2, 2, &chromakey, 1, 1, tic_no_flip, tic_no_rotate);
     }   
 }
@@ -0,0 +1,788 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Runs a cart for a number of frames without any window or audio device
+// and reports the frame times and hashes of the produced video and audio.
+//
+// usage: tic80-headless <cart> [-frames N] [-input file] [-budget ms] [-phases] [-blit]
+//        tic80-headless <cart> -compare-threads [-frames N] [-input file]
+//        tic80-headless <cart> -compare-instances N [-frames N] [-input file]
+//        tic80-headless <cart> -export-music|-export-sfx
+//
+// <cart> is a .tic cartridge or a project file (.lua, .js, .moon, ...).
+// The input file holds "<frame> <gamepads> [<keyboard>]" lines with hex
+// values of tic80_gamepads.data and tic80_keyboard.data, every line is held
+// until the next one. With -budget the exit code is non-zero if the 99th
+// percentile of the frame time exceeds the given milliseconds. -phases prints
+// the average time of every frame phase, END is mostly the sound synthesis.
+// -blit converts the last frame to every pixel format a thousand times and
+// prints the average blit time with all rows changed / with none changed,
+// for the scalar table lookup and for the SIMD kernels.
+// -compare-threads runs the cart with and without the draw thread and exits
+// with 3 at the first frame where the screens are not bit for bit the same.
+// -compare-instances runs the cart on one machine and on N more machines at
+// once, each on its own thread, and exits with 3 at the first frame where the
+// screen or the sound of one of them differs from the first machine.
+// The export modes render all the music tracks or all the non empty sfx in
+// parallel to "track N.wav" or "sfx N.wav" files in the current folder.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include <tic80.h>
+#include "project.h"
+#include "tools.h"
+#include "ticapi.h"
+#include "audiorender.h"
+#include "wave_writer.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#   if defined(TIC80_THREADS)
+#   include <pthread.h>
+#   endif
+#endif
+
+#define DEFAULT_FRAMES 600
+
+typedef struct
+{
+    s32 frame;
+    tic80_input input;
+} InputEvent;
+
+static struct
+{
+    bool quit;
+    bool error;
+} state =
+{
+    .quit = false,
+    .error = false,
+};
+
+static void onExit()
+{
+    state.quit = true;
+}
+
+static void onError(const char* info)
+{
+    fprintf(stderr, "error: %s\n", info);
+    state.error = true;
+}
+
+static void onTrace(const char* text, u8 color)
+{
+    printf("%s\n", text);
+}
+
+static double getTime()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, freq;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&freq);
+    return (double)counter.QuadPart * 1000.0 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+static u64 getCounter(void* data)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static u64 getCounterFrequency()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return freq.QuadPart;
+#else
+    return 1000000000ull;
+#endif
+}
+
+static u64 hash(const void* data, s32 size, u64 value)
+{
+    for(const u8 *ptr = data, *end = ptr + size; ptr != end; ptr++)
+        value = (value ^ *ptr) * 1099511628211ull;
+
+    return value;
+}
+
+static void* loadFile(const char* name, s32* size)
+{
+    FILE* file = fopen(name, "rb");
+    void* buffer = NULL;
+
+    if(file)
+    {
+        fseek(file, 0, SEEK_END);
+        *size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        buffer = *size >= 0 ? malloc(*size + 1) : NULL;
+
+        if(buffer && fread(buffer, *size, 1, file) == 1)
+            ((char*)buffer)[*size] = '\0';
+        else
+        {
+            fprintf(stderr, "cannot read file: %s\n", name);
+            free(buffer);
+            buffer = NULL;
+        }
+
+        fclose(file);
+    }
+
+    return buffer;
+}
+
+// projects are converted to the cartridge format tic80_load expects
+static void* loadCart(const char* name, s32* size)
+{
+    void* data = loadFile(name, size);
+
+    if(data && !tic_tool_has_ext(name, ".tic"))
+    {
+        tic_cartridge* cart = calloc(1, sizeof(tic_cartridge));
+        u8* out = malloc(sizeof(tic_cartridge));
+
+        if(cart && out && tic_project_load(name, data, *size, cart))
+        {
+            *size = tic_cart_save(cart, out);
+            free(data);
+            data = out;
+            out = NULL;
+        }
+        else
+        {
+            free(data);
+            data = NULL;
+        }
+
+        free(out);
+        free(cart);
+    }
+
+    return data;
+}
+
+static InputEvent* loadInput(const char* name, s32* count)
+{
+    FILE* file = fopen(name, "r");
+    InputEvent* events = NULL;
+    *count = 0;
+
+    if(file)
+    {
+        char line[256];
+        while(fgets(line, sizeof line, file))
+        {
+            InputEvent event = {0};
+            unsigned int gamepads = 0, keyboard = 0;
+
+            if(sscanf(line, "%d %x %x", &event.frame, &gamepads, &keyboard) < 2)
+                continue;
+
+            event.input.gamepads.data = gamepads;
+            event.input.keyboard.data = keyboard;
+
+            InputEvent* tmp = realloc(events, sizeof(InputEvent) * (*count + 1));
+            if(!tmp) break;
+
+            events = tmp;
+            events[(*count)++] = event;
+        }
+
+        fclose(file);
+    }
+    else fprintf(stderr, "cannot open input file: %s\n", name);
+
+    return events;
+}
+
+static bool isSfxEmpty(const tic_sample* effect)
+{
+    for(s32 i = 0; i < sizeof(tic_sample); i++)
+        if(((const u8*)effect)[i])
+            return false;
+
+    return true;
+}
+
+static s32 exportAudio(tic_mem* memory, bool sfx)
+{
+    const tic_bank* bank = &memory->cart.banks[0];
+    tic_audio_source source = {.sfx = &bank->sfx, .music = &bank->music, .samplerate = TIC80_SAMPLERATE};
+    tic_audio_job jobs[SFX_COUNT];
+    s32 count = 0;
+
+    for(s32 i = 0; i < (sfx ? SFX_COUNT : MUSIC_TRACKS); i++)
+        if(!sfx || !isSfxEmpty(&bank->sfx.samples.data[i]))
+            jobs[count++] = (tic_audio_job){.sfx = sfx, .index = i};
+
+    double start = getTime();
+    bool ok = tic_audio_render(&source, jobs, count);
+    double time = getTime() - start;
+
+    for(s32 i = 0; i < count; i++)
+    {
+        if(ok)
+        {
+            char name[32];
+            sprintf(name, sfx ? "sfx %i.wav" : "track %i.wav", jobs[i].index);
+
+            wave_open(TIC80_SAMPLERATE, name);
+            wave_enable_stereo();
+            wave_write(jobs[i].samples, jobs[i].count * TIC_STEREO_CHANNELS);
+            wave_close();
+
+            printf("%s: %.2f s\n", name, (double)jobs[i].count / TIC80_SAMPLERATE);
+        }
+
+        free(jobs[i].samples);
+    }
+
+    if(!ok)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("rendered %d files in %.3f ms\n", count, time);
+    return 0;
+}
+
+static tic80* createTic(void* cart, s32 size)
+{
+    tic80* tic = tic80_create(TIC80_SAMPLERATE);
+
+    if(tic)
+    {
+        tic->callback.exit = onExit;
+        tic->callback.error = onError;
+        tic->callback.trace = onTrace;
+
+        tic80_load(tic, cart, size);
+
+        // every run draws the same random numbers, so the screens and hashes can be compared
+        tic_core_random_seed(((tic80_local*)tic)->memory, 0);
+    }
+
+    return tic;
+}
+
+// runs the cart on two machines, one of them drawing TIC() on the draw thread,
+// and compares the screens after every frame
+static s32 compareThreads(void* cart, s32 size, const InputEvent* events, s32 eventsCount, s32 frames)
+{
+    tic80* serial = createTic(cart, size);
+    tic80* threaded = createTic(cart, size);
+    s32 res = 0;
+
+    if(!serial || !threaded)
+    {
+        fprintf(stderr, "out of memory\n");
+        res = -1;
+    }
+    else if(!tic_core_draw_thread(((tic80_local*)threaded)->memory, true))
+    {
+        fprintf(stderr, "the build has no draw thread\n");
+        res = -1;
+    }
+    else
+    {
+        tic80_input input = {0};
+        s32 frame = 0;
+
+        for(s32 event = 0; frame < frames && !state.quit && !state.error; frame++)
+        {
+            while(event < eventsCount && events[event].frame <= frame)
+                input = events[event++].input;
+
+            tic80_tick(serial, &input);
+            tic80_tick(threaded, &input);
+
+            s32 diff = 0;
+            for(s32 i = 0; i < TIC80_FULLWIDTH * TIC80_FULLHEIGHT; i++)
+                if(serial->screen[i] != threaded->screen[i])
+                    diff++;
+
+            if(diff)
+            {
+                printf("frame %d: %d pixels differ\n", frame, diff);
+                res = 3;
+                break;
+            }
+        }
+
+        printf("frames: %d\n", frame);
+
+        if(state.error)
+            res = 1;
+        else if(res == 0)
+            printf("screens match\n");
+    }
+
+    if(threaded) tic80_delete(threaded);
+    if(serial) tic80_delete(serial);
+
+    return res;
+}
+
+typedef struct
+{
+    tic80* tic;
+    const InputEvent* events;
+    s32 eventsCount;
+    s32 event;          // next input event
+    tic80_input input;
+    s32 first;          // first frame of the chunk
+    s32 count;          // frames in the chunk
+    u8* frames;         // screens and sound of the chunk
+} Instance;
+
+static s32 frameSize(const tic80* tic)
+{
+    return TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32) + tic->sound.count * sizeof(s16);
+}
+
+// ticks the frames of the chunk and keeps the screen and the sound of each of them
+static void runChunk(Instance* instance)
+{
+    tic80* tic = instance->tic;
+    u8* out = instance->frames;
+
+    for(s32 i = 0; i < instance->count; i++)
+    {
+        s32 frame = instance->first + i;
+
+        while(instance->event < instance->eventsCount && instance->events[instance->event].frame <= frame)
+            instance->input = instance->events[instance->event++].input;
+
+        tic80_tick(tic, &instance->input);
+
+        memcpy(out, tic->screen, TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32));
+        out += TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32);
+        memcpy(out, tic->sound.samples, tic->sound.count * sizeof(s16));
+        out += tic->sound.count * sizeof(s16);
+    }
+}
+
+#if defined(TIC80_THREADS)
+
+#if defined(_WIN32)
+static DWORD WINAPI chunkThread(LPVOID data) {runChunk(data); return 0;}
+#else
+static void* chunkThread(void* data) {runChunk(data); return NULL;}
+#endif
+
+// runs the cart on a reference machine alone and on count machines at once, each on its own thread,
+// and compares every frame of the machines bit for bit with the reference one,
+// the frames are run in chunks of a second so the kept screens stay small
+static s32 compareInstances(void* cart, s32 size, const InputEvent* events, s32 eventsCount, s32 frames, s32 count)
+{
+    enum {MaxInstances = 64, Chunk = TIC80_FRAMERATE};
+
+    count = CLAMP(count, 1, MaxInstances);
+
+    // the first one is the reference
+    Instance instances[MaxInstances + 1] = {0};
+    s32 res = 0;
+
+    for(s32 i = 0; i <= count; i++)
+    {
+        Instance* instance = &instances[i];
+
+        instance->tic = createTic(cart, size);
+        instance->events = events;
+        instance->eventsCount = eventsCount;
+
+        if(!instance->tic || !(instance->frames = malloc(frameSize(instance->tic) * Chunk)))
+        {
+            fprintf(stderr, "out of memory\n");
+            res = -1;
+            break;
+        }
+    }
+
+    s32 frame = 0;
+
+    for(; res == 0 && frame < frames && !state.quit && !state.error; frame += Chunk)
+    {
+        for(s32 i = 0; i <= count; i++)
+        {
+            instances[i].first = frame;
+            instances[i].count = MIN(Chunk, frames - frame);
+        }
+
+        runChunk(&instances[0]);
+
+#if defined(_WIN32)
+        HANDLE handles[MaxInstances];
+#else
+        pthread_t handles[MaxInstances];
+#endif
+
+        for(s32 i = 0; i < count && res == 0; i++)
+        {
+#if defined(_WIN32)
+            bool started = (handles[i] = CreateThread(NULL, 0, chunkThread, &instances[i + 1], 0, NULL)) != NULL;
+#else
+            bool started = pthread_create(&handles[i], NULL, chunkThread, &instances[i + 1]) == 0;
+#endif
+            if(!started)
+            {
+                fprintf(stderr, "cannot start thread %d\n", i + 1);
+                res = -1;
+
+                // the ones already started are still joined
+                count = i;
+            }
+        }
+
+        for(s32 i = 0; i < count; i++)
+        {
+#if defined(_WIN32)
+            WaitForSingleObject(handles[i], INFINITE);
+            CloseHandle(handles[i]);
+#else
+            pthread_join(handles[i], NULL);
+#endif
+        }
+
+        s32 bytes = frameSize(instances[0].tic);
+
+        for(s32 i = 1; i <= count && res == 0; i++)
+            for(s32 f = 0; f < instances[i].count; f++)
+            {
+                const u8* reference = instances[0].frames + f * bytes;
+                const u8* other = instances[i].frames + f * bytes;
+                enum {ScreenSize = TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32)};
+
+                bool screen = memcmp(reference, other, ScreenSize) == 0;
+                bool sound = memcmp(reference + ScreenSize, other + ScreenSize, bytes - ScreenSize) == 0;
+
+                if(!screen || !sound)
+                {
+                    printf("frame %d: %s of instance %d differs\n", frame + f, screen ? "sound" : "screen", i);
+                    res = 3;
+                    break;
+                }
+            }
+    }
+
+    printf("frames: %d\n", MIN(frame, frames));
+
+    if(state.error)
+        res = 1;
+    else if(res == 0)
+        printf("%d instances match\n", count);
+
+    for(s32 i = 0; i < COUNT_OF(instances); i++)
+    {
+        if(instances[i].tic) tic80_delete(instances[i].tic);
+        free(instances[i].frames);
+    }
+
+    return res;
+}
+
+#else
+
+static s32 compareInstances(void* cart, s32 size, const InputEvent* events, s32 eventsCount, s32 frames, s32 count)
+{
+    fprintf(stderr, "the build has no threads\n");
+    return -1;
+}
+
+#endif
+
+// times the conversion of the last frame to every pixel format, once with all the screen rows
+// changed and once with none of them, with the table lookup and with the SIMD kernels if the build has them
+static void timeBlit(tic_mem* memory)
+{
+    static const struct {tic80_pixel_color_format format; const char* label;} Formats[] =
+    {
+        {TIC80_PIXEL_COLOR_ARGB8888, "ARGB"},
+        {TIC80_PIXEL_COLOR_ABGR8888, "ABGR"},
+        {TIC80_PIXEL_COLOR_RGBA8888, "RGBA"},
+        {TIC80_PIXEL_COLOR_BGRA8888, "BGRA"},
+    };
+
+    enum {Count = 1000};
+
+    for(s32 simd = 0; simd < 2; simd++)
+    {
+        if(!tic_core_blit_simd(memory, simd) && simd)
+        {
+            printf("blit ms (simd): the build has no SIMD kernels\n");
+            break;
+        }
+
+        printf("blit ms (%s):", simd ? "simd" : "scalar");
+
+        for(s32 f = 0; f < COUNT_OF(Formats); f++)
+        {
+            double changed = 0, unchanged = 0;
+
+            for(s32 i = 0; i < Count; i++)
+            {
+                tic_core_invalidate(memory, offsetof(tic_ram, vram.screen), sizeof(tic_screen));
+
+                double start = getTime();
+                tic_core_blit_ex(memory, Formats[f].format, NULL, NULL, NULL);
+                changed += getTime() - start;
+            }
+
+            for(s32 i = 0; i < Count; i++)
+            {
+                double start = getTime();
+                tic_core_blit_ex(memory, Formats[f].format, NULL, NULL, NULL);
+                unchanged += getTime() - start;
+            }
+
+            printf(" %s %.4f/%.4f", Formats[f].label, changed / Count, unchanged / Count);
+        }
+
+        printf("\n");
+    }
+
+    tic_core_blit_simd(memory, true);
+    tic_core_invalidate(memory, offsetof(tic_ram, vram.screen), sizeof(tic_screen));
+    tic_core_blit(memory, memory->screen_format);
+}
+
+static int compareTime(const void* a, const void* b)
+{
+    double left = *(const double*)a, right = *(const double*)b;
+    return left < right ? -1 : left > right;
+}
+
+static double percentile(const double* sorted, s32 count, s32 p)
+{
+    s32 index = (count - 1) * p / 100;
+    return sorted[index];
+}
+
+int main(int argc, char **argv)
+{
+    const char* cartName = NULL;
+    const char* inputName = NULL;
+    s32 frames = DEFAULT_FRAMES;
+    double budget = 0;
+    bool phases = false;
+    bool compare = false;
+    s32 instances = 0;
+    bool blit = false;
+    enum {ExportNone, ExportMusic, ExportSfx} exportMode = ExportNone;
+
+    for(s32 i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+
+        if(strcmp(arg, "-frames") == 0 && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else if(strcmp(arg, "-input") == 0 && i + 1 < argc)
+            inputName = argv[++i];
+        else if(strcmp(arg, "-budget") == 0 && i + 1 < argc)
+            budget = atof(argv[++i]);
+        else if(strcmp(arg, "-phases") == 0)
+            phases = true;
+        else if(strcmp(arg, "-blit") == 0)
+            blit = true;
+        else if(strcmp(arg, "-compare-threads") == 0)
+            compare = true;
+        else if(strcmp(arg, "-compare-instances") == 0 && i + 1 < argc)
+            instances = atoi(argv[++i]);
+        else if(strcmp(arg, "-export-music") == 0)
+            exportMode = ExportMusic;
+        else if(strcmp(arg, "-export-sfx") == 0)
+            exportMode = ExportSfx;
+        else cartName = arg;
+    }
+
+    if(!cartName || frames <= 0)
+    {
+        printf("usage: tic80-headless <cart> [-frames N] [-input file] [-budget ms] [-phases] [-blit]\n");
+        printf("       tic80-headless <cart> -compare-threads [-frames N] [-input file]\n");
+        printf("       tic80-headless <cart> -compare-instances N [-frames N] [-input file]\n");
+        printf("       tic80-headless <cart> -export-music|-export-sfx\n");
+        return -1;
+    }
+
+    s32 size = 0;
+    void* cart = loadCart(cartName, &size);
+
+    if(!cart)
+    {
+        fprintf(stderr, "cannot load cart: %s\n", cartName);
+        return -1;
+    }
+
+    s32 eventsCount = 0;
+    InputEvent* events = inputName ? loadInput(inputName, &eventsCount) : NULL;
+
+    if(compare || instances > 0)
+    {
+        s32 res = compare
+            ? compareThreads(cart, size, events, eventsCount, frames)
+            : compareInstances(cart, size, events, eventsCount, frames, instances);
+
+        free(events);
+        free(cart);
+
+        return res;
+    }
+
+    tic80* tic = createTic(cart, size);
+    free(cart);
+
+    if(!tic)
+    {
+        free(events);
+        return -1;
+    }
+
+    tic_mem* memory = ((tic80_local*)tic)->memory;
+    u64 phaseTotals[tic_profile_phases] = {0};
+
+    if(exportMode != ExportNone)
+    {
+        s32 res = exportAudio(memory, exportMode == ExportSfx);
+
+        free(events);
+        tic80_delete(tic);
+
+        return res;
+    }
+
+    if(phases)
+        tic_core_profile_enable(memory, getCounter, getCounterFrequency(), NULL);
+
+    double* times = malloc(sizeof(double) * frames);
+
+    if(!times)
+    {
+        fprintf(stderr, "out of memory\n");
+
+        free(events);
+        tic80_delete(tic);
+
+        return -1;
+    }
+
+    tic80_input input = {0};
+    u64 audioHash = 14695981039346656037ull;
+    s32 frame = 0;
+
+    double start = getTime();
+
+    for(s32 event = 0; frame < frames && !state.quit && !state.error; frame++)
+    {
+        while(event < eventsCount && events[event].frame <= frame)
+            input = events[event++].input;
+
+        if(phases)
+            tic_core_profile_frame(memory);
+
+        double tickStart = getTime();
+        tic80_tick(tic, &input);
+        times[frame] = getTime() - tickStart;
+
+        if(phases)
+            for(s32 p = 0; p < tic_profile_phases; p++)
+                phaseTotals[p] += memory->profile.frames[memory->profile.frame % TIC_PROFILE_FRAMES][p];
+
+        audioHash = hash(tic->sound.samples, tic->sound.count * sizeof(tic->sound.samples[0]), audioHash);
+    }
+
+    double total = getTime() - start;
+
+    u64 screenHash = hash(tic->screen, TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32), 14695981039346656037ull);
+
+    qsort(times, frame, sizeof times[0], compareTime);
+
+    printf("frames: %d\n", frame);
+    printf("total: %.3f ms\n", total);
+    printf("fps: %.2f\n", frame / (total / 1000.0));
+
+    if(frame)
+        printf("frame ms: min %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n",
+            times[0], percentile(times, frame, 50), percentile(times, frame, 90),
+            percentile(times, frame, 99), times[frame - 1]);
+
+    if(phases && frame)
+    {
+        static const char* Labels[] =
+        {
+#define PROFILE_PHASE_DEF(_, label) label,
+            TIC_PROFILE_LIST(PROFILE_PHASE_DEF)
+#undef PROFILE_PHASE_DEF
+        };
+
+        printf("phase ms:");
+
+        for(s32 p = 0; p < tic_profile_phases; p++)
+            printf(" %s %.4f", Labels[p], phaseTotals[p] * 1000.0 / memory->profile.freq / frame);
+
+        printf("\n");
+    }
+
+    if(blit && frame)
+        timeBlit(memory);
+
+    printf("screen hash: %016llx\n", (unsigned long long)screenHash);
+    printf("audio hash: %016llx\n", (unsigned long long)audioHash);
+
+    s32 res = state.error ? 1 : 0;
+
+    if(budget > 0 && frame && percentile(times, frame, 99) > budget)
+    {
+        printf("p99 frame time exceeds the %g ms budget\n", budget);
+        res = 2;
+    }
+
+    free(times);
+    free(events);
+    tic80_delete(tic);
+
+    return res;
+}
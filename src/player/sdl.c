@@ -171,9 +171,14 @@ int main(int argc, char **argv)
 							void* pixels = NULL;
 							int pitch = 0;
 							SDL_Rect destination;
-							SDL_LockTexture(texture, NULL, &pixels, &pitch);
-							SDL_memcpy(pixels, tic->screen, pitch * TIC80_FULLHEIGHT);
-							SDL_UnlockTexture(texture);
+
+							// Keep the previous texture if no rows have changed.
+							if (tic->dirty)
+							{
+								SDL_LockTexture(texture, NULL, &pixels, &pitch);
+								SDL_memcpy(pixels, tic->screen, pitch * TIC80_FULLHEIGHT);
+								SDL_UnlockTexture(texture);
+							}
 
 							// Render the image in the proper aspect ratio.
 							{
@@ -52,7 +52,7 @@ static void app_frame(void)
     if(tic)
         tic80_tick(tic, &tic_input);
 
-    sokol_gfx_draw(tic->screen);
+    sokol_gfx_draw(tic->dirty ? tic->screen : NULL);
 
     static float floatSamples[TIC80_SAMPLERATE / TIC80_FRAMERATE * 2];
 
@@ -5,7 +5,6 @@
 #include <string.h>
 #include "quickjs.h"
 
-static u64 ForceExitCounter = 0;
 //static const char[] TicMachine = "_TIC80"
 static JSClassID TicMachineID;
 static JSClassDef TicMachine = {
@@ -17,7 +16,7 @@ s32 qjs_timeout_check(void* udata)
     tic_machine* machine = (tic_machine*)udata;
     tic_tick_data* tick = machine->data;
 
-    return ForceExitCounter++ > 1000 ? tick->forceExit && tick->forceExit(tick->data) : false;
+    return machine->forceExitCounter++ > 1000 ? tick->forceExit && tick->forceExit(tick->data) : false;
 }
 
 static tic_machine* getQuickJSMachine(JSContext* ctx)
@@ -33,6 +32,13 @@ static JSValue qjs_reset(JSContext* ctx, JSValueConst this, int argc, JSValueCon
     return JS_UNDEFINED;
 }
 
+// Math.random on the generator of the machine, 53 random bits like the builtin one
+static JSValue qjs_random(JSContext* ctx, JSValueConst this, int argc, JSValueConst* argv) {
+    tic_mem* tic = (tic_mem*)getQuickJSMachine(ctx);
+    u64 bits = ((u64)tic_core_random(tic) << 21) ^ (tic_core_random(tic) >> 11);
+    return JS_NewFloat64(ctx, bits / 9007199254740992.0);
+}
+
 static JSValue qjs_cls(JSContext* ctx, JSValueConst this, int argc, JSValueConst *argv) {
     tic_mem* tic = (tic_mem*)getQuickJSMachine(ctx);
     s32 color = 0;
@@ -152,6 +158,12 @@ static void closeQJavascript(tic_mem* tic)
     if(machine->qjs_rt) JS_RunGC(machine->qjs_rt);
     if(machine->qjs)
     {
+        JS_FreeValue(machine->qjs, machine->qjsTick);
+        JS_FreeValue(machine->qjs, machine->qjsScanline);
+        JS_FreeValue(machine->qjs, machine->qjsOverline);
+        machine->qjsTick = JS_UNDEFINED;
+        machine->qjsScanline = JS_UNDEFINED;
+        machine->qjsOverline = JS_UNDEFINED;
         free(machine->qjs);
         machine->qjs = NULL;
     }
@@ -162,24 +174,41 @@ static void closeQJavascript(tic_mem* tic)
     }
 }
 
+// TIC, SCN and OVR are looked up after the code is loaded and after every TIC() call,
+// so a cart can reassign them from TIC(), the machine doesn't call the ones that aren't defined
+static void resolveQJavascriptCallbacks(tic_machine* machine)
+{
+    JSContext* ctx = machine->qjs;
+    JSValue glob = JS_GetGlobalObject(ctx);
+    JS_FreeValue(ctx, machine->qjsTick);
+    JS_FreeValue(ctx, machine->qjsScanline);
+    JS_FreeValue(ctx, machine->qjsOverline);
+    machine->qjsTick = JS_GetPropertyStr(ctx, glob, TIC_FN);
+    machine->qjsScanline = JS_GetPropertyStr(ctx, glob, SCN_FN);
+    machine->qjsOverline = JS_GetPropertyStr(ctx, glob, OVR_FN);
+    JS_FreeValue(ctx, glob);
+
+    tic_core_script_callbacks(&machine->memory,
+        JS_IsFunction(ctx, machine->qjsScanline), JS_IsFunction(ctx, machine->qjsOverline));
+}
+
 static void callQJavascriptTick(tic_mem* tic)
 {
-    ForceExitCounter = 0;
     tic_machine* machine = (tic_machine*)tic;
+    machine->forceExitCounter = 0;
     JSContext* ctx = machine->qjs;
     if (ctx)
     {
         JSValue glob = JS_GetGlobalObject(ctx);
-        JSValue ticfunc = JS_GetPropertyStr(ctx, glob, "TIC");
-        JSValue result = JS_Call(ctx, ticfunc, glob, 0, NULL);
+        JSValue result = JS_Call(ctx, machine->qjsTick, glob, 0, NULL);
         if (JS_IsException(result)) {
             const char* str = JS_ToCString(ctx, JS_GetException(ctx));
             machine->data->error(machine->data->data, str);
             JS_FreeCString(ctx, str);
         }
         JS_FreeValue(ctx, result);
-        JS_FreeValue(ctx, ticfunc);
         JS_FreeValue(ctx, glob);
+        resolveQJavascriptCallbacks(machine);
     }
 }
 
@@ -188,34 +217,32 @@ static void callQJavascriptScanline(tic_mem* tic, s32 row, void* data)
     tic_machine* machine = (tic_machine*)tic;
     JSContext* ctx = machine->qjs;
     JSValue glob = JS_GetGlobalObject(ctx);
-    JSValue scnfunc = JS_GetPropertyStr(ctx, glob, "SCN");
-    JSValue args = JS_NewInt32(ctx, row);
-    JSValue result = JS_Call(ctx, scnfunc, glob, 1, &args);
-    if (JS_IsException(result)) {
-        machine->data->error(machine->data->data, JS_ToCString(ctx, JS_GetException(ctx)));
+    if (JS_IsFunction(ctx, machine->qjsScanline)) {
+        JSValue args = JS_NewInt32(ctx, row);
+        JSValue result = JS_Call(ctx, machine->qjsScanline, glob, 1, &args);
+        if (JS_IsException(result)) {
+            machine->data->error(machine->data->data, JS_ToCString(ctx, JS_GetException(ctx)));
+        }
+        JS_FreeValue(ctx, args);
+        JS_FreeValue(ctx, result);
     }
     JS_FreeValue(ctx, glob);
-    JS_FreeValue(ctx, scnfunc);
-    JS_FreeValue(ctx, args);
-    JS_FreeValue(ctx, result);
 }
 
 static void callQJavascriptOverline(tic_mem* tic, void* data)
 {
-    ForceExitCounter = 0;
     tic_machine* machine = (tic_machine*)tic;
+    machine->forceExitCounter = 0;
     JSContext* ctx = machine->qjs;
-    if (ctx)
+    if (ctx && JS_IsFunction(ctx, machine->qjsOverline))
     {
         JSValue glob = JS_GetGlobalObject(ctx);
-        JSValue ticfunc = JS_GetPropertyStr(ctx, glob, "OVR");
-        JSValue result = JS_Call(ctx, ticfunc, glob, 0, NULL);
+        JSValue result = JS_Call(ctx, machine->qjsOverline, glob, 0, NULL);
         if (JS_IsException(result)) {
             machine->data->error(machine->data->data, JS_ToCString(ctx, JS_GetException(ctx)));
         }
-        JS_FreeValue(ctx, glob);
-        JS_FreeValue(ctx, ticfunc);
         JS_FreeValue(ctx, result);
+        JS_FreeValue(ctx, glob);
     }
 }
 
@@ -235,6 +262,9 @@ static void initQuickJS(tic_machine* machine)
     closeQJavascript((tic_mem*)machine);
     machine->qjs_rt = JS_NewRuntime();
     machine->qjs = JS_NewContext(machine->qjs_rt);
+    machine->qjsTick = JS_UNDEFINED;
+    machine->qjsScanline = JS_UNDEFINED;
+    machine->qjsOverline = JS_UNDEFINED;
     JS_AddModuleExport(machine->qjs, QJsApiModule(machine->qjs, "tic80"), "tic80");
 }
 
@@ -247,6 +277,13 @@ static bool initQJavascript(tic_mem* tic, const char* code)
     JSValue tic_js = JS_NewObjectClass(ctx, TicMachineID);
     JS_SetOpaque(tic_js, machine);
     JS_SetPropertyStr(ctx, JS_GetGlobalObject(ctx), "_TIC80", tic_js);
+    {
+        JSValue glob = JS_GetGlobalObject(ctx);
+        JSValue math = JS_GetPropertyStr(ctx, glob, "Math");
+        JS_SetPropertyStr(ctx, math, "random", JS_NewCFunction(ctx, qjs_random, "random", 0));
+        JS_FreeValue(ctx, math);
+        JS_FreeValue(ctx, glob);
+    }
     JSValue r = JS_Eval(ctx, code, strlen(code), "<input>", JS_EVAL_TYPE_MODULE);
     if (JS_IsException(r)) {
         machine->data->error(machine->data->data,
@@ -254,6 +291,7 @@ static bool initQJavascript(tic_mem* tic, const char* code)
         return false;
     }
     JS_FreeValue(ctx, r);
+    resolveQJavascriptCallbacks(machine);
     return true;
 }
 
@@ -288,6 +326,8 @@ static const tic_script_config QJsSyntaxConfig =
 
     .keywords           = QJsKeywords,
     .keywordsCount      = COUNT_OF(QJsKeywords),
+
+    .name               = "qjs",
 };
 
 const tic_script_config* getQJsScriptConfig()
@@ -48,6 +48,119 @@ static void onExit(void* data)
     run->exit = true;
 }
 
+#if defined(__VERSION__)
+#   define CODE_CACHE_BUILD __VERSION__
+#elif defined(_MSC_FULL_VER)
+#   define CODE_CACHE_BUILD DEF2STR(_MSC_FULL_VER)
+#else
+#   define CODE_CACHE_BUILD ""
+#endif
+
+// the cache folder is versioned, the compiler goes into the key
+static void codeCacheKey(char* key, const char* name, const char* code)
+{
+    enum{Size = 16};
+    u8 digest[Size];
+    MD5_CTX c;
+
+    MD5_Init(&c);
+    MD5_Update(&c, CODE_CACHE_BUILD, sizeof CODE_CACHE_BUILD);
+    MD5_Update(&c, name, strlen(name) + 1);
+    MD5_Update(&c, code, strlen(code));
+    MD5_Final(digest, &c);
+
+    for (s32 n = 0; n < Size; ++n)
+        snprintf(key + n*2, sizeof("ff"), "%02x", digest[n]);
+}
+
+// a name has at most 16 files picked by the first key digit, a file starts with the key of its code
+static void codeCachePath(char* path, s32 size, const char* name, const char* key)
+{
+    snprintf(path, size, TIC_CODE_CACHE "%s.%c", name, key[0]);
+}
+
+static void* copyCode(const void* data, s32 size)
+{
+    void* copy = malloc(size);
+
+    if(copy)
+        memcpy(copy, data, size);
+
+    return copy;
+}
+
+static void keepCode(RunCodeCache* cache, const char* key, const void* data, s32 size)
+{
+    s32 index = cache->next++ % COUNT_OF(cache->items);
+    void* copy = copyCode(data, size);
+
+    free(cache->items[index].data);
+    cache->items[index].data = copy;
+    cache->items[index].size = copy ? size : 0;
+    strcpy(cache->items[index].key, key);
+}
+
+static void* onLoadCache(void* data, const char* name, const char* code, s32* size)
+{
+    Run* run = (Run*)data;
+    RunCodeCache* cache = &run->cache;
+    char key[sizeof cache->items[0].key];
+    char path[TICNAME_MAX];
+
+    codeCacheKey(key, name, code);
+
+    for(s32 i = 0; i < COUNT_OF(cache->items); i++)
+        if(cache->items[i].data && strcmp(cache->items[i].key, key) == 0)
+        {
+            *size = cache->items[i].size;
+            return copyCode(cache->items[i].data, cache->items[i].size);
+        }
+
+    codeCachePath(path, sizeof path, name, key);
+
+    enum {KeySize = sizeof key - 1};
+    s32 fileSize = 0;
+    u8* buffer = fsLoadRootFile(run->console->fs, path, &fileSize);
+
+    // another code in the same file is a miss
+    if(buffer && (fileSize < KeySize || memcmp(buffer, key, KeySize) != 0))
+    {
+        free(buffer);
+        buffer = NULL;
+    }
+
+    if(buffer)
+    {
+        *size = fileSize - KeySize;
+        memmove(buffer, buffer + KeySize, *size);
+        keepCode(cache, key, buffer, *size);
+    }
+
+    return buffer;
+}
+
+static void onSaveCache(void* data, const char* name, const char* code, const void* buffer, s32 size)
+{
+    Run* run = (Run*)data;
+    char key[sizeof run->cache.items[0].key];
+    char path[TICNAME_MAX];
+
+    codeCacheKey(key, name, code);
+    codeCachePath(path, sizeof path, name, key);
+    keepCode(&run->cache, key, buffer, size);
+
+    enum {KeySize = sizeof key - 1};
+    u8* file = malloc(KeySize + size);
+
+    if(file)
+    {
+        memcpy(file, key, KeySize);
+        memcpy(file + KeySize, buffer, size);
+        fsSaveRootFile(run->console->fs, path, file, KeySize + size, true);
+        free(file);
+    }
+}
+
 static const char* data2md5(const void* data, s32 length)
 {
     const char *str = data;
@@ -117,6 +230,16 @@ static void tick(Run* run)
         setStudioMode(TIC_CONSOLE_MODE);
 }
 
+static u64 getCounter(void* data)
+{
+    return getSystem()->getPerformanceCounter();
+}
+
+static u64 getFreq(void* data)
+{
+    return getSystem()->getPerformanceFrequency();
+}
+
 static bool forceExit(void* data)
 {
     getSystem()->poll();
@@ -128,8 +251,11 @@ static bool forceExit(void* data)
 
 void initRun(Run* run, Console* console, tic_mem* tic)
 {
+    RunCodeCache cache = run->cache;
+
     *run = (Run)
     {
+        .cache = cache,
         .tic = tic,
         .console = console,
         .tick = tick,
@@ -138,15 +264,19 @@ void initRun(Run* run, Console* console, tic_mem* tic)
         {
             .error = onError,
             .trace = onTrace,
-            .counter = getSystem()->getPerformanceCounter,
-            .freq = getSystem()->getPerformanceFrequency,
+            .counter = getCounter,
+            .freq = getFreq,
             .start = 0,
             .data = run,
             .exit = onExit,
             .forceExit = forceExit,
+            .loadCache = onLoadCache,
+            .saveCache = onSaveCache,
         },
     };
 
+    fsMakeDir(console->fs, TIC_CODE_CACHE);
+
     {
         enum {Size = sizeof(tic_persistent)};
         memset(&tic->ram.persistent, 0, Size);
@@ -171,5 +301,8 @@ void initRun(Run* run, Console* console, tic_mem* tic)
 
 void freeRun(Run* run)
 {
+    for(s32 i = 0; i < COUNT_OF(run->cache.items); i++)
+        free(run->cache.items[i].data);
+
     free(run);
 }
\ No newline at end of file
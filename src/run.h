@@ -26,6 +26,19 @@
 
 typedef struct Run Run;
 
+// compiled code of the last runs, it's kept across the resets and the runs of the session
+typedef struct
+{
+    struct
+    {
+        char key[32 + 1];   // md5 hex of the build, the name and the code
+        void* data;
+        s32 size;
+    } items[4];
+
+    s32 next;
+} RunCodeCache;
+
 struct Run
 {
     tic_mem* tic;
@@ -36,6 +49,7 @@ struct Run
     
     char saveid[TICNAME_MAX];
     tic_persistent pmem;
+    RunCodeCache cache;
 
     void(*tick)(Run*);
 };
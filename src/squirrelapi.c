@@ -359,7 +359,7 @@ static SQInteger squirrel_textri(HSQUIRRELVM vm)
         }
 
         tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
-        static u8 colors[TIC_PALETTE_SIZE];
+        u8 colors[TIC_PALETTE_SIZE];
         s32 count = 0;
         bool use_map = false;
 
@@ -396,6 +396,18 @@ static SQInteger squirrel_textri(HSQUIRRELVM vm)
             count = 1;
         }
 
+        //  check for depth
+        float z[3] = {0};
+        bool depth = top >= 18;
+
+        if(depth)
+            for(s32 i = 0; i < COUNT_OF(z); i++)
+            {
+                SQFloat f = 0.0;
+                sq_getfloat(vm, i + 16, &f);
+                z[i] = (float)f;
+            }
+
         tic_api_textri(tic, pt[0], pt[1],   //  xy 1
                                     pt[2], pt[3],   //  xy 2
                                     pt[4], pt[5],   //  xy 3
@@ -403,9 +415,10 @@ static SQInteger squirrel_textri(HSQUIRRELVM vm)
                                     pt[8], pt[9],   //  uv 2
                                     pt[10], pt[11], //  uv 3
                                     use_map,        // use map
-                                    colors, count);        // chroma
+                                    colors, count,  // chroma
+                                    z[0], z[1], z[2], depth);
     }
-    else return sq_throwerror(vm, "invalid parameters, textri(x1,y1,x2,y2,x3,y3,u1,v1,u2,v2,u3,v3,[use_map=false],[chroma=off])\n");
+    else return sq_throwerror(vm, "invalid parameters, textri(x1,y1,x2,y2,x3,y3,u1,v1,u2,v2,u3,v3,[use_map=false],[chroma=off],[z1,z2,z3])\n");
     return 0;
 }
 
@@ -436,6 +449,44 @@ static SQInteger squirrel_clip(HSQUIRRELVM vm)
     return 0;
 }
 
+static SQInteger squirrel_raster(HSQUIRRELVM vm)
+{
+    SQInteger top = sq_gettop(vm);
+    tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
+
+    if(top == 1)
+        tic_api_raster(tic, -1, 0, -1, -1, 0);
+    else if(top != 5)
+    {
+        // missing or null fields leave the row as it is
+        s32 row = getSquirrelNumber(vm, 2);
+        s32 x = top >= 3 && sq_gettype(vm, 3) != OT_NULL ? getSquirrelNumber(vm, 3) : TIC_RASTER_KEEP;
+        s32 border = top >= 4 && sq_gettype(vm, 4) != OT_NULL ? getSquirrelNumber(vm, 4) : TIC_RASTER_KEEP;
+        s32 color = top >= 6 && sq_gettype(vm, 5) != OT_NULL ? getSquirrelNumber(vm, 5) : -1;
+        u32 rgb = top >= 6 ? getSquirrelNumber(vm, 6) : 0;
+
+        tic_api_raster(tic, row, x, border, color, rgb);
+    }
+    else return sq_throwerror(vm, "invalid parameters, use raster(row,[x],[border],[color,rgb]) or raster()\n");
+
+    return 0;
+}
+
+static SQInteger squirrel_rasterbuf(HSQUIRRELVM vm)
+{
+    if(sq_gettop(vm) == 3)
+    {
+        s32 address = getSquirrelNumber(vm, 2);
+        s32 count = getSquirrelNumber(vm, 3);
+
+        tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
+        tic_api_rasterbuf(tic, address, count);
+        return 0;
+    }
+
+    return sq_throwerror(vm, "invalid params, rasterbuf(address,count)\n");
+}
+
 static SQInteger squirrel_btnp(HSQUIRRELVM vm)
 {
     tic_machine* machine = getSquirrelMachine(vm);
@@ -493,6 +544,87 @@ static SQInteger squirrel_btn(HSQUIRRELVM vm)
     return 1;
 }
 
+static SQInteger squirrel_target(HSQUIRRELVM vm)
+{
+    tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
+
+    tic_api_target(tic, sq_gettop(vm) >= 2 ? getSquirrelNumber(vm, 2) : -1);
+
+    return 0;
+}
+
+// reads a number or an array of up to 16 numbers
+static s32 getSquirrelColors(HSQUIRRELVM vm, SQInteger index, u8* colors)
+{
+    s32 count = 0;
+
+    if(OT_ARRAY == sq_gettype(vm, index))
+    {
+        for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+        {
+            sq_pushinteger(vm, (SQInteger)i);
+            if(SQ_FAILED(sq_rawget(vm, index))) break;
+
+            bool valid = (sq_gettype(vm, -1) & (OT_FLOAT|OT_INTEGER)) != 0;
+            if(valid) colors[count++] = getSquirrelNumber(vm, -1);
+            sq_poptop(vm);
+            if(!valid) break;
+        }
+    }
+    else if(sq_gettype(vm, index) & (OT_FLOAT|OT_INTEGER))
+        colors[count++] = getSquirrelNumber(vm, index);
+
+    return count;
+}
+
+static SQInteger squirrel_blit(HSQUIRRELVM vm)
+{
+    SQInteger top = sq_gettop(vm);
+
+    if(top >= 2)
+    {
+        s32 src = getSquirrelNumber(vm, 2);
+        s32 x = top >= 3 ? getSquirrelNumber(vm, 3) : 0;
+        s32 y = top >= 4 ? getSquirrelNumber(vm, 4) : 0;
+        u8 colors[TIC_PALETTE_SIZE];
+        s32 count = top >= 5 ? getSquirrelColors(vm, 5, colors) : 0;
+        s32 dst = top >= 6 && sq_gettype(vm, 6) != OT_NULL ? getSquirrelNumber(vm, 6) : -1;
+        u8 remap[TIC_PALETTE_SIZE];
+        bool hasRemap = top >= 7 && OT_ARRAY == sq_gettype(vm, 7);
+
+        if(hasRemap)
+            for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+            {
+                remap[i] = i;
+                sq_pushinteger(vm, (SQInteger)i);
+                if(SQ_FAILED(sq_rawget(vm, 7))) continue;
+                if(sq_gettype(vm, -1) & (OT_FLOAT|OT_INTEGER)) remap[i] = getSquirrelNumber(vm, -1);
+                sq_poptop(vm);
+            }
+
+        tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
+        tic_api_blit(tic, src, x, y, colors, count, dst, hasRemap ? remap : NULL);
+        return 0;
+    }
+
+    return sq_throwerror(vm, "invalid params, blit(src,[x=0],[y=0],[colorkey=-1],[dst=-1],[remap])\n");
+}
+
+static SQInteger squirrel_oam(HSQUIRRELVM vm)
+{
+    if(sq_gettop(vm) == 3)
+    {
+        s32 address = getSquirrelNumber(vm, 2);
+        s32 count = getSquirrelNumber(vm, 3);
+
+        tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
+        tic_api_oam(tic, address, count);
+        return 0;
+    }
+
+    return sq_throwerror(vm, "invalid params, oam(address,count)\n");
+}
+
 static SQInteger squirrel_spr(HSQUIRRELVM vm)
 {
     SQInteger top = sq_gettop(vm);
@@ -505,7 +637,7 @@ static SQInteger squirrel_spr(HSQUIRRELVM vm)
     s32 scale = 1;
     tic_flip flip = tic_no_flip;
     tic_rotate rotate = tic_no_rotate;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(top >= 2) 
@@ -659,6 +791,55 @@ static void remapCallback(void* data, s32 x, s32 y, RemapResult* result)
     sq_settop(vm, top);
 }
 
+// remap(cells) gets [id, x, y, id, x, y, ...] for all the visible cells
+// and returns [id, flip, rotate, ...] in the same order
+static void remapBatchCallback(void* data, RemapCell* cells, s32 count)
+{
+    RemapData* remap = (RemapData*)data;
+    HSQUIRRELVM vm = remap->vm;
+
+    SQInteger top = sq_gettop(vm);
+
+    sq_pushobject(vm, remap->reg);
+    sq_pushroottable(vm);
+    sq_newarray(vm, 0);
+
+    for(s32 i = 0; i < count; i++)
+    {
+        sq_pushinteger(vm, cells[i].result.index);
+        sq_arrayappend(vm, -2);
+        sq_pushinteger(vm, cells[i].x);
+        sq_arrayappend(vm, -2);
+        sq_pushinteger(vm, cells[i].y);
+        sq_arrayappend(vm, -2);
+    }
+
+    if (SQ_SUCCEEDED(sq_call(vm, 2, SQTrue, SQTrue)) && sq_gettype(vm, -1) == OT_ARRAY)
+    {
+        for(s32 i = 0; i < count; i++)
+        {
+            RemapResult* result = &cells[i].result;
+
+            sq_pushinteger(vm, i * 3 + 0);
+            if (SQ_FAILED(sq_rawget(vm, -2))) break;
+            result->index = getSquirrelNumber(vm, -1);
+            sq_poptop(vm);
+
+            sq_pushinteger(vm, i * 3 + 1);
+            if (SQ_FAILED(sq_rawget(vm, -2))) break;
+            result->flip = getSquirrelNumber(vm, -1);
+            sq_poptop(vm);
+
+            sq_pushinteger(vm, i * 3 + 2);
+            if (SQ_FAILED(sq_rawget(vm, -2))) break;
+            result->rotate = getSquirrelNumber(vm, -1);
+            sq_poptop(vm);
+        }
+    }
+
+    sq_settop(vm, top);
+}
+
 static SQInteger squirrel_map(HSQUIRRELVM vm)
 {
     s32 x = 0;
@@ -668,7 +849,7 @@ static SQInteger squirrel_map(HSQUIRRELVM vm)
     s32 sx = 0;
     s32 sy = 0;
     s32 scale = 1;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     SQInteger top = sq_gettop(vm);
@@ -731,7 +912,14 @@ static SQInteger squirrel_map(HSQUIRRELVM vm)
 
                                 tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
 
-                                tic_api_map(tic, x, y, w, h, sx, sy, colors, count, scale, remapCallback, &data);
+                                SQBool batch = SQFalse;
+                                if(top >= 11 && sq_gettype(vm, 11) == OT_BOOL)
+                                    sq_getbool(vm, 11, &batch);
+
+                                if(batch)
+                                    tic_core_map_batch(tic, x, y, w, h, sx, sy, colors, count, scale, remapBatchCallback, &data);
+                                else
+                                    tic_api_map(tic, x, y, w, h, sx, sy, colors, count, scale, remapCallback, &data);
 
                                 //luaL_unref(lua, LUA_REGISTRYINDEX, data.reg);
                                 sq_release(vm, &data.reg);
@@ -994,6 +1182,83 @@ static SQInteger squirrel_keyp(HSQUIRRELVM vm)
     return 1;
 }
 
+typedef void(*PeekBuffer)(tic_mem*, s32 address, u8* buffer, s32 size);
+typedef void(*PokeBuffer)(tic_mem*, s32 address, const u8* buffer, s32 size);
+
+// returns the range as a blob
+static SQInteger peekSquirrelBuffer(HSQUIRRELVM vm, PeekBuffer peek, s32 limit, const char* usage)
+{
+    if(sq_gettop(vm) == 3)
+    {
+        s32 address = getSquirrelNumber(vm, 2);
+        s32 size = getSquirrelNumber(vm, 3);
+
+        if(size >= 0 && size <= limit)
+        {
+            tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
+            peek(tic, address, sqstd_createblob(vm, size), size);
+            return 1;
+        }
+    }
+
+    return sq_throwerror(vm, usage);
+}
+
+// accepts a blob or an array of integers
+static SQInteger pokeSquirrelBuffer(HSQUIRRELVM vm, PokeBuffer poke, s32 limit, const char* usage)
+{
+    if(sq_gettop(vm) == 3)
+    {
+        s32 address = getSquirrelNumber(vm, 2);
+        tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
+        SQUserPointer data = NULL;
+
+        if(SQ_SUCCEEDED(sqstd_getblob(vm, 3, &data)))
+        {
+            poke(tic, address, data, (s32)MIN(sqstd_getblobsize(vm, 3), limit));
+            return 0;
+        }
+        else if(OT_ARRAY == sq_gettype(vm, 3))
+        {
+            s32 size = (s32)MIN(sq_getsize(vm, 3), limit);
+            u8* buffer = sqstd_createblob(vm, size);
+
+            for(s32 i = 0; i < size; i++)
+            {
+                sq_pushinteger(vm, (SQInteger)i);
+                sq_rawget(vm, 3);
+                buffer[i] = getSquirrelNumber(vm, -1);
+                sq_poptop(vm);
+            }
+
+            poke(tic, address, buffer, size);
+            return 0;
+        }
+    }
+
+    return sq_throwerror(vm, usage);
+}
+
+static SQInteger squirrel_peekbuf(HSQUIRRELVM vm)
+{
+    return peekSquirrelBuffer(vm, tic_api_peekbuf, sizeof(tic_ram), "invalid params, peekbuf(address,size)\n");
+}
+
+static SQInteger squirrel_pokebuf(HSQUIRRELVM vm)
+{
+    return pokeSquirrelBuffer(vm, tic_api_pokebuf, sizeof(tic_ram), "invalid params, pokebuf(address,data)\n");
+}
+
+static SQInteger squirrel_peek4buf(HSQUIRRELVM vm)
+{
+    return peekSquirrelBuffer(vm, tic_api_peek4buf, sizeof(tic_ram) * 2, "invalid params, peek4buf(address,size)\n");
+}
+
+static SQInteger squirrel_poke4buf(HSQUIRRELVM vm)
+{
+    return pokeSquirrelBuffer(vm, tic_api_poke4buf, sizeof(tic_ram) * 2, "invalid params, poke4buf(address,data)\n");
+}
+
 static SQInteger squirrel_memcpy(HSQUIRRELVM vm)
 {
     SQInteger top = sq_gettop(vm);
@@ -1329,6 +1594,28 @@ static SQInteger squirrel_fset(HSQUIRRELVM vm)
     return 0;
 }
 
+// rand and srand of the math library on the generator of the machine, rand keeps the 0..RAND_MAX range
+static SQInteger squirrel_rand(HSQUIRRELVM vm)
+{
+    tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);
+
+    sq_pushinteger(vm, tic_core_random(tic) % ((u32)RAND_MAX + 1));
+
+    return 1;
+}
+
+static SQInteger squirrel_srand(HSQUIRRELVM vm)
+{
+    SQInteger seed;
+
+    if(SQ_FAILED(sq_getinteger(vm, 2, &seed)))
+        return sq_throwerror(vm, "invalid params, srand(seed)\n");
+
+    tic_core_random_seed((tic_mem*)getSquirrelMachine(vm), (u64)seed);
+
+    return 0;
+}
+
 static SQInteger squirrel_dofile(HSQUIRRELVM vm)
 {
     return sq_throwerror(vm, "unknown method: \"dofile\"\n");
@@ -1357,6 +1644,19 @@ static void checkForceExit(HSQUIRRELVM vm, SQInteger type, const SQChar* sourceN
         sq_throwerror(vm, "script execution was interrupted");
 }
 
+// API functions recording trace spans, registered instead of the plain ones while tracing
+#define API_TRACE_DEF(name, ...)                                    \
+    static SQInteger squirrel_trace_ ## name(HSQUIRRELVM vm)        \
+    {                                                               \
+        tic_mem* tic = (tic_mem*)getSquirrelMachine(vm);            \
+        u64 start = tic_core_trace_begin(tic);                      \
+        SQInteger res = squirrel_ ## name(vm);                      \
+        tic_core_trace_end(tic, tic_api_index_ ## name, start);     \
+        return res;                                                 \
+    }
+TIC_API_LIST(API_TRACE_DEF)
+#undef API_TRACE_DEF
+
 static void initAPI(tic_machine* machine)
 {
     HSQUIRRELVM vm = machine->squirrel;
@@ -1373,15 +1673,19 @@ static void initAPI(tic_machine* machine)
     sq_setforeignptr(vm, machine);
 #endif
 
-#define API_FUNC_DEF(name, ...) {squirrel_ ## name, #name},
-    static const struct{SQFUNCTION func; const char* name;} ApiItems[] = {TIC_API_LIST(API_FUNC_DEF)};
+#define API_FUNC_DEF(name, ...) {squirrel_ ## name, squirrel_trace_ ## name, #name},
+    static const struct{SQFUNCTION func; SQFUNCTION trace; const char* name;} ApiItems[] = {TIC_API_LIST(API_FUNC_DEF)};
 #undef API_FUNC_DEF
 
+    bool trace = machine->memory.profile.trace.api;
+
     for (s32 i = 0; i < COUNT_OF(ApiItems); i++)
-        registerSquirrelFunction(machine, ApiItems[i].func, ApiItems[i].name);
+        registerSquirrelFunction(machine, trace ? ApiItems[i].trace : ApiItems[i].func, ApiItems[i].name);
 
     registerSquirrelFunction(machine, squirrel_dofile, "dofile");
     registerSquirrelFunction(machine, squirrel_loadfile, "loadfile");
+    registerSquirrelFunction(machine, squirrel_rand, "rand");
+    registerSquirrelFunction(machine, squirrel_srand, "srand");
 
 #if CHECK_FORCE_EXIT
     sq_setnativedebughook(vm, checkForceExit);
@@ -1401,6 +1705,37 @@ static void closeSquirrel(tic_mem* tic)
     }
 }
 
+// TIC, SCN, the old scanline and OVR are looked up after the code is loaded or evaluated and after every TIC() call
+// and kept in the registry by index, so a cart can reassign them from TIC(), the machine doesn't call the ones that aren't defined
+static void resolveSquirrelCallbacks(tic_machine* machine)
+{
+    HSQUIRRELVM vm = machine->squirrel;
+
+    static const char* const Names[] = {TIC_FN, SCN_FN, "scanline", OVR_FN};
+    bool defined[COUNT_OF(Names)];
+
+    SQInteger top = sq_gettop(vm);
+    sq_pushregistrytable(vm);
+
+    for(s32 i = 0; i < COUNT_OF(Names); i++)
+    {
+        sq_pushinteger(vm, i);
+        sq_pushroottable(vm);
+        sq_pushstring(vm, Names[i], -1);
+
+        if(SQ_FAILED(sq_get(vm, -2)))
+            sq_pushnull(vm);
+
+        sq_remove(vm, -2); // root table
+        defined[i] = sq_gettype(vm, -1) != OT_NULL;
+        sq_newslot(vm, -3, SQFalse);
+    }
+
+    sq_settop(vm, top);
+
+    tic_core_script_callbacks(&machine->memory, defined[1] || defined[2], defined[3]);
+}
+
 static bool initSquirrel(tic_mem* tic, const char* code)
 {
     tic_machine* machine = (tic_machine*)tic;
@@ -1438,6 +1773,8 @@ static bool initSquirrel(tic_mem* tic, const char* code)
         }
     }
 
+    resolveSquirrelCallbacks(machine);
+
     return true;
 }
 
@@ -1449,10 +1786,12 @@ static void callSquirrelTick(tic_mem* tic)
 
     if(vm)
     {
-        sq_pushroottable(vm);
-        sq_pushstring(vm, TIC_FN, -1);
+        SQInteger top = sq_gettop(vm);
 
-        if (SQ_SUCCEEDED(sq_get(vm, -2)))
+        sq_pushregistrytable(vm);
+        sq_pushinteger(vm, 0);
+
+        if (SQ_SUCCEEDED(sq_get(vm, -2)) && sq_gettype(vm, -1) != OT_NULL)
         {
             sq_pushroottable(vm);
             if(SQ_FAILED(sq_call(vm, 1, SQFalse, SQTrue)))
@@ -1464,85 +1803,65 @@ static void callSquirrelTick(tic_mem* tic)
 
                 if (machine->data)
                     machine->data->error(machine->data->data, errorString);
-                sq_pop(vm, 3); // remove string, error and root table.
             }
         }
-        else 
-        {       
-            sq_pop(vm, 1);
-            if (machine->data)
-                machine->data->error(machine->data->data, "'function TIC()...' isn't found :(");
-        }
+        else if (machine->data)
+            machine->data->error(machine->data->data, "'function TIC()...' isn't found :(");
+
+        sq_settop(vm, top);
+
+        resolveSquirrelCallbacks(machine);
     }
 }
 
-static void callSquirrelScanlineName(tic_mem* tic, s32 row, void* data, const char* name)
+static void callSquirrelCallback(tic_machine* machine, s32 index, s32 row)
 {
-    tic_machine* machine = (tic_machine*)tic;
     HSQUIRRELVM vm = machine->squirrel;
+    SQInteger top = sq_gettop(vm);
+
+    sq_pushregistrytable(vm);
+    sq_pushinteger(vm, index);
 
-    if (vm)
+    if(SQ_SUCCEEDED(sq_get(vm, -2)) && sq_gettype(vm, -1) != OT_NULL)
     {
         sq_pushroottable(vm);
-        sq_pushstring(vm, name, -1);
-        if (SQ_SUCCEEDED(sq_get(vm, -2)))
-        {
-            sq_pushroottable(vm);
+
+        if(row >= 0)
             sq_pushinteger(vm, row);
 
-            if(SQ_FAILED(sq_call(vm, 2, SQFalse, SQTrue)))
-            {
-                sq_getlasterror(vm);
-                sq_tostring(vm, -1);
+        if(SQ_FAILED(sq_call(vm, row >= 0 ? 2 : 1, SQFalse, SQTrue)))
+        {
+            sq_getlasterror(vm);
+            sq_tostring(vm, -1);
 
-                const SQChar* errorString = "unknown error";
-                sq_getstring(vm, -1, &errorString);
-                if (machine->data)
-                    machine->data->error(machine->data->data, errorString);
-                sq_pop(vm, 3); // error string, error and root table
-            }
+            const SQChar* errorString = "unknown error";
+            sq_getstring(vm, -1, &errorString);
+            if (machine->data)
+                machine->data->error(machine->data->data, errorString);
         }
-        else sq_poptop(vm);
     }
+
+    sq_settop(vm, top);
 }
 
 static void callSquirrelScanline(tic_mem* tic, s32 row, void* data)
 {
-    callSquirrelScanlineName(tic, row, data, SCN_FN);
+    tic_machine* machine = (tic_machine*)tic;
 
-    // try to call old scanline
-    callSquirrelScanlineName(tic, row, data, "scanline");
+    if (machine->squirrel)
+    {
+        // SCN and the old scanline
+        callSquirrelCallback(machine, 1, row);
+        callSquirrelCallback(machine, 2, row);
+    }
 }
 
 static void callSquirrelOverline(tic_mem* tic, void* data)
 {
     tic_machine* machine = (tic_machine*)tic;
-    HSQUIRRELVM vm = machine->squirrel;
-
-    if (vm)
-    {
-        const char* OvrFunc = OVR_FN;
-
-        sq_pushroottable(vm);
-        sq_pushstring(vm, OvrFunc, -1);
-        
-        if(SQ_SUCCEEDED(sq_get(vm, -2))) 
-        {
-            sq_pushroottable(vm);
-            if(SQ_FAILED(sq_call(vm, 1, SQFalse, SQTrue)))
-            {
-                sq_getlasterror(vm);
-                sq_tostring(vm, -1);
-                const SQChar* errorString = "unknown error";
-                sq_getstring(vm, -1, &errorString);
-                if (machine->data)
-                    machine->data->error(machine->data->data, errorString);
-                sq_pop(vm, 3);
-            }
-        }
-        else sq_poptop(vm);
-    }
 
+    if (machine->squirrel)
+        callSquirrelCallback(machine, 3, -1);
 }
 
 static const char* const SquirrelKeywords [] =
@@ -1644,6 +1963,8 @@ void evalSquirrel(tic_mem* tic, const char* code) {
     }
 
     sq_settop(vm, 0);
+
+    resolveSquirrelCallbacks(machine);
 }
 
 static const tic_script_config SquirrelSyntaxConfig = 
@@ -1667,6 +1988,8 @@ static const tic_script_config SquirrelSyntaxConfig =
 
     .keywords           = SquirrelKeywords,
     .keywordsCount      = COUNT_OF(SquirrelKeywords),
+
+    .name               = "squirrel",
 };
 
 const tic_script_config* getSquirrelScriptConfig()
@@ -32,6 +32,7 @@ static void reset(Start* start)
     u8 val = Reset[sizeof(Reset) * (start->ticks % TIC80_FRAMERATE) / TIC80_FRAMERATE];
 
     for(s32 i = 0; i < sizeof(tic_tile); i++) tile[i] = val;
+    tic_core_invalidate(start->tic, offsetof(tic_ram, tiles), sizeof(tic_tile));
 
     tic_api_map(start->tic, 0, 0, TIC_MAP_SCREEN_WIDTH, TIC_MAP_SCREEN_HEIGHT + (TIC80_HEIGHT % TIC_SPRITESIZE ? 1 : 0), 0, 0, 0, 0, 1, NULL, NULL);
 }
@@ -43,6 +43,7 @@
 #include "ext/gif.h"
 #include "ext/md5.h"
 #include "wave_writer.h"
+#include "audiorender.h"
 
 #include <ctype.h>
 #include <math.h>
@@ -159,6 +160,9 @@ static struct
 
     } video;
 
+    bool profiler;
+    bool overdraw;
+
     struct
     {
         Code*       code;
@@ -249,9 +253,16 @@ void map2ram(tic_ram* ram, const tic_map* src)
     memcpy(ram->map.data, src, sizeof ram->map);
 }
 
-void tiles2ram(tic_ram* ram, const tic_tiles* src)
+// the tile caches are only dropped when the editors changed the tiles
+void tiles2ram(tic_mem* tic, const tic_tiles* src)
 {
-    memcpy(ram->tiles.data, src, sizeof ram->tiles * TIC_SPRITE_BANKS);
+    enum {Size = sizeof(tic_tiles) * TIC_SPRITE_BANKS};
+
+    if(memcmp(tic->ram.tiles.data, src, Size) != 0)
+    {
+        memcpy(tic->ram.tiles.data, src, Size);
+        tic_core_invalidate(tic, offsetof(tic_ram, tiles), Size);
+    }
 }
 
 static inline void sfx2ram(tic_ram* ram, const tic_sfx* src)
@@ -259,9 +270,24 @@ static inline void sfx2ram(tic_ram* ram, const tic_sfx* src)
     memcpy(&ram->sfx, src, sizeof ram->sfx);
 }
 
-static inline void music2ram(tic_ram* ram, const tic_music* src)
+// the decoded music is only dropped when the editors changed it
+static inline void music2ram(tic_mem* tic, const tic_music* src)
 {
-    memcpy(&ram->music, src, sizeof ram->music);
+    if(memcmp(&tic->ram.music, src, sizeof tic->ram.music) != 0)
+    {
+        memcpy(&tic->ram.music, src, sizeof tic->ram.music);
+        tic_core_invalidate(tic, offsetof(tic_ram, music), sizeof(tic_music));
+    }
+}
+
+// the glyph cache is only dropped when the font in RAM differs
+static inline void font2ram(tic_mem* tic, const tic_font* src)
+{
+    if(memcmp(&tic->ram.font, src, sizeof tic->ram.font) != 0)
+    {
+        memcpy(&tic->ram.font, src, sizeof tic->ram.font);
+        tic_core_invalidate(tic, offsetof(tic_ram, font), sizeof(tic_font));
+    }
 }
 
 s32 calcWaveAnimation(tic_mem* tic, u32 offset, s32 channel)
@@ -287,86 +313,111 @@ static const tic_music* getMusicSrc()
     return &tic->cart.banks[impl.bank.index.music].music;
 }
 
-const char* studioExportSfx(s32 index)
+static void getAudioSource(tic_audio_source* source)
 {
-    tic_mem* tic = impl.studio.tic;
+    const Music* editor = impl.banks.music[impl.bank.index.music];
+
+    *source = (tic_audio_source)
+    {
+        .sfx = getSfxSrc(),
+        .music = getMusicSrc(),
+        .samplerate = impl.samplerate,
+        .sustain = editor->sustain,
+    };
 
-    const char* name = fsGetRootFilePath(impl.fs, WavPath);
+    for (s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+        source->mute[i] = !editor->on[i];
+}
 
-    wave_open( impl.samplerate, name );
+static void writeWave(const char* path, const tic_audio_job* job)
+{
+    wave_open( impl.samplerate, path );
 
 #if TIC_STEREO_CHANNELS == 2
     wave_enable_stereo();
 #endif
 
-    const tic_sfx* sfx = getSfxSrc();
-
-    sfx2ram(&tic->ram, sfx);
-    music2ram(&tic->ram, getMusicSrc());
-
-    {
-        const tic_sample* effect = &sfx->samples.data[index];
+    if(job->samples)
+        wave_write(job->samples, job->count * TIC_STEREO_CHANNELS);
 
-        enum{Channel = 0};
-        sfx_stop(tic, Channel);
-        tic_api_sfx(tic, index, effect->note, effect->octave, -1, Channel, MAX_VOLUME, SFX_DEF_SPEED);
-
-        for(s32 ticks = 0, pos = 0; pos < SFX_TICKS; pos = tic_tool_sfx_pos(effect->speed, ++ticks))
-        {
-            tic_core_tick_start(tic);
-            tic_core_tick_end(tic);
+    wave_close();
+}
 
-            wave_write(tic->samples.buffer, tic->samples.size / sizeof(s16));
-        }
+static const char* exportAudio(bool sfx, s32 index)
+{
+    tic_audio_source source;
+    getAudioSource(&source);
 
-        sfx_stop(tic, Channel);
-        memset(tic->ram.registers, 0, sizeof(tic_sound_register));
-    }
+    tic_audio_job job = {.sfx = sfx, .index = index};
+    tic_audio_render(&source, &job, 1);
 
-    wave_close();
+    writeWave(fsGetRootFilePath(impl.fs, WavPath), &job);
+    free(job.samples);
 
     return WavPath;
 }
 
-const char* studioExportMusic(s32 track)
+const char* studioExportSfx(s32 index)
 {
-    tic_mem* tic = impl.studio.tic;
+    return exportAudio(true, index);
+}
 
-    const char* name = fsGetRootFilePath(impl.fs, WavPath);
+const char* studioExportMusic(s32 track)
+{
+    return exportAudio(false, track);
+}
 
-    wave_open( impl.samplerate, name );
+static bool isSfxEmpty(const tic_sample* effect)
+{
+    for(s32 i = 0; i < sizeof(tic_sample); i++)
+        if(((const u8*)effect)[i])
+            return false;
 
-#if TIC_STEREO_CHANNELS == 2
-    wave_enable_stereo();
-#endif
+    return true;
+}
 
-    const tic_sfx* sfx = getSfxSrc();
-    const tic_music* music = getMusicSrc();
+// renders all the tracks or all the non empty sfx at once and saves them to the current folder,
+// returns the number of saved files or -1
+s32 studioExportAllAudio(bool sfx)
+{
+    tic_audio_source source;
+    getAudioSource(&source);
 
-    sfx2ram(&tic->ram, sfx);
-    music2ram(&tic->ram, music);
+    tic_audio_job jobs[SFX_COUNT];
+    s32 count = 0;
 
-    const tic_sound_state* state = &tic->ram.sound_state;
-    const Music* editor = impl.banks.music[impl.bank.index.music];
+    for(s32 i = 0; i < (sfx ? SFX_COUNT : MUSIC_TRACKS); i++)
+        if(!sfx || !isSfxEmpty(&source.sfx->samples.data[i]))
+            jobs[count++] = (tic_audio_job){.sfx = sfx, .index = i};
 
-    tic_api_music(tic, track, -1, -1, false, editor->sustain);
+    bool ok = tic_audio_render(&source, jobs, count);
+    s32 saved = 0;
 
-    while(state->flag.music_state == tic_music_play)
+    for(s32 i = 0; i < count; i++)
     {
-        tic_core_tick_start(tic);
+        if(ok)
+        {
+            writeWave(fsGetRootFilePath(impl.fs, WavPath), &jobs[i]);
 
-        for (s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
-            if(!editor->on[i])
-                tic->ram.registers[i].volume = 0;
+            s32 size = 0;
+            void* data = fsLoadRootFile(impl.fs, WavPath, &size);
 
-        tic_core_tick_end(tic);
+            if(data)
+            {
+                char name[TICNAME_MAX];
+                sprintf(name, sfx ? "sfx %i.wav" : "track %i.wav", jobs[i].index);
 
-        wave_write(tic->samples.buffer, tic->samples.size / sizeof(s16));
-    }
+                if(fsSaveFile(impl.fs, name, data, size, true))
+                    saved++;
 
-    wave_close();
+                free(data);
+            }
+        }
 
-    return WavPath;
+        free(jobs[i].samples);
+    }
+
+    return ok ? saved : -1;
 }
 
 void sfx_stop(tic_mem* tic, s32 channel)
@@ -1515,6 +1566,8 @@ static void processShortcuts()
     bool ctrl = tic_api_key(tic, tic_key_ctrl);
 
     if(keyWasPressedOnce(tic_key_f6)) switchCrtMonitor();
+    if(keyWasPressedOnce(tic_key_f10)) showProfiler(!impl.profiler);
+    if(keyWasPressedOnce(tic_key_f12)) showOverdraw(!impl.overdraw);
 
     if(isGameMenu())
     {
@@ -1667,8 +1720,10 @@ static void recordFrame(u32* pixels)
 
             if(impl.video.frame % TIC80_FRAMERATE < TIC80_FRAMERATE / 2)
             {
-                const u32* pal = tic_tool_palette_blit(&impl.config->cart.bank0.palette.scn, TIC80_PIXEL_COLOR_RGBA8888);
+                u32 pal[TIC_PALETTE_SIZE];
+                tic_tool_palette_blit(pal, &impl.config->cart.bank0.palette.scn, TIC80_PIXEL_COLOR_RGBA8888);
                 drawRecordLabel(pixels, TIC80_WIDTH-24, 8, &pal[tic_color_2]);
+                tic_core_screen_drawn(impl.studio.tic, 8, 8 + 5);
             }
 
             impl.video.frame++;
@@ -1703,6 +1758,165 @@ static void drawPopup()
     }
 }
 
+static u64 getProfileCounter(void* data)
+{
+    return getSystem()->getPerformanceCounter();
+}
+
+// the counter runs while the overlay is shown or a trace is captured
+static void updateProfiler()
+{
+    tic_mem* tic = impl.studio.tic;
+
+    tic_core_profile_enable(tic, impl.profiler || tic->profile.trace.active ? getProfileCounter : NULL, 
+        getSystem()->getPerformanceFrequency(), NULL);
+}
+
+void showProfiler(bool show)
+{
+    impl.profiler = show;
+    updateProfiler();
+}
+
+void startTrace(bool api)
+{
+    tic_core_trace_start(impl.studio.tic, api);
+    updateProfiler();
+}
+
+void stopTrace()
+{
+    tic_core_trace_stop(impl.studio.tic);
+    updateProfiler();
+}
+
+bool isProfilerShown()
+{
+    return impl.profiler;
+}
+
+void showOverdraw(bool show)
+{
+    impl.overdraw = show;
+}
+
+bool isOverdrawShown()
+{
+    return impl.overdraw;
+}
+
+// the overlay is drawn over the converted frame, the cart's VRAM, clip and draw counters stay untouched
+enum {ProfilerLeft = (TIC80_FULLWIDTH - TIC80_WIDTH) / 2, ProfilerTop = (TIC80_FULLHEIGHT - TIC80_HEIGHT) / 2};
+
+static void profilerRect(u32* frame, s32 x, s32 y, s32 w, s32 h, u32 color)
+{
+    for(s32 j = y; j < y + h; j++)
+    {
+        u32* row = &frame[ProfilerLeft + x + ((ProfilerTop + j) << TIC80_FULLWIDTH_BITS)];
+
+        for(s32 i = 0; i < w; i++)
+            row[i] = color;
+    }
+}
+
+static s32 profilerPrint(u32* frame, const char* text, s32 x, s32 y, u32 color)
+{
+    s32 pos = x;
+
+    for(char sym; (sym = *text++); pos += TIC_ALTFONT_WIDTH)
+    {
+        const u8* glyph = &impl.systemFont.data[(TIC_FONT_CHARS/2 + (u8)sym) * BITS_IN_BYTE];
+
+        for(s32 j = 0; j < TIC_FONT_HEIGHT; j++)
+            for(s32 i = 0; i < TIC_ALTFONT_WIDTH; i++)
+                if(glyph[j] & (1 << i) && pos + i < TIC80_WIDTH)
+                    frame[ProfilerLeft + pos + i + ((ProfilerTop + y + j) << TIC80_FULLWIDTH_BITS)] = color;
+    }
+
+    return pos - x;
+}
+
+static void drawProfiler()
+{
+    if(!impl.profiler) return;
+
+    tic_mem* tic = impl.studio.tic;
+    const tic_profile* profile = &tic->profile;
+    u32* frame = tic->screen;
+
+    static const char* Labels[] =
+    {
+#define PROFILE_PHASE_DEF(_, label) label,
+        TIC_PROFILE_LIST(PROFILE_PHASE_DEF)
+#undef PROFILE_PHASE_DEF
+    };
+
+    static const u8 Colors[tic_profile_phases] = 
+    {
+        tic_color_3, tic_color_5, tic_color_9, tic_color_11, tic_color_4, tic_color_2, tic_color_13
+    };
+
+    u32 pal[TIC_PALETTE_SIZE];
+    tic_tool_palette_blit(pal, &getConfig()->cart->bank0.palette.scn, tic->screen_format);
+
+    // 2 pixels per millisecond, the line marks the 60 FPS budget
+    enum {Height = 40, Scale = 2, Top = TIC80_HEIGHT - Height, Averages = Top - TIC_FONT_HEIGHT * 2 - 1};
+
+    profilerRect(frame, 0, Top, TIC80_WIDTH, Height, pal[tic_color_0]);
+
+    s32 frames = MIN(profile->frame, TIC80_WIDTH);
+
+    for(s32 i = 0; i < frames; i++)
+    {
+        const u64* phases = profile->frames[(profile->frame - 1 - i) % TIC_PROFILE_FRAMES];
+        s32 x = TIC80_WIDTH - 1 - i;
+        double ms = 0;
+        s32 bottom = TIC80_HEIGHT;
+
+        for(s32 p = 0; p < tic_profile_phases; p++)
+        {
+            ms += phases[p] * 1000.0 / profile->freq;
+            s32 top = MAX(Top, TIC80_HEIGHT - (s32)(ms * Scale));
+
+            if(top < bottom)
+                profilerRect(frame, x, top, 1, bottom - top, pal[Colors[p]]);
+
+            bottom = top;
+        }
+    }
+
+    profilerRect(frame, 0, TIC80_HEIGHT - Scale * 1000 / TIC80_FRAMERATE, TIC80_WIDTH, 1, pal[tic_color_12]);
+
+    // average of the last second for every phase, wrapped to two rows
+    {
+        s32 count = MIN(profile->frame, TIC80_FRAMERATE);
+        s32 x = 1, y = Averages + 1;
+
+        profilerRect(frame, 0, Averages, TIC80_WIDTH, TIC_FONT_HEIGHT * 2 + 1, pal[tic_color_0]);
+
+        for(s32 p = 0; p < tic_profile_phases; p++)
+        {
+            u64 sum = 0;
+            for(s32 i = 0; i < count; i++)
+                sum += profile->frames[(profile->frame - 1 - i) % TIC_PROFILE_FRAMES][p];
+
+            char label[32];
+            snprintf(label, sizeof label, "%s %.2f", Labels[p], count ? sum * 1000.0 / profile->freq / count : 0.0);
+
+            if(x + (s32)strlen(label) * TIC_ALTFONT_WIDTH > TIC80_WIDTH)
+            {
+                x = 1;
+                y += TIC_FONT_HEIGHT;
+            }
+
+            x += profilerPrint(frame, label, x, y, pal[Colors[p]]) + TIC_ALTFONT_WIDTH;
+        }
+    }
+
+    // the rows are uploaded this frame and converted from VRAM again on the next blit
+    tic_core_screen_drawn(tic, ProfilerTop + Averages, ProfilerTop + TIC80_HEIGHT);
+}
+
 static void renderStudio()
 {
     tic_mem* tic = impl.studio.tic;
@@ -1732,7 +1946,7 @@ static void renderStudio()
         }
 
         sfx2ram(&tic->ram, sfx);
-        music2ram(&tic->ram, music);
+        music2ram(tic, music);
 
         tic_core_tick_start(impl.studio.tic);
     }
@@ -1810,7 +2024,7 @@ static void updateSystemFont()
                 if(tic_tool_peek4(&impl.config->cart.bank0.sprites.data[i], TIC_SPRITESIZE*y + x))
                     impl.systemFont.data[i*BITS_IN_BYTE+y] |= 1 << x;
 
-    memcpy(tic->ram.font.data, impl.systemFont.data, sizeof(tic_font));
+    font2ram(tic, &impl.systemFont);
 }
 
 void studioConfigChanged()
@@ -1876,7 +2090,13 @@ static void studioTick()
 {
     tic_mem* tic = impl.studio.tic;
 
+    tic_core_profile_frame(tic);
+
     processShortcuts();
+
+    // the heatmap replaces the running cart only, the editors are drawn as usual
+    tic_core_overdraw(tic, impl.overdraw && impl.mode == TIC_RUN_MODE);
+
     processMouseStates();
     processGamepadMapping();
 
@@ -1938,7 +2158,7 @@ static void studioTick()
         if(impl.mode != TIC_RUN_MODE)
         {
             memcpy(tic->ram.vram.palette.data, getConfig()->cart->bank0.palette.scn.data, sizeof(tic_palette));
-            memcpy(tic->ram.font.data, impl.systemFont.data, sizeof(tic_font));
+            font2ram(tic, &impl.systemFont);
         }
 
         data
@@ -1950,6 +2170,7 @@ static void studioTick()
     }
 
     drawPopup();
+    drawProfiler();
 
     impl.studio.text = '\0';
 }
@@ -38,6 +38,7 @@
 #define TIC_LOCAL ".local/"
 #define TIC_LOCAL_VERSION TIC_LOCAL TIC_VERSION_LABEL "/"
 #define TIC_CACHE TIC_LOCAL "cache/"
+#define TIC_CODE_CACHE TIC_LOCAL_VERSION "cache/"
 
 #define TOOLBAR_SIZE 7
 #define STUDIO_TEXT_WIDTH (TIC_FONT_WIDTH)
@@ -113,6 +114,13 @@ void resumeRunMode();
 EditorMode getStudioMode();
 void exitStudio();
 
+void showProfiler(bool show);
+bool isProfilerShown();
+void showOverdraw(bool show);
+bool isOverdrawShown();
+void startTrace(bool api);
+void stopTrace();
+
 void toClipboard(const void* data, s32 size, bool flip);
 bool fromClipboard(void* data, s32 size, bool flip, bool remove_white_spaces);
 
@@ -180,6 +188,7 @@ bool hasProjectExt(const char* name);
 void sfx_stop(tic_mem* tic, s32 channel);
 const char* studioExportMusic(s32 track);
 const char* studioExportSfx(s32 sfx);
+s32 studioExportAllAudio(bool sfx);
 s32 calcWaveAnimation(tic_mem* tic, u32 index, s32 channel);
 void map2ram(tic_ram* ram, const tic_map* src);
-void tiles2ram(tic_ram* ram, const tic_tiles* src);
+void tiles2ram(tic_mem* tic, const tic_tiles* src);
@@ -201,7 +201,7 @@ static void drawTopToolbar(Surf* surf, s32 x, s32 y)
     enum{Gap = 10, TipX = 150, SelectWidth = 54};
 
     u8 colorkey = 0;
-    tiles2ram(&tic->ram, &getConfig()->cart->bank0.tiles);
+    tiles2ram(tic, &getConfig()->cart->bank0.tiles);
     tic_api_spr(tic, 12, TipX, y+1, 1, 1, &colorkey, 1, 1, tic_no_flip, tic_no_rotate);
     {
         static const char Label[] = "SELECT";
@@ -245,7 +245,7 @@ static void drawBottomToolbar(Surf* surf, s32 x, s32 y)
 
         u8 colorkey = 0;
 
-        tiles2ram(&tic->ram, &getConfig()->cart->bank0.tiles);
+        tiles2ram(tic, &getConfig()->cart->bank0.tiles);
         tic_api_spr(tic, 15, TipX + SelectWidth, y + 1, 1, 1, &colorkey, 1, 1, tic_no_flip, tic_no_rotate);
         {
             static const char Label[] = "WEBSITE";
@@ -272,6 +272,8 @@ static void drawCover(Surf* surf, s32 pos, s32 x, s32 y)
     {
         for(s32 yc = 0; yc < Height; yc++)
             memcpy(tic->ram.vram.screen.data + (yc * TIC80_WIDTH)/2, cover->data + (yc * Width)/2, Width/2);
+
+        tic_core_invalidate(tic, offsetof(tic_ram, vram.screen), sizeof(tic_screen));
     }
 }
 
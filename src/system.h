@@ -167,6 +167,12 @@ typedef struct
 
     s32 uiScale;
 
+    struct
+    {
+        s32 ring;       // ticks queued for the audio thread, 0 queues whole frames of samples instead
+        s32 buffer;     // stereo frames the audio device asks for at once
+    } audio;
+
 } StudioConfig;
 
 typedef struct
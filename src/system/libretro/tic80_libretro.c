@@ -39,6 +39,7 @@ struct tic80_state
 	tic80_input input;
 	int keymap[RETROK_LAST];
 	bool variablePointerApi;
+	bool canDupe;
 	u8 mouseCursor;
 	u16 mousePreviousX;
 	u16 mousePreviousY;
@@ -605,8 +606,16 @@ void tic80_libretro_update(tic80* game)
  */
 void tic80_libretro_draw(tic80* game)
 {
+	tic80_local* local = (tic80_local*)game;
+
 	// Render the mouse cursor if needed.
-	tic80_libretro_mousecursor((tic80_local*)game, &state->input.mouse, state->mouseCursor);
+	tic80_libretro_mousecursor(local, &state->input.mouse, state->mouseCursor);
+
+	// Let the frontend repeat the previous frame if no rows have changed.
+	if (state->canDupe && local->memory->dirty.count == 0) {
+		video_cb(NULL, TIC80_FULLWIDTH, TIC80_FULLHEIGHT, TIC80_FULLWIDTH << 2);
+		return;
+	}
 
 	// Render to the screen.
 	video_cb(game->screen, TIC80_FULLWIDTH, TIC80_FULLHEIGHT, TIC80_FULLWIDTH << 2);
@@ -711,6 +720,11 @@ RETRO_API bool retro_load_game(const struct retro_game_info *info)
 		return false;
 	}
 
+	// Frame duping lets unchanged frames skip the video upload.
+	if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &state->canDupe)) {
+		state->canDupe = false;
+	}
+
 	// Check for the content.
 	if (info == NULL) {
 		log_cb(RETRO_LOG_ERROR, "[TIC-80] No content information provided.\n");
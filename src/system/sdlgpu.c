@@ -147,6 +147,7 @@ static struct
         SDL_AudioSpec       spec;
         SDL_AudioDeviceID   device;
         SDL_AudioCVT        cvt;
+        bool                ring;   // the device callback synthesizes the sound, see initRingSound
     } audio;
 } platform
 #if defined(TOUCH_INPUT_SUPPORT)
@@ -184,6 +185,52 @@ static void initSound()
     }
 }
 
+static void audioCallback(void* userdata, u8* stream, s32 len)
+{
+    tic_core_synth_audio(platform.studio->tic, (s16*)stream, len / (sizeof(s16) * TIC_STEREO_CHANNELS));
+}
+
+// the device is opened again with a callback, SDL converts the samples to the device format itself
+static void initRingSound()
+{
+    const StudioConfig* config = platform.studio->config();
+
+    if(config->audio.ring <= 0) return;
+
+    SDL_AudioSpec want =
+    {
+        .freq = platform.audio.spec.freq,
+        .format = AUDIO_S16,
+        .channels = TIC_STEREO_CHANNELS,
+        .samples = config->audio.buffer > 0 ? config->audio.buffer : 256,
+        .callback = audioCallback,
+        .userdata = NULL,
+    };
+
+    SDL_AudioSpec have;
+    SDL_AudioDeviceID device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+
+    if(!device) return;
+
+    if(!tic_core_audio_ring(platform.studio->tic, config->audio.ring))
+    {
+        SDL_CloseAudioDevice(device);
+        return;
+    }
+
+    SDL_CloseAudioDevice(platform.audio.device);
+
+    if(platform.audio.cvt.buf)
+        SDL_free(platform.audio.cvt.buf);
+
+    platform.audio.cvt.buf = NULL;
+    platform.audio.cvt.needed = 0;
+
+    platform.audio.device = device;
+    platform.audio.spec = have;
+    platform.audio.ring = true;
+}
+
 static const u8* getSpritePtr(const tic_tile* tiles, s32 x, s32 y)
 {
     enum { SheetCols = (TIC_SPRITESHEET_SIZE / TIC_SPRITESIZE) };
@@ -202,7 +249,8 @@ static void setWindowIcon()
 
     u32* pixels = SDL_malloc(Size * Size * sizeof(u32));
 
-    const u32* pal = tic_tool_palette_blit(&platform.studio->config()->cart->bank0.palette.scn, platform.studio->tic->screen_format);
+    u32 pal[TIC_PALETTE_SIZE];
+    tic_tool_palette_blit(pal, &platform.studio->config()->cart->bank0.palette.scn, platform.studio->tic->screen_format);
 
     for(s32 j = 0, index = 0; j < Size; j++)
         for(s32 i = 0; i < Size; i++, index++)
@@ -258,6 +306,7 @@ static void map2ram()
     tic_mem* tic = platform.studio->tic;
     memcpy(tic->ram.map.data, &platform.studio->config()->cart->bank0.map, sizeof tic->ram.map);
     memcpy(tic->ram.tiles.data, &platform.studio->config()->cart->bank0.tiles, sizeof tic->ram.tiles * TIC_SPRITE_BANKS);
+    tic_core_invalidate(tic, offsetof(tic_ram, tiles), sizeof tic->ram.tiles * TIC_SPRITE_BANKS);
 }
 
 #if defined(TOUCH_INPUT_SUPPORT)
@@ -277,7 +326,8 @@ static void initTouchGamepad()
 
             const u8* in = platform.studio->tic->ram.vram.screen.data;
             const u8* end = in + sizeof(platform.studio->tic->ram.vram.screen);
-            const u32* pal = tic_tool_palette_blit(&platform.studio->config()->cart->bank0.palette, platform.studio->tic->screen_format);
+            u32 pal[TIC_PALETTE_SIZE];
+            tic_tool_palette_blit(pal, &platform.studio->config()->cart->bank0.palette.scn, platform.studio->tic->screen_format);
             const u32 Delta = ((TIC80_FULLWIDTH*sizeof(u32))/sizeof *out - TIC80_WIDTH);
 
             s32 col = 0;
@@ -304,6 +354,7 @@ static void initTouchGamepad()
 
         memset(&platform.studio->tic->ram.map, 0, sizeof(tic_map));
         memset(&platform.studio->tic->ram.tiles, 0, sizeof(tic_tiles) * TIC_SPRITE_BANKS);
+        tic_core_invalidate(platform.studio->tic, offsetof(tic_ram, tiles), sizeof(tic_tiles) * TIC_SPRITE_BANKS);
     }
 
     if(!platform.gamepad.touch.texture)
@@ -939,7 +990,10 @@ static void blitSound()
     tic_mem* tic = platform.studio->tic;
 
     SDL_PauseAudioDevice(platform.audio.device, 0);
-    
+
+    // the callback takes the sound registers queued by the tick
+    if(platform.audio.ring) return;
+
     if(platform.audio.cvt.needed)
     {
         SDL_memcpy(platform.audio.cvt.buf, tic->samples.buffer, tic->samples.size);
@@ -1015,7 +1069,8 @@ static void blitCursor(const u8* in)
         platform.mouse.src = in;
 
         const u8* end = in + sizeof(tic_tile);
-        const u32* pal = tic_tool_palette_blit(&platform.studio->tic->ram.vram.palette, platform.studio->tic->screen_format);
+        u32 pal[TIC_PALETTE_SIZE];
+        tic_tool_palette_blit(pal, &platform.studio->tic->ram.vram.palette, platform.studio->tic->screen_format);
         static u32 data[TIC_SPRITESIZE*TIC_SPRITESIZE];
         u32* out = data;
 
@@ -1394,7 +1449,14 @@ static void gpuTick()
     {
         platform.studio->tick();
 
-        GPU_UpdateImageBytes(platform.gpu.texture, NULL, (const u8*)tic->screen, TIC80_FULLWIDTH * sizeof(u32));
+        tic_core_profile_begin(tic, tic_profile_present);
+
+        // upload only the rows changed by the last blit
+        if(tic->dirty.count)
+        {
+            GPU_Rect rect = {0, tic->dirty.top, TIC80_FULLWIDTH, tic->dirty.bottom - tic->dirty.top};
+            GPU_UpdateImageBytes(platform.gpu.texture, &rect, (const u8*)(tic->screen + tic->dirty.top * TIC80_FULLWIDTH), TIC80_FULLWIDTH * sizeof(u32));
+        }
 
 #if defined(CRT_SHADER_SUPPORT)            
         if(platform.studio->config()->crtMonitor)
@@ -1442,6 +1504,8 @@ static void gpuTick()
 
     GPU_Flip(platform.gpu.screen);
 
+    tic_core_profile_end(tic, tic_profile_present);
+
     blitSound();
 }
 
@@ -1497,6 +1561,8 @@ static s32 start(s32 argc, char **argv, const char* folder)
 
     platform.studio = studioInit(argc, argv, platform.audio.spec.freq, folder, &systemInterface);
 
+    initRingSound();
+
     const s32 Width = TIC80_FULLWIDTH * platform.studio->config()->uiScale;
     const s32 Height = TIC80_FULLHEIGHT * platform.studio->config()->uiScale;
 
@@ -1546,6 +1612,9 @@ static s32 start(s32 argc, char **argv, const char* folder)
         SDL_StopTextInput();
 #endif
 
+    // the audio callback uses the machine until the device is closed
+    SDL_CloseAudioDevice(platform.audio.device);
+
     platform.studio->close();
 
     closeNet(platform.net);
@@ -1561,7 +1630,6 @@ static s32 start(s32 argc, char **argv, const char* folder)
 #endif    
 
     SDL_DestroyWindow(platform.window);
-    SDL_CloseAudioDevice(platform.audio.device);
 
     for(s32 i = 0; i < COUNT_OF(platform.mouse.cursors); i++)
         SDL_FreeCursor(platform.mouse.cursors[i]);
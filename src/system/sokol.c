@@ -196,7 +196,7 @@ static void app_frame(void)
     handleKeyboard();
     platform.studio->tick(input);
 
-    sokol_gfx_draw(platform.studio->tic->screen);
+    sokol_gfx_draw(tic->dirty.count ? tic->screen : NULL);
 
     s32 count = tic->samples.size / sizeof tic->samples.buffer[0];
     for(s32 i = 0; i < count; i++)
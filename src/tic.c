@@ -32,6 +32,14 @@
 #include <3ds.h>
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "ticapi.h"
 #include "tools.h"
 #include "tilesheet.h"
@@ -80,11 +88,98 @@ static inline s32 param2val(const tic_track_row* row)
     return (row->param1 << 4) | row->param2;
 }
 
-static void update_amp(blip_buffer_t* blip, tic_sound_register_data* data, s32 new_amp )
+static const tic_music_track* getMusicTrack(tic_machine* machine, s32 index)
 {
-    s32 delta = new_amp - data->amp;
-    data->amp += delta;
-    blip_add_delta( blip, data->time, delta );
+    tic_music_track* decoded = &machine->musiccache.tracks[index];
+
+    if(!decoded->valid)
+    {
+        const tic_track* track = &machine->memory.ram.music.tracks.data[index];
+
+        s32 speed = getSpeed(track), period = getTempo(track) * DEFAULT_SPEED;
+
+        decoded->valid = true;
+        decoded->rows = MUSIC_PATTERN_ROWS - track->rows;
+
+        // tick2row() reaches a row at the first tick that isn't below the exact row time,
+        // a broken speed never leaves the first row
+        for(s32 r = 0; r <= MUSIC_PATTERN_ROWS; r++)
+        {
+            decoded->start[r] = speed > 0 ? (r * speed * NOTES_PER_MUNUTE + period - 1) / period : r ? INT32_MAX : 0;
+            decoded->seek[r] = row2tick(track, r);
+        }
+
+        for(s32 f = 0; f < MUSIC_FRAMES; f++)
+        {
+            decoded->empty[f] = true;
+
+            for(s32 c = 0; c < TIC_SOUND_CHANNELS; c++)
+            {
+                // the ids past the last pattern are played as empty ones
+                s32 id = tic_tool_get_pattern_id(track, f, c);
+                decoded->patterns[f][c] = id < PATTERN_START + MUSIC_PATTERNS ? id : 0;
+
+                if(decoded->patterns[f][c])
+                    decoded->empty[f] = false;
+            }
+        }
+    }
+
+    return decoded;
+}
+
+static const tic_music_pattern* getMusicPattern(tic_machine* machine, s32 index)
+{
+    tic_music_pattern* decoded = &machine->musiccache.patterns[index];
+
+    if(!decoded->valid)
+    {
+        const tic_track_pattern* pattern = &machine->memory.ram.music.patterns.data[index];
+
+        decoded->valid = true;
+
+        for(s32 r = 0; r < MUSIC_PATTERN_ROWS; r++)
+        {
+            const tic_track_row* src = &pattern->rows[r];
+
+            decoded->rows[r] = (tic_music_row)
+            {
+                .note = src->note,
+                .octave = src->octave,
+                .command = src->command,
+                .param1 = src->param1,
+                .param2 = src->param2,
+                .sfx = tic_tool_get_track_row_sfx(src),
+                .param = param2val(src),
+            };
+        }
+    }
+
+    return decoded;
+}
+
+static s32 trackRow(const tic_music_track* decoded, const tic_track* track, s32 tick)
+{
+    if(tick < 0 || tick >= decoded->start[MUSIC_PATTERN_ROWS])
+        return tick2row(track, tick);
+
+    // the last row started at the tick
+    s32 lo = 0, hi = MUSIC_PATTERN_ROWS;
+
+    while(hi - lo > 1)
+    {
+        s32 mid = (lo + hi) / 2;
+
+        if(decoded->start[mid] <= tick) lo = mid;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+static s32 trackTick(const tic_music_track* decoded, const tic_track* track, s32 row)
+{
+    return row >= 0 && row <= MUSIC_PATTERN_ROWS ? decoded->seek[row] : row2tick(track, row);
 }
 
 static inline s32 freq2period(s32 freq)
@@ -107,33 +202,81 @@ static inline s32 getAmp(const tic_sound_register* reg, s32 amp)
     return (amp * AmpMax / MAX_VOLUME) * reg->volume / MAX_VOLUME / TIC_SOUND_CHANNELS;
 }
 
-static void runEnvelope(blip_buffer_t* blip, const tic_sound_register* reg, tic_sound_register_data* data, s32 end_time, u8 volume)
+static const tic_sound_wave* getSoundWave(tic_sound_synth* synth, const tic_sound_register* reg, s32 channel, u8 left, u8 right)
 {
-    s32 period = freq2period(reg->freq * ENVELOPE_FREQ_SCALE);
+    tic_sound_wave* wave = &synth->waves[channel];
 
-    for ( ; data->time < end_time; data->time += period )
+    if(!wave->valid || wave->volume != reg->volume || wave->left != left || wave->right != right
+        || memcmp(&wave->waveform, &reg->waveform, sizeof(tic_waveform)) != 0)
     {
-        data->phase = (data->phase + 1) % WAVE_VALUES;
+        wave->waveform = reg->waveform;
+        wave->volume = reg->volume;
+        wave->left = left;
+        wave->right = right;
+        wave->valid = true;
 
-        update_amp(blip, data, getAmp(reg, tic_tool_peek4(reg->waveform.data, data->phase) * volume / MAX_VOLUME));
+        for(s32 i = 0; i < WAVE_VALUES; i++)
+        {
+            s32 value = tic_tool_peek4(reg->waveform.data, i);
+            wave->amps[0][i] = getAmp(reg, value * left / MAX_VOLUME);
+            wave->amps[1][i] = getAmp(reg, value * right / MAX_VOLUME);
+        }
     }
+
+    return wave;
+}
+
+// the sides of a channel only differ by the volume, so they step with the same time and phase
+// and are rendered in one pass, a delta is only emitted where the amplitude of the side changes
+#define SOUND_STEPS_BODY(NEXT, LEFT, RIGHT) do { \
+    s32 time = left->time, phase = left->phase; \
+    s32 ampLeft = left->amp, ampRight = right->amp; \
+    for(; time < end_time; time += period) \
+    { \
+        NEXT; \
+        s32 newLeft = LEFT, newRight = RIGHT; \
+        if(newLeft != ampLeft) blip_add_delta(blips[0], time, newLeft - ampLeft), ampLeft = newLeft; \
+        if(newRight != ampRight) blip_add_delta(blips[1], time, newRight - ampRight), ampRight = newRight; \
+    } \
+    left->time = right->time = time; \
+    left->phase = right->phase = phase; \
+    left->amp = ampLeft, right->amp = ampRight; \
+    } while(0)
+
+static void runEnvelope(tic_sound_synth* synth, const tic_sound_register* reg, s32 channel, s32 end_time, u8 leftVolume, u8 rightVolume)
+{
+    tic_sound_register_data* left = &synth->registers.left[channel];
+    tic_sound_register_data* right = &synth->registers.right[channel];
+    blip_buffer_t* blips[] = {synth->blip.left, synth->blip.right};
+
+    const tic_sound_wave* wave = getSoundWave(synth, reg, channel, leftVolume, rightVolume);
+    const s32* ampsLeft = wave->amps[0];
+    const s32* ampsRight = wave->amps[1];
+    s32 period = freq2period(reg->freq * ENVELOPE_FREQ_SCALE);
+
+    SOUND_STEPS_BODY(phase = (phase + 1) % WAVE_VALUES, ampsLeft[phase], ampsRight[phase]);
 }
 
-static void runNoise(blip_buffer_t* blip, const tic_sound_register* reg, tic_sound_register_data* data, s32 end_time, u8 volume)
+static void runNoise(tic_sound_synth* synth, const tic_sound_register* reg, s32 channel, s32 end_time, u8 leftVolume, u8 rightVolume)
 {
+    tic_sound_register_data* left = &synth->registers.left[channel];
+    tic_sound_register_data* right = &synth->registers.right[channel];
+    blip_buffer_t* blips[] = {synth->blip.left, synth->blip.right};
+
     // phase is noise LFSR, which must never be zero 
-    if ( data->phase == 0 )
-        data->phase = 1;
+    if ( left->phase == 0 )
+        left->phase = 1;
     
     s32 period = freq2period(reg->freq);
+    s32 onLeft = getAmp(reg, leftVolume), onRight = getAmp(reg, rightVolume);
+    s32 off = getAmp(reg, 0);
 
-    for ( ; data->time < end_time; data->time += period )
-    {
-        data->phase = ((data->phase & 1) * (0b11 << 13)) ^ (data->phase >> 1);
-        update_amp(blip, data, getAmp(reg, (data->phase & 1) ? volume : 0));
-    }
+    SOUND_STEPS_BODY(phase = ((phase & 1) * (0b11 << 13)) ^ (phase >> 1),
+        (phase & 1) ? onLeft : off, (phase & 1) ? onRight : off);
 }
 
+#undef SOUND_STEPS_BODY
+
 static void resetBlitSegment(tic_mem* memory)
 {
     memory->ram.vram.blit.segment = 2;
@@ -153,6 +296,174 @@ static tic_tilesheet getTileSheetFromSegment(tic_mem* memory, u8 segment)
     return getTileSheet(segment, src);
 }
 
+static void invalidateMapLayer(tic_map_layer* layer)
+{
+    if(layer->cells)
+        memset(layer->cells, 0, sizeof(u16) * TIC_MAP_WIDTH * TIC_MAP_HEIGHT);
+}
+
+// bumps the generation of the layer segment tiles stored in the range, the cells rendered
+// with an older generation are rendered again, a wrapped generation drops the cells of its tile
+static void invalidateMapLayerTiles(tic_machine* machine, s32 address, s32 size)
+{
+    enum {Cols = 16, Tiles = COUNT_OF(machine->maplayer.generation)};
+
+    tic_map_layer* layer = &machine->maplayer;
+
+    if(!layer->cells) return;
+
+    tic_tilesheet sheet = getTileSheetFromSegment(&machine->memory, layer->segment);
+    const tic_blit_segment* segment = sheet.segment;
+    s32 start = (s32)(sheet.ptr - machine->memory.ram.data);
+    s32 end = address + size - start;
+
+    if(end <= 0) return;
+
+    // inverse of getTile(): a local tile index maps to a ptr_size block of its bank and page
+    s32 bank = segment->bank_orig * Tiles;
+    s32 pages = segment->nb_pages;
+    s32 cols = Cols / pages;
+    s32 first = MAX(MAX(address - start, 0) / (s32)segment->ptr_size, bank);
+    s32 last = MIN((end - 1) / (s32)segment->ptr_size, bank + Tiles - 1);
+
+    for(s32 block = first; block <= last; block++)
+    {
+        s32 row = (block - bank) / Cols;
+        s32 col = (block - bank) % Cols - segment->page_orig * cols;
+
+        if(col < 0 || col >= cols) continue;
+
+        for(s32 i = 0; i < pages; i++)
+        {
+            u8 tile = row * Cols + col * pages + i;
+
+            if(++layer->generation[tile] == 0)
+            {
+                layer->generation[tile] = 1;
+
+                for(s32 j = 0; j < TIC_MAP_WIDTH * TIC_MAP_HEIGHT; j++)
+                    if(machine->memory.ram.map.data[j] == tile)
+                        layer->cells[j] = 0;
+            }
+        }
+    }
+}
+
+static inline bool overlaps(s32 address, s32 size, s32 start, s32 end)
+{
+    return address < end && address + size > start;
+}
+
+static void invalidateMusicCache(tic_music_cache* cache, s32 address, s32 size)
+{
+    for(s32 i = 0; i < MUSIC_TRACKS; i++)
+    {
+        s32 start = offsetof(tic_ram, music.tracks.data) + i * sizeof(tic_track);
+
+        if(overlaps(address, size, start, start + sizeof(tic_track)))
+            cache->tracks[i].valid = false;
+    }
+
+    for(s32 i = 0; i < MUSIC_PATTERNS; i++)
+    {
+        s32 start = offsetof(tic_ram, music.patterns.data) + i * sizeof(tic_track_pattern);
+
+        if(overlaps(address, size, start, start + sizeof(tic_track_pattern)))
+            cache->patterns[i].valid = false;
+    }
+}
+
+static void invalidateGlyphs(tic_glyph_cache* cache, s32 address, s32 size)
+{
+    enum {Count = COUNT_OF(cache->items), Block = sizeof(tic_tile)};
+
+    // glyph numbers count 8 * bpp bytes from the start of RAM, drop every glyph of the written tiles
+    s32 first = MAX(address, 0) / Block;
+    s32 last = (address + size - 1) / Block;
+
+    if((last - first + 1) * Block / TIC_SPRITESIZE >= Count)
+    {
+        memset(cache, 0, sizeof *cache);
+        return;
+    }
+
+    for(u32 bpp = 1; bpp <= 4; bpp <<= 1)
+        for(u32 n = first * 4 / bpp; n < (last + 1) * 4 / bpp; n++)
+        {
+            tic_glyph* item = &cache->items[n % Count];
+
+            if(item->tag == (n << 3 | bpp))
+                item->tag = 0;
+        }
+}
+
+// a texture row is decoded from 16 tiles of the sheet, drop the rows made of the written tiles
+static void invalidateSheetTexture(tic_machine* machine, s32 address, s32 size)
+{
+    enum {Cols = TIC_SPRITESHEET_SIZE / TIC_SPRITESIZE, Rows = COUNT_OF(machine->texture.valid)};
+
+    tic_sheet_texture* texture = &machine->texture;
+    tic_tilesheet sheet = getTileSheetFromSegment(&machine->memory, texture->segment);
+    s32 rowSize = (s32)sheet.segment->ptr_size * Cols;
+    s32 start = address - (s32)(sheet.ptr - machine->memory.ram.data);
+    s32 end = start + size;
+
+    if(end <= 0 || start >= rowSize * Rows) return;
+
+    s32 first = MAX(start, 0) / rowSize;
+    s32 last = MIN((end - 1) / rowSize, Rows - 1);
+
+    memset(texture->valid + first, 0, (last - first + 1) * sizeof texture->valid[0]);
+}
+
+static void invalidateRam(tic_machine* machine, s32 address, s32 size)
+{
+    invalidateTileCache(&machine->tilecache, address - (s32)offsetof(tic_ram, tiles), size);
+
+    if(overlaps(address, size, offsetof(tic_ram, music), offsetof(tic_ram, music) + sizeof(tic_music)))
+        invalidateMusicCache(&machine->musiccache, address, size);
+
+    // map writes are caught by the cell check, tile and font writes drop the layer cells, glyphs and texture rows of their tiles
+    if(overlaps(address, size, offsetof(tic_ram, tiles), offsetof(tic_ram, map))
+        || overlaps(address, size, offsetof(tic_ram, font), offsetof(tic_ram, font) + sizeof(tic_font)))
+    {
+        invalidateMapLayerTiles(machine, address, size);
+        invalidateGlyphs(&machine->glyphs, address, size);
+        invalidateSheetTexture(machine, address, size);
+    }
+
+    // mark the VRAM screen rows overlapped by the range
+    {
+        enum {RowSize = TIC80_WIDTH / 2};
+
+        s32 start = MAX(address - (s32)offsetof(tic_ram, vram.screen), 0);
+        s32 end = MIN(address + size - (s32)offsetof(tic_ram, vram.screen), (s32)sizeof(tic_screen));
+
+        if(start < end)
+            memset(machine->dirty.vram + start / RowSize, true, (end - 1) / RowSize - start / RowSize + 1);
+    }
+}
+
+static void markScreenChanged(tic_machine* machine, s32 row)
+{
+    if(machine->dirty.changed[row]) return;
+
+    machine->dirty.changed[row] = true;
+
+    tic_mem* tic = &machine->memory;
+
+    if(tic->dirty.count++)
+    {
+        tic->dirty.top = MIN(tic->dirty.top, row);
+        tic->dirty.bottom = MAX(tic->dirty.bottom, row + 1);
+    }
+    else
+    {
+        tic->dirty.top = row;
+        tic->dirty.bottom = row + 1;
+    }
+}
+
 static void resetPalette(tic_mem* memory)
 {
     static const u8 DefaultMapping[] = {16, 50, 84, 118, 152, 186, 220, 254};
@@ -160,9 +471,8 @@ static void resetPalette(tic_mem* memory)
     memcpy(memory->ram.vram.mapping, DefaultMapping, sizeof DefaultMapping);
 }
 
-static u8* getPalette(tic_mem* tic, u8* colors, u8 count)
+static u8* getPalette(tic_mem* tic, u8* colors, u8 count, u8* mapping)
 {
-    static u8 mapping[TIC_PALETTE_SIZE];
     for (s32 i = 0; i < TIC_PALETTE_SIZE; i++) mapping[i] = tic_tool_peek4(tic->ram.vram.mapping, i);
     for (s32 i = 0; i < count; i++) mapping[colors[i]] = TRANSPARENT_COLOR;
     return mapping;
@@ -175,7 +485,10 @@ static inline u8 mapColor(tic_mem* tic, u8 color)
 
 static void setPixelDma(tic_mem* tic, s32 x, s32 y, u8 color)
 {
-    tic_tool_poke4(tic->ram.vram.screen.data, y * TIC80_WIDTH + x, color);
+    tic_machine* machine = (tic_machine*)tic;
+
+    tic_tool_poke4(machine->state.target.data, y * TIC80_WIDTH + x, color);
+    machine->state.target.dirty[y] = true;
 }
 
 static inline u32* getOvrAddr(tic_mem* tic, s32 x, s32 y)
@@ -186,11 +499,22 @@ static inline u32* getOvrAddr(tic_mem* tic, s32 x, s32 y)
     return tic->screen + x + (y << TIC80_FULLWIDTH_BITS) + (Left + Top * TIC80_FULLWIDTH);
 }
 
+static inline void markOvrRow(tic_machine* machine, s32 y)
+{
+    enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2};
+
+    if(machine->dirty.ovr[y]) return;
+
+    machine->dirty.ovr[y] = true;
+    markScreenChanged(machine, y + Top);
+}
+
 static void setPixelOvr(tic_mem* tic, s32 x, s32 y, u8 color)
 {
     tic_machine* machine = (tic_machine*)tic;
     
     *getOvrAddr(tic, x, y) = *(machine->state.ovr.raw + color);
+    markOvrRow(machine, y);
 }
 
 static u8 getPixelOvr(tic_mem* tic, s32 x, s32 y)
@@ -211,7 +535,7 @@ static u8 getPixelDma(tic_mem* tic, s32 x, s32 y)
 {
     tic_machine* machine = (tic_machine*)tic;
 
-    return tic_tool_peek4(machine->memory.ram.vram.screen.data, y * TIC80_WIDTH + x);
+    return tic_tool_peek4(machine->state.target.data, y * TIC80_WIDTH + x);
 }
 
 static void setPixel(tic_machine* machine, s32 x, s32 y, u8 color)
@@ -230,17 +554,21 @@ static u8 getPixel(tic_machine* machine, s32 x, s32 y)
 
 static void drawHLineDma(tic_mem* memory, s32 xl, s32 xr, s32 y, u8 color)
 {
+    tic_machine* machine = (tic_machine*)memory;
+    u8* data = machine->state.target.data;
+
     color = color << 4 | color;
     if (xl >= xr) return;
+    machine->state.target.dirty[y] = true;
     if (xl & 1) {
-        tic_tool_poke4(&memory->ram.vram.screen.data, y * TIC80_WIDTH + xl, color);
+        tic_tool_poke4(data, y * TIC80_WIDTH + xl, color);
         xl++;
     }
     s32 count = (xr - xl) >> 1;
-    u8 *screen = memory->ram.vram.screen.data + ((y * TIC80_WIDTH + xl) >> 1);
+    u8 *screen = data + ((y * TIC80_WIDTH + xl) >> 1);
     for(s32 i = 0; i < count; i++) *screen++ = color;
     if (xr & 1) {
-        tic_tool_poke4(&memory->ram.vram.screen.data, y * TIC80_WIDTH + xr - 1, color);
+        tic_tool_poke4(data, y * TIC80_WIDTH + xr - 1, color);
     }
 }
 
@@ -248,11 +576,157 @@ static void drawHLineOvr(tic_mem* tic, s32 x1, s32 x2, s32 y, u8 color)
 {
     tic_machine* machine = (tic_machine*)tic;
     u32 final_color = *(machine->state.ovr.raw + color);
+    if (x1 >= x2) return;
+    markOvrRow(machine, y);
     for(s32 x = x1; x < x2; ++x) {
         *getOvrAddr(tic, x, y) = final_color;
     }
 }
 
+// the overdraw view counts screen writes with these instead of the DMA functions,
+// the fast paths write the same target and count with the helpers below when they are selected
+static inline void countPixels(tic_machine* machine, s32 pos, s32 count)
+{
+    u16* counts = machine->overdraw.counts + pos;
+
+    for(s32 i = 0; i < count; i++)
+        counts[i] += counts[i] != UINT16_MAX;
+
+    machine->overdraw.pixels += count;
+}
+
+static void setPixelCount(tic_mem* tic, s32 x, s32 y, u8 color)
+{
+    setPixelDma(tic, x, y, color);
+    countPixels((tic_machine*)tic, y * TIC80_WIDTH + x, 1);
+}
+
+static void drawHLineCount(tic_mem* tic, s32 xl, s32 xr, s32 y, u8 color)
+{
+    if (xl >= xr) return;
+
+    drawHLineDma(tic, xl, xr, y, color);
+    countPixels((tic_machine*)tic, y * TIC80_WIDTH + xl, xr - xl);
+}
+
+// counts the opaque pixels of a line of mapped colors written from pos
+static inline void countLine(tic_machine* machine, s32 pos, const u8* line, s32 count)
+{
+    u16* counts = machine->overdraw.counts + pos;
+
+    for(s32 i = 0; i < count; i++)
+        if(line[i] != TRANSPARENT_COLOR)
+        {
+            counts[i] += counts[i] != UINT16_MAX;
+            machine->overdraw.pixels++;
+        }
+}
+
+// the fast paths write the DMA target directly, the counting functions draw to it too
+static inline bool isDmaDraw(tic_machine* machine)
+{
+    return machine->state.setpix == setPixelDma || machine->state.setpix == setPixelCount;
+}
+
+// offscreen targets are drawn with the DMA functions, the screen with the functions of the current phase
+static void setDrawTarget(tic_machine* machine, s32 index, bool ovr)
+{
+    machine->state.target.index = index;
+    machine->state.target.ovr = ovr;
+
+    if(index < 0)
+    {
+        machine->state.target.data = machine->memory.ram.vram.screen.data;
+        machine->state.target.dirty = machine->dirty.vram;
+    }
+    else
+    {
+        machine->state.target.data = machine->targets[index].data;
+        machine->state.target.dirty = machine->dirty.target;
+    }
+
+    if(index < 0 && ovr)
+    {
+        machine->state.setpix = setPixelOvr;
+        machine->state.getpix = getPixelOvr;
+        machine->state.drawhline = drawHLineOvr;
+    }
+    else if(index < 0 && machine->memory.overdraw.active)
+    {
+        machine->state.setpix = setPixelCount;
+        machine->state.getpix = getPixelDma;
+        machine->state.drawhline = drawHLineCount;
+    }
+    else
+    {
+        machine->state.setpix = setPixelDma;
+        machine->state.getpix = getPixelDma;
+        machine->state.drawhline = drawHLineDma;
+    }
+}
+
+
+// draw calls made by TIC() go to the draw list when it's enabled,
+// any other call waits until the worker has drawn the recorded ones
+static inline bool recordDraw(tic_machine* machine)
+{
+    if(!machine->drawlist) return false;
+
+    if(tic_drawlist_recording(machine->drawlist)) return true;
+
+    tic_drawlist_flush(machine->drawlist);
+    return false;
+}
+
+static inline void syncDraw(tic_machine* machine)
+{
+    if(machine->drawlist)
+        tic_drawlist_flush(machine->drawlist);
+}
+
+// script callbacks made while drawing (map remap) draw right away,
+// so the recording is stopped until the caller is done with them
+static inline bool pauseDraw(tic_machine* machine)
+{
+    bool recording = tic_drawlist_recording(machine->drawlist);
+
+    if(recording)
+        tic_drawlist_end(machine->drawlist);
+
+    syncDraw(machine);
+    return recording;
+}
+
+static inline void resumeDraw(tic_machine* machine, bool recording)
+{
+    if(recording)
+        tic_drawlist_begin(machine->drawlist);
+}
+
+static tic_draw_colors drawColors(const u8* colors, s32 count)
+{
+    tic_draw_colors result = {{0}, MAX(MIN(count, TIC_PALETTE_SIZE), 0)};
+    memcpy(result.data, colors, result.count);
+    return result;
+}
+
+// text is recorded when it fits the command, the width is measured right away
+static bool recordText(tic_machine* machine, const char* text)
+{
+    if(!machine->drawlist) return false;
+
+    if(tic_drawlist_recording(machine->drawlist) && strlen(text) < TIC_DRAW_TEXT_SIZE) return true;
+
+    tic_drawlist_flush(machine->drawlist);
+    return false;
+}
+
+#define RECORD_DRAW(memory, ...) do { \
+    if(recordDraw((tic_machine*)(memory))) \
+    { \
+        tic_drawlist_push(((tic_machine*)(memory))->drawlist, &(tic_draw_command){__VA_ARGS__}); \
+        return; \
+    } } while(0)
 
 #define EARLY_CLIP(x, y, width, height) \
     ( \
@@ -310,11 +784,193 @@ static void drawRectBorder(tic_machine* machine, s32 x, s32 y, s32 width, s32 he
     } \
     } while(0)
 
-#define REVERT(X) (TIC_SPRITESIZE - 1 - (X))
+static inline const u8* getTilePixels(tic_machine* machine, const tic_tileptr* tile)
+{
+    return getTileCachePixels(&machine->tilecache, &machine->memory.ram.tiles, tile);
+}
+
+static inline u8 getCachedTilePixel(const tic_tileptr* tile, const u8* pixels, s32 x, s32 y)
+{
+    return pixels ? pixels[x + y * tile->segment->tile_width] : getTilePixel(tile, x, y);
+}
+
+#define REVERT(X) (TIC_SPRITESIZE - 1 - (X))
+
+static inline void setNibbleDma(u8* screen, s32 pos, u8 color)
+{
+    u8* dst = screen + (pos >> 1);
+    *dst = pos & 1 ? (*dst & 0x0f) | (color << 4) : (*dst & 0xf0) | color;
+}
+
+// writes [sx, ex) pixels of the tile line starting at (x, y), two pixels per byte when possible
+static void drawTileLineDma(tic_mem* memory, const u8* line, s32 x, s32 y, s32 sx, s32 ex)
+{
+    tic_machine* machine = (tic_machine*)memory;
+    u8* screen = machine->state.target.data;
+    s32 pos = y * TIC80_WIDTH + x;
+    s32 px = sx;
+
+    machine->state.target.dirty[y] = true;
+
+    if((pos & 1) && px < ex)
+    {
+        if(line[px] != TRANSPARENT_COLOR) setNibbleDma(screen, pos, line[px]);
+        px++, pos++;
+    }
+
+    for(; px + 1 < ex; px += 2, pos += 2)
+    {
+        u8 lo = line[px];
+        u8 hi = line[px + 1];
+        u8 keep = (lo == TRANSPARENT_COLOR ? 0x0f : 0) | (hi == TRANSPARENT_COLOR ? 0xf0 : 0);
+
+        if(keep != 0xff)
+        {
+            u8* dst = screen + (pos >> 1);
+            *dst = (*dst & keep) | (((lo & 0x0f) | (hi << 4)) & ~keep);
+        }
+    }
+
+    if(px < ex && line[px] != TRANSPARENT_COLOR)
+        setNibbleDma(screen, pos, line[px]);
+
+    if(machine->state.setpix == setPixelCount && sx < ex)
+        countLine(machine, y * TIC80_WIDTH + x, line + sx, ex - sx);
+}
+
+// draws a line of mapped colors scaled into a scale x scale block per pixel, equal neighbours are
+// merged into one run and the runs are clipped once and reused for every row of the block
+static void drawScaledLine(tic_machine* machine, const u8* line, s32 count, s32 x, s32 y, s32 scale)
+{
+    s32 top = MAX(y, machine->state.clip.t);
+    s32 bottom = MIN(y + scale, machine->state.clip.b);
+
+    if(top >= bottom) return;
+
+    struct {s32 xl, xr; u8 color;} runs[TIC_SPRITESIZE];
+    s32 runsCount = 0;
+
+    for(s32 px = 0; px < count;)
+    {
+        u8 color = line[px];
+        s32 start = px;
+
+        while(++px < count && line[px] == color);
+
+        if(color == TRANSPARENT_COLOR) continue;
+
+        s32 xl = MAX(x + start * scale, machine->state.clip.l);
+        s32 xr = MIN(x + px * scale, machine->state.clip.r);
+
+        if(xl < xr)
+        {
+            runs[runsCount].xl = xl;
+            runs[runsCount].xr = xr;
+            runs[runsCount].color = color;
+            runsCount++;
+        }
+    }
+
+    if(!runsCount) return;
+
+    if(isDmaDraw(machine))
+    {
+        // the runs are packed into one row of nibbles with a mask of the kept ones and stamped on every row
+        enum {RowSize = TIC80_WIDTH / 2};
+
+        u8 value[RowSize], keep[RowSize];
+        s32 first = runs[0].xl >> 1;
+        s32 last = (runs[runsCount - 1].xr - 1) >> 1;
+
+        memset(value + first, 0, last - first + 1);
+        memset(keep + first, 0xff, last - first + 1);
+
+        for(s32 i = 0; i < runsCount; i++)
+        {
+            s32 xl = runs[i].xl, xr = runs[i].xr;
+            u8 color = runs[i].color & 0xf;
+
+            if(xl & 1)
+            {
+                value[xl >> 1] |= color << 4;
+                keep[xl >> 1] &= 0x0f;
+                xl++;
+            }
+
+            if(xr & 1)
+            {
+                value[xr >> 1] |= color;
+                keep[xr >> 1] &= 0xf0;
+                xr--;
+            }
+
+            if(xl < xr)
+            {
+                memset(value + (xl >> 1), color << 4 | color, (xr - xl) >> 1);
+                memset(keep + (xl >> 1), 0, (xr - xl) >> 1);
+            }
+        }
+
+        for(s32 row = top; row < bottom; row++)
+        {
+            u8* dst = machine->state.target.data + row * RowSize;
+
+            for(s32 i = first; i <= last; i++)
+                dst[i] = (dst[i] & keep[i]) | value[i];
+
+            machine->state.target.dirty[row] = true;
+
+            if(machine->state.setpix == setPixelCount)
+                for(s32 i = 0; i < runsCount; i++)
+                    countPixels(machine, row * TIC80_WIDTH + runs[i].xl, runs[i].xr - runs[i].xl);
+        }
+
+        return;
+    }
+
+    void (*drawhline)(tic_mem*, s32, s32, s32, u8) = machine->state.drawhline;
+
+    for(s32 row = top; row < bottom; row++)
+        for(s32 i = 0; i < runsCount; i++)
+            drawhline(&machine->memory, runs[i].xl, runs[i].xr, row, runs[i].color);
+}
+
+#define TILE_LINE_BODY(X, Y) do {\
+    for(s32 py = sy; py < ey; py++, y++) \
+    { \
+        for(s32 px = 0; px < TIC_SPRITESIZE; px++) \
+            line[px] = mapping[pixels[(Y) * stride + (X)]]; \
+        drawTileLineDma(&machine->memory, line, x, y, sx, ex); \
+    } \
+    } while(0)
+
+// fast path for decoded tiles drawn to VRAM: every row is mapped at once and written as packed nibbles
+static void drawTileDma(tic_machine* machine, const u8* pixels, s32 stride, s32 x, s32 y, s32 sx, s32 sy, s32 ex, s32 ey, const u8* mapping, u32 orientation)
+{
+    if(sx >= ex || sy >= ey) return;
+
+    u8 line[TIC_SPRITESIZE];
+
+    switch (orientation) {
+        case 0b100: TILE_LINE_BODY(py, px); break;
+        case 0b110: TILE_LINE_BODY(REVERT(py), px); break;
+        case 0b101: TILE_LINE_BODY(py, REVERT(px)); break;
+        case 0b111: TILE_LINE_BODY(REVERT(py), REVERT(px)); break;
+        case 0b000: TILE_LINE_BODY(px, py); break;
+        case 0b010: TILE_LINE_BODY(px, REVERT(py)); break;
+        case 0b001: TILE_LINE_BODY(REVERT(px), py); break;
+        case 0b011: TILE_LINE_BODY(REVERT(px), REVERT(py)); break;
+        default: assert(!"Unknown value of orientation in drawTileDma");
+    }
+}
+
+#undef TILE_LINE_BODY
 
-static void drawTile(tic_machine* machine, tic_tileptr* tile, s32 x, s32 y, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate)
+static void drawTile(tic_machine* machine, tic_tileptr* tile, s32 x, s32 y, const u8* mapping, s32 scale, tic_flip flip, tic_rotate rotate)
 {
-    u8* mapping = getPalette(&machine->memory, colors, count);
+    const u8* pixels = getTilePixels(machine, tile);
+
+    machine->overdraw.tiles++;
 
     rotate &= 0b11;
     u32 orientation = flip & 0b11;
@@ -333,6 +989,13 @@ static void drawTile(tic_machine* machine, tic_tileptr* tile, s32 x, s32 y, u8*
         ey = machine->state.clip.b - y; if (ey > TIC_SPRITESIZE) ey = TIC_SPRITESIZE;
         y += sy;
         x += sx;
+
+        if(isDmaDraw(machine) && pixels)
+        {
+            drawTileDma(machine, pixels, tile->segment->tile_width, x, y, sx, sy, ex, ey, mapping, orientation);
+            return;
+        }
+
         switch (orientation) {
             case 0b100: DRAW_TILE_BODY(py, px); break;
             case 0b110: DRAW_TILE_BODY(REVERT(py), px); break;
@@ -351,35 +1014,35 @@ static void drawTile(tic_machine* machine, tic_tileptr* tile, s32 x, s32 y, u8*
 
     for(s32 py=0; py < TIC_SPRITESIZE; py++, y+=scale)
     {
-        s32 xx = x;
-        for(s32 px=0; px < TIC_SPRITESIZE; px++, xx+=scale)
+        u8 line[TIC_SPRITESIZE];
+
+        for(s32 px=0; px < TIC_SPRITESIZE; px++)
         {
-            s32 i;
             s32 ix = orientation & 0b001 ? TIC_SPRITESIZE - px - 1: px;
             s32 iy = orientation & 0b010 ? TIC_SPRITESIZE - py - 1: py;
             if(orientation & 0b100) {
                 s32 tmp = ix; ix=iy; iy=tmp;
             }
-            u8 color = mapping[getTilePixel(tile, ix, iy)];
-            if(color != TRANSPARENT_COLOR) drawRect(machine, xx, y, scale, scale, color);
+            line[px] = mapping[getCachedTilePixel(tile, pixels, ix, iy)];
         }
+
+        drawScaledLine(machine, line, TIC_SPRITESIZE, x, y, scale);
     }
 }
 
 #undef DRAW_TILE_BODY
 #undef REVERT
 
-static void drawSprite(tic_machine* machine, s32 index, s32 x, s32 y, s32 w, s32 h, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate)
+static void drawSprite(tic_machine* machine, const tic_tilesheet* sheet, s32 index, s32 x, s32 y, s32 w, s32 h, const u8* mapping, s32 scale, tic_flip flip, tic_rotate rotate)
 {
-    tic_tilesheet sheet = getTileSheetFromSegment(&machine->memory, machine->memory.ram.vram.blit.segment);
     if ( w == 1 && h == 1){
-        tic_tileptr tile = getTile(&sheet, index, false);
-        drawTile(machine, &tile, x, y, colors, count, scale, flip, rotate);
+        tic_tileptr tile = getTile(sheet, index, false);
+        drawTile(machine, &tile, x, y, mapping, scale, flip, rotate);
     }
     else
     {
         s32 step = TIC_SPRITESIZE * scale;
-        s32 cols = sheet.segment->sheet_width;
+        s32 cols = sheet->segment->sheet_width;
 
         const tic_flip vert_horz_flip = tic_horz_flip | tic_vert_flip;
 
@@ -414,20 +1077,224 @@ static void drawSprite(tic_machine* machine, s32 index, s32 x, s32 y, s32 w, s32
                 enum {Cols = TIC_SPRITESHEET_SIZE / TIC_SPRITESIZE};
 
 
-                tic_tileptr tile = getTile(&sheet, index + mx+my*cols, false);
+                tic_tileptr tile = getTile(sheet, index + mx+my*cols, false);
                 if(rotate==0 || rotate==2)
-                    drawTile(machine, &tile, x+i*step, y+j*step, colors, count, scale, flip, rotate);
+                    drawTile(machine, &tile, x+i*step, y+j*step, mapping, scale, flip, rotate);
                 else
-                    drawTile(machine, &tile, x+j*step, y+i*step, colors, count, scale, flip, rotate);
+                    drawTile(machine, &tile, x+j*step, y+i*step, mapping, scale, flip, rotate);
             }
         }
     }
 }
 
+enum
+{
+    MapLayerWidth = TIC_MAP_WIDTH * TIC_SPRITESIZE,
+    MapLayerHeight = TIC_MAP_HEIGHT * TIC_SPRITESIZE,
+};
+
+static inline s32 wrapMapCoord(s32 value, s32 size)
+{
+    value %= size;
+    return value < 0 ? value + size : value;
+}
+
+static bool initMapLayer(tic_map_layer* layer)
+{
+    if(!layer->cells)
+    {
+        layer->cells = calloc(TIC_MAP_WIDTH * TIC_MAP_HEIGHT, sizeof(u16));
+        layer->pixels = malloc(MapLayerWidth * MapLayerHeight / 2);
+
+        if(!layer->cells || !layer->pixels)
+        {
+            free(layer->cells);
+            free(layer->pixels);
+            layer->cells = NULL;
+            layer->pixels = NULL;
+        }
+        else memset(layer->generation, 1, sizeof layer->generation);
+    }
+
+    return layer->cells != NULL;
+}
+
+static inline u16 getMapLayerCell(const tic_map_layer* layer, u8 tile)
+{
+    return tile | layer->generation[tile] << 8;
+}
+
+// the layer is rendered with the tiles of one blit segment
+static void checkMapLayerSegment(tic_machine* machine)
+{
+    tic_map_layer* layer = &machine->maplayer;
+
+    if(layer->segment != machine->memory.ram.vram.blit.segment)
+    {
+        invalidateMapLayer(layer);
+        layer->segment = machine->memory.ram.vram.blit.segment;
+    }
+}
+
+// renders the map cell into the layer if its tile has changed since the last time
+static void updateMapLayerCell(tic_machine* machine, const tic_tilesheet* sheet, const tic_map* src, s32 mi, s32 mj)
+{
+    tic_map_layer* layer = &machine->maplayer;
+    s32 index = mi + mj * TIC_MAP_WIDTH;
+    u16 cell = getMapLayerCell(layer, src->data[index]);
+
+    if(layer->cells[index] == cell) return;
+
+    layer->cells[index] = cell;
+
+    tic_tileptr tile = getTile(sheet, src->data[index], true);
+    const u8* pixels = getTilePixels(machine, &tile);
+
+    for(s32 py = 0; py < TIC_SPRITESIZE; py++)
+    {
+        s32 pos = (mj * TIC_SPRITESIZE + py) * MapLayerWidth + mi * TIC_SPRITESIZE;
+
+        for(s32 px = 0; px < TIC_SPRITESIZE; px++)
+            tic_tool_poke4(layer->pixels, pos + px, getCachedTilePixel(&tile, pixels, px, py));
+    }
+}
+
+typedef struct
+{
+    const u8* mapping;
+    u8 value[256];  // mapped pixel pair for every source byte
+    u8 keep[256];   // screen bits kept for the transparent pixels of the pair
+} PixelPairs;
+
+static void initPixelPairs(PixelPairs* pairs, const u8* mapping)
+{
+    pairs->mapping = mapping;
+
+    for(s32 i = 0; i < 256; i++)
+    {
+        u8 lo = mapping[i & 0xf];
+        u8 hi = mapping[i >> 4];
+        u8 keep = (lo == TRANSPARENT_COLOR ? 0x0f : 0) | (hi == TRANSPARENT_COLOR ? 0xf0 : 0);
+
+        pairs->keep[i] = keep;
+        pairs->value[i] = ((lo & 0x0f) | (hi << 4)) & ~keep;
+    }
+}
+
+static inline void copyPixel(u8* screen, s32 pos, const u8* row, s32 lx, const PixelPairs* pairs)
+{
+    u8 color = pairs->mapping[tic_tool_peek4(row, lx)];
+    if(color != TRANSPARENT_COLOR) setNibbleDma(screen, pos, color);
+}
+
+// copies count pixels of the source row starting at lx to the screen nibble pos
+static void copyPixelSpan(u8* screen, s32 pos, const u8* row, s32 lx, s32 count, const PixelPairs* pairs)
+{
+    if((pos & 1) && count)
+    {
+        copyPixel(screen, pos++, row, lx++, pairs);
+        count--;
+    }
+
+    u8* dst = screen + (pos >> 1);
+    const u8* src = row + (lx >> 1);
+    s32 pairsCount = count >> 1;
+
+    if(lx & 1)
+    {
+        for(s32 i = 0; i < pairsCount; i++, src++, dst++)
+        {
+            u8 b = (src[0] >> 4) | (src[1] << 4);
+            *dst = (*dst & pairs->keep[b]) | pairs->value[b];
+        }
+    }
+    else
+    {
+        for(s32 i = 0; i < pairsCount; i++, src++, dst++)
+            *dst = (*dst & pairs->keep[*src]) | pairs->value[*src];
+    }
+
+    if(count & 1)
+        copyPixel(screen, pos + count - 1, row, lx + count - 1, pairs);
+}
+
+// counts the pixels copyPixelSpan writes for the overdraw view
+static void countPixelSpan(tic_machine* machine, s32 pos, const u8* row, s32 lx, s32 count, const PixelPairs* pairs)
+{
+    u16* counts = machine->overdraw.counts + pos;
+
+    for(s32 i = 0; i < count; i++)
+        if(pairs->mapping[tic_tool_peek4(row, lx + i)] != TRANSPARENT_COLOR)
+        {
+            counts[i] += counts[i] != UINT16_MAX;
+            machine->overdraw.pixels++;
+        }
+}
+
+// unscaled map without remap drawn to VRAM: visible cells are rendered to the layer once,
+// after that every screen row is a mapped copy of a layer row
+static void drawMapLayer(tic_machine* machine, const tic_map* src, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, const u8* mapping)
+{
+    tic_mem* memory = &machine->memory;
+    tic_map_layer* layer = &machine->maplayer;
+
+    s32 l = MAX(sx, machine->state.clip.l);
+    s32 t = MAX(sy, machine->state.clip.t);
+    s32 r = MIN(sx + width * TIC_SPRITESIZE, machine->state.clip.r);
+    s32 b = MIN(sy + height * TIC_SPRITESIZE, machine->state.clip.b);
+
+    if(l >= r || t >= b) return;
+
+    checkMapLayerSegment(machine);
+
+    x = wrapMapCoord(x, TIC_MAP_WIDTH);
+    y = wrapMapCoord(y, TIC_MAP_HEIGHT);
+
+    {
+        tic_tilesheet sheet = getTileSheetFromSegment(memory, layer->segment);
+
+        for(s32 j = (t - sy) / TIC_SPRITESIZE, last = (b - 1 - sy) / TIC_SPRITESIZE; j <= last; j++)
+            for(s32 i = (l - sx) / TIC_SPRITESIZE, last = (r - 1 - sx) / TIC_SPRITESIZE; i <= last; i++)
+                updateMapLayerCell(machine, &sheet, src, (x + i) % TIC_MAP_WIDTH, (y + j) % TIC_MAP_HEIGHT);
+    }
+
+    PixelPairs pairs;
+    initPixelPairs(&pairs, mapping);
+
+    u8* screen = machine->state.target.data;
+    s32 lx = (x * TIC_SPRITESIZE + l - sx) % MapLayerWidth;
+    s32 first = MIN(r - l, MapLayerWidth - lx);
+
+    for(s32 py = t; py < b; py++)
+    {
+        const u8* row = layer->pixels + (y * TIC_SPRITESIZE + py - sy) % MapLayerHeight * (MapLayerWidth / 2);
+        s32 pos = py * TIC80_WIDTH + l;
+
+        copyPixelSpan(screen, pos, row, lx, first, &pairs);
+        copyPixelSpan(screen, pos + first, row, 0, r - l - first, &pairs);
+
+        machine->state.target.dirty[py] = true;
+
+        if(machine->state.setpix == setPixelCount)
+        {
+            countPixelSpan(machine, pos, row, lx, first, &pairs);
+            countPixelSpan(machine, pos + first, row, 0, r - l - first, &pairs);
+        }
+    }
+}
+
 static void drawMap(tic_machine* machine, const tic_map* src, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* colors, s32 count, s32 scale, RemapFunc remap, void* data)
 {
     const s32 size = TIC_SPRITESIZE * scale;
 
+    if(!remap && scale == 1 && isDmaDraw(machine) && initMapLayer(&machine->maplayer))
+    {
+        u8 mapping[TIC_PALETTE_SIZE];
+        getPalette(&machine->memory, colors, count, mapping);
+        drawMapLayer(machine, src, x, y, width, height, sx, sy, mapping);
+        return;
+    }
+
     tic_tilesheet sheet = getTileSheetFromSegment(&machine->memory, machine->memory.ram.vram.blit.segment);
 
     for(s32 j = y, jj = sy; j < y + height; j++, jj += size)
@@ -447,53 +1314,179 @@ static void drawMap(tic_machine* machine, const tic_map* src, s32 x, s32 y, s32
             if (remap)
                 remap(data, mi, mj, &retile);
 
+            // remap may change the palette mapping, so it is read for every tile
+            u8 mapping[TIC_PALETTE_SIZE];
+            getPalette(&machine->memory, colors, count, mapping);
+
             tic_tileptr tile = getTile(&sheet, retile.index, true);
-            drawTile(machine, &tile, ii, jj, colors, count, scale, retile.flip, retile.rotate);
+            drawTile(machine, &tile, ii, jj, mapping, scale, retile.flip, retile.rotate);
         }
 }
 
-static s32 drawChar(tic_machine* machine, tic_tileptr* font_char, s32 x, s32 y, s32 scale, bool fixed, u8* mapping)
+static inline s32 floorDiv(s32 value, s32 divider)
 {
-    enum {Size = TIC_SPRITESIZE};
+    return value >= 0 ? value / divider : -((divider - 1 - value) / divider);
+}
 
-    s32 j=0, start=0, end=Size;
+// remaps all the visible cells with one callback, then draws them in the same order
+static void drawMapBatch(tic_machine* machine, const tic_map* src, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* colors, s32 count, s32 scale, RemapBatchFunc remap, void* data)
+{
+    enum {MaxCells = (TIC80_WIDTH / TIC_SPRITESIZE + 1) * (TIC80_HEIGHT / TIC_SPRITESIZE + 1)};
 
-    if (!fixed) {
-        for(s32 i=0; i < Size; i++) {
-            for(j=0; j < Size; j++)
-                if(mapping[getTilePixel(font_char, i, j)] != TRANSPARENT_COLOR) break;
-            if (j < Size) break; else start++;
+    if(scale <= 0) return;
+
+    const s32 size = TIC_SPRITESIZE * scale;
+
+    s32 left = MAX(floorDiv(machine->state.clip.l - sx, size), 0);
+    s32 right = MIN(floorDiv(machine->state.clip.r - 1 - sx, size) + 1, width);
+    s32 top = MAX(floorDiv(machine->state.clip.t - sy, size), 0);
+    s32 bottom = MIN(floorDiv(machine->state.clip.b - 1 - sy, size) + 1, height);
+
+    if(left >= right || top >= bottom) return;
+
+    RemapCell cells[MaxCells];
+    s32 cellsCount = 0;
+
+    for(s32 j = top; j < bottom; j++)
+        for(s32 i = left; i < right; i++)
+        {
+            s32 mi = wrapMapCoord(x + i, TIC_MAP_WIDTH);
+            s32 mj = wrapMapCoord(y + j, TIC_MAP_HEIGHT);
+
+            cells[cellsCount++] = (RemapCell){mi, mj, {src->data[mi + mj * TIC_MAP_WIDTH], tic_no_flip, tic_no_rotate}};
         }
-        for(s32 i=Size-1; i>=start; i--) {
-            for(j=0; j < Size; j++)
-                if(mapping[getTilePixel(font_char, i, j)] != TRANSPARENT_COLOR) break;
-            if (j < Size) break; else end--;
+
+    remap(data, cells, cellsCount);
+
+    u8 mapping[TIC_PALETTE_SIZE];
+    getPalette(&machine->memory, colors, count, mapping);
+
+    tic_tilesheet sheet = getTileSheetFromSegment(&machine->memory, machine->memory.ram.vram.blit.segment);
+    const RemapCell* cell = cells;
+
+    for(s32 j = top; j < bottom; j++)
+        for(s32 i = left; i < right; i++, cell++)
+        {
+            tic_tileptr tile = getTile(&sheet, cell->result.index, true);
+            drawTile(machine, &tile, sx + i * size, sy + j * size, mapping, scale, cell->result.flip, cell->result.rotate);
+        }
+}
+
+static const u16* getGlyphColumns(tic_machine* machine, const tic_tileptr* glyph, const u8* pixels)
+{
+    enum {Size = TIC_SPRITESIZE, Count = COUNT_OF(machine->glyphs.items)};
+
+    u32 address = (u32)(glyph->ptr - machine->memory.ram.data);
+    u32 number = address / (TIC_SPRITESIZE * glyph->segment->bpp) + glyph->offset / Size;
+    u32 tag = number << 3 | glyph->segment->bpp;
+
+    tic_glyph* item = &machine->glyphs.items[number % Count];
+
+    if(item->tag != tag)
+    {
+        item->tag = tag;
+
+        for(s32 i = 0; i < Size; i++)
+        {
+            item->columns[i] = 0;
+
+            for(s32 j = 0; j < Size; j++)
+                item->columns[i] |= 1 << getCachedTilePixel(glyph, pixels, i, j);
         }
     }
+
+    return item->columns;
+}
+
+static s32 drawChar(tic_machine* machine, tic_tileptr* font_char, s32 x, s32 y, s32 scale, bool fixed, u8* mapping, u16 opaque)
+{
+    enum {Size = TIC_SPRITESIZE};
+
+    const u8* pixels = getTilePixels(machine, font_char);
+    s32 start=0, end=Size;
+
+    machine->overdraw.tiles++;
+
+    if (!fixed) {
+        const u16* columns = getGlyphColumns(machine, font_char, pixels);
+        while(start < Size && !(columns[start] & opaque)) start++;
+        while(end > start && !(columns[end - 1] & opaque)) end--;
+    }
     s32 width = end - start;
 
     if (EARLY_CLIP(x, y, Size * scale, Size * scale)) return width;
 
-    s32 colStart = start, colStep = 1, rowStart = 0 , rowStep = 1;
+    if(scale == 1 && isDmaDraw(machine))
+    {
+        // the glyph columns [start, end) are drawn at x
+        s32 sx = MAX(machine->state.clip.l - x, 0);
+        s32 ex = MIN(machine->state.clip.r - x, width);
+        s32 sy = MAX(machine->state.clip.t - y, 0);
+        s32 ey = MIN(machine->state.clip.b - y, Size);
+
+        if(sx < ex)
+            for(s32 row = sy; row < ey; row++)
+            {
+                u8 line[Size];
+
+                for(s32 i = sx; i < ex; i++)
+                {
+                    u8 color = mapping[getCachedTilePixel(font_char, pixels, start + i, row)];
+                    line[i] = color == TRANSPARENT_COLOR ? color : color & 0xf;
+                }
+
+                drawTileLineDma(&machine->memory, line, x + sx, y + row, sx, ex);
+            }
+
+        return width;
+    }
 
-    for(s32 i=0, col=colStart, xs = x; i < width; i++, col+=colStep, xs+=scale)
+    for(s32 row = 0, ys = y; row < Size; row++, ys += scale)
     {
-        for(s32 j = 0, row=rowStart, ys = y; j < Size; j++, row+=rowStep, ys+=scale)
-        {
-            u8 color = getTilePixel(font_char, col, row);
-            if(mapping[color] != TRANSPARENT_COLOR)
-                drawRect(machine, xs, ys, scale, scale, mapping[color]);
-        }
+        u8 line[Size];
+
+        for(s32 i = 0; i < width; i++)
+            line[i] = mapping[getCachedTilePixel(font_char, pixels, start + i, row)];
+
+        drawScaledLine(machine, line, width, x, ys, scale);
     }
+
     return width;
 }
 
-static s32 drawText(tic_machine* machine, tic_tilesheet* font_face, const char* text, s32 x, s32 y, s32 width, s32 height, bool fixed, u8* mapping, s32 scale, bool alt)
+// width of the glyph without touching the caches, so text can be measured while the draw list worker draws
+static s32 measureChar(const tic_tileptr* font_char, bool fixed, u16 opaque)
+{
+    enum {Size = TIC_SPRITESIZE};
+
+    s32 start = Size, end = 0;
+
+    if(fixed) return Size;
+
+    for(s32 i = 0; i < Size; i++)
+        for(s32 j = 0; j < Size; j++)
+            if(opaque & 1 << getTilePixel(font_char, i, j))
+            {
+                start = MIN(start, i);
+                end = i + 1;
+                break;
+            }
+
+    return end > start ? end - start : 0;
+}
+
+static s32 drawText(tic_machine* machine, tic_tilesheet* font_face, const char* text, s32 x, s32 y, s32 width, s32 height, bool fixed, u8* mapping, s32 scale, bool alt, bool measure)
 {
     s32 pos = x;
     s32 MAX = x;
     char sym = 0;
 
+    // the colors a glyph pixel can have are limited by the bpp, so is the mapping
+    u16 opaque = 0;
+    for(s32 i = 0, count = 1 << font_face->segment->bpp; i < count; i++)
+        if(mapping[i] != TRANSPARENT_COLOR)
+            opaque |= 1 << i;
+
     while((sym = *text++))
     {
         if(sym == '\n')
@@ -506,7 +1499,9 @@ static s32 drawText(tic_machine* machine, tic_tilesheet* font_face, const char*
         }
         else {
             tic_tileptr font_char = getTile(font_face, alt*TIC_FONT_CHARS/2 + sym, true);
-            s32 size = drawChar(machine, &font_char, pos, y, scale, fixed, mapping);
+            s32 size = measure
+                ? measureChar(&font_char, fixed, opaque)
+                : drawChar(machine, &font_char, pos, y, scale, fixed, mapping, opaque);
             pos += ((!fixed && size) ? size + 1 : width) * scale;
         }
     }
@@ -584,8 +1579,9 @@ static void setMusic(tic_machine* machine, s32 index, s32 frame, s32 row, bool l
         memory->ram.sound_state.flag.music_sustain = sustain;
         memory->ram.sound_state.flag.music_state = tic_music_play;
 
-        const tic_track* track = &memory->ram.music.tracks.data[index];
-        machine->state.music.ticks = row >= 0 ? row2tick(track, row) : 0;
+        // a track outside the music is stopped by the next tick
+        machine->state.music.ticks = row >= 0 && index < MUSIC_TRACKS 
+            ? trackTick(getMusicTrack(machine, index), &memory->ram.music.tracks.data[index], row) : 0;
     }
 }
 
@@ -636,8 +1632,78 @@ static void soundClear(tic_mem* memory)
 
 static void updateSaveid(tic_mem* memory);
 
+// fields passed as TIC_RASTER_KEEP leave the row as it is, a color adds one more palette override
+static void setRasterRow(tic_raster* raster, s32 row, s32 x, s32 border, s32 color, u32 rgb)
+{
+    if(row < 0 || row >= TIC80_HEIGHT)
+        return;
+
+    tic_raster_row* entry = &raster->rows[row];
+
+    if(!entry->set)
+    {
+        entry->set = true;
+        entry->x = 0;
+        entry->border = -1;
+    }
+
+    if(x != TIC_RASTER_KEEP)
+        entry->x = CLAMP(x, INT8_MIN, INT8_MAX);
+
+    if(border != TIC_RASTER_KEEP)
+        entry->border = border >= 0 && border < TIC_PALETTE_SIZE ? border : -1;
+
+    if(color >= 0 && color < TIC_PALETTE_SIZE)
+    {
+        entry->mask |= 1 << color;
+        entry->palette.colors[color] = (tic_rgb){rgb >> 16, rgb >> 8, rgb};
+    }
+
+    raster->active = true;
+}
+
+void tic_api_raster(tic_mem* memory, s32 row, s32 x, s32 border, s32 color, u32 rgb)
+{
+    tic_machine* machine = (tic_machine*)memory;
+    tic_raster* raster = &machine->state.raster;
+
+    if(row < 0)
+    {
+        memset(raster, 0, sizeof(tic_raster));
+        return;
+    }
+
+    setRasterRow(raster, row, x, border, color, rgb);
+}
+
+void tic_api_rasterbuf(tic_mem* memory, s32 address, s32 count)
+{
+    syncDraw((tic_machine*)memory);
+
+    enum {Size = sizeof(tic_raster_entry)};
+
+    if(address < 0 || address >= sizeof(tic_ram) || count <= 0)
+        return;
+
+    tic_machine* machine = (tic_machine*)memory;
+    const u8* ptr = memory->ram.data + address;
+
+    count = MIN(count, ((s32)sizeof(tic_ram) - address) / Size);
+
+    for(s32 i = 0; i < count; i++, ptr += Size)
+    {
+        tic_raster_entry entry;
+        memcpy(&entry, ptr, Size);
+
+        setRasterRow(&machine->state.raster, entry.row, entry.x, entry.border, 
+            entry.color, entry.rgb.r << 16 | entry.rgb.g << 8 | entry.rgb.b);
+    }
+}
+
 void tic_api_clip(tic_mem* memory, s32 x, s32 y, s32 width, s32 height)
 {
+    RECORD_DRAW(memory, .type = tic_draw_clip, .rect = {x, y, width, height});
+
     tic_machine* machine = (tic_machine*)memory;
 
     machine->state.clip.l = x;
@@ -653,6 +1719,8 @@ void tic_api_clip(tic_mem* memory, s32 x, s32 y, s32 width, s32 height)
 
 void tic_api_reset(tic_mem* memory)
 {
+    syncDraw((tic_machine*)memory);
+
     resetPalette(memory);
     resetBlitSegment(memory);
 
@@ -666,10 +1734,10 @@ void tic_api_reset(tic_mem* memory)
     machine->state.initialized = false;
     machine->state.scanline = NULL;
     machine->state.ovr.callback = NULL;
+    memset(&machine->state.raster, 0, sizeof machine->state.raster);
 
-    machine->state.setpix = setPixelDma;
-    machine->state.getpix = getPixelDma;
-    machine->state.drawhline = drawHLineDma;
+    memset(machine->targets, 0, sizeof machine->targets);
+    setDrawTarget(machine, -1, false);
 
     updateSaveid(memory);
 }
@@ -678,15 +1746,18 @@ void tic_core_pause(tic_mem* memory)
 {
     tic_machine* machine = (tic_machine*)memory;
 
+    syncDraw(machine);
+
     memcpy(&machine->pause.state, &machine->state, sizeof(tic_machine_state_data));
     memcpy(&machine->pause.ram, &memory->ram, sizeof(tic_ram));
     machine->pause.input = memory->input.data;
     memset(&machine->state.ovr, 0, sizeof machine->state.ovr);
+    memset(&machine->state.raster, 0, sizeof machine->state.raster);
 
     if (machine->data)
     {
         machine->pause.time.start = machine->data->start;
-        machine->pause.time.paused = machine->data->counter();
+        machine->pause.time.paused = machine->data->counter(machine->data->data);
     }
 }
 
@@ -694,12 +1765,15 @@ void tic_core_resume(tic_mem* memory)
 {
     tic_machine* machine = (tic_machine*)memory;
 
+    syncDraw(machine);
+
     if (machine->data)
     {
         memcpy(&machine->state, &machine->pause.state, sizeof(tic_machine_state_data));
         memcpy(&memory->ram, &machine->pause.ram, sizeof(tic_ram));
+        invalidateRam(machine, 0, sizeof(tic_ram));
         memory->input.data = machine->pause.input;
-        machine->data->start = machine->pause.time.start + machine->data->counter() - machine->pause.time.paused;
+        machine->data->start = machine->pause.time.start + machine->data->counter(machine->data->data) - machine->pause.time.paused;
     }
 }
 
@@ -707,6 +1781,9 @@ void tic_core_close(tic_mem* memory)
 {
     tic_machine* machine = (tic_machine*)memory;
 
+    tic_drawlist_delete(machine->drawlist);
+    machine->drawlist = NULL;
+
     machine->state.initialized = false;
 
 #if defined(TIC_BUILD_WITH_SQUIRREL)
@@ -735,10 +1812,15 @@ void tic_core_close(tic_mem* memory)
     getWrenScriptConfig()->close(memory);
 #endif
 
-    blip_delete(machine->blip.left);
-    blip_delete(machine->blip.right);
+    tic_audio_ring_delete(machine->audio.ring);
+
+    blip_delete(machine->synth.blip.left);
+    blip_delete(machine->synth.blip.right);
 
     free(memory->samples.buffer);
+    free(memory->profile.trace.events);
+    free(machine->maplayer.cells);
+    free(machine->maplayer.pixels);
     free(machine);
 }
 
@@ -746,8 +1828,88 @@ void tic_core_close(tic_mem* memory)
 // API ////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+void tic_api_target(tic_mem* memory, s32 index)
+{
+    RECORD_DRAW(memory, .type = tic_draw_target, .target = {index});
+
+    tic_machine* machine = (tic_machine*)memory;
+
+    if(index >= -1 && index < TIC_TARGETS)
+        setDrawTarget(machine, index, machine->state.target.ovr);
+}
+
+void tic_api_blit(tic_mem* memory, s32 src, s32 x, s32 y, u8* colors, s32 count, s32 dst, const u8* remap)
+{
+    if(recordDraw((tic_machine*)memory))
+    {
+        tic_draw_command cmd = {.type = tic_draw_blit, .blit = {src, x, y, dst, remap != NULL, {0}, drawColors(colors, count)}};
+        if(remap) memcpy(cmd.blit.map, remap, sizeof cmd.blit.map);
+        tic_drawlist_push(((tic_machine*)memory)->drawlist, &cmd);
+        return;
+    }
+
+    enum {Width = TIC80_WIDTH, Height = TIC80_HEIGHT};
+
+    tic_machine* machine = (tic_machine*)memory;
+
+    if(src < 0 || src >= TIC_TARGETS || dst < -1 || dst >= TIC_TARGETS)
+        return;
+
+    s32 l = MAX(x, machine->state.clip.l);
+    s32 t = MAX(y, machine->state.clip.t);
+    s32 r = MIN(x + Width, machine->state.clip.r);
+    s32 b = MIN(y + Height, machine->state.clip.b);
+
+    if(l >= r || t >= b) return;
+
+    // target colors are already mapped, only the explicit remap and colorkey apply
+    u8 mapping[TIC_PALETTE_SIZE];
+    for(s32 i = 0; i < TIC_PALETTE_SIZE; i++) mapping[i] = remap ? remap[i] & 0xf : i;
+    for(s32 i = 0; i < count; i++) if(colors[i] < TIC_PALETTE_SIZE) mapping[colors[i]] = TRANSPARENT_COLOR;
+
+    tic_screen copy;
+    const u8* pixels = machine->targets[src].data;
+
+    if(src == dst)
+    {
+        memcpy(copy.data, pixels, sizeof copy);
+        pixels = copy.data;
+    }
+
+    s32 prev = machine->state.target.index;
+    setDrawTarget(machine, dst, machine->state.target.ovr);
+
+    if(isDmaDraw(machine))
+    {
+        PixelPairs pairs;
+        initPixelPairs(&pairs, mapping);
+
+        for(s32 py = t; py < b; py++)
+        {
+            copyPixelSpan(machine->state.target.data, py * Width + l, pixels + (py - y) * (Width / 2), l - x, r - l, &pairs);
+            machine->state.target.dirty[py] = true;
+
+            if(machine->state.setpix == setPixelCount)
+                countPixelSpan(machine, py * Width + l, pixels + (py - y) * (Width / 2), l - x, r - l, &pairs);
+        }
+    }
+    else
+    {
+        for(s32 py = t; py < b; py++)
+            for(s32 px = l; px < r; px++)
+            {
+                u8 color = mapping[tic_tool_peek4(pixels, (py - y) * Width + px - x)];
+                if(color != TRANSPARENT_COLOR) machine->state.setpix(memory, px, py, color);
+            }
+    }
+
+    setDrawTarget(machine, prev, machine->state.target.ovr);
+}
+
 void tic_api_rect(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, u8 color)
 {
+    RECORD_DRAW(memory, .type = tic_draw_rect, .rect = {x, y, width, height, color});
+
     tic_machine* machine = (tic_machine*)memory;
 
     drawRect(machine, x, y, width, height, mapColor(memory, color));
@@ -755,14 +1917,25 @@ void tic_api_rect(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, u8 color
 
 void tic_api_cls(tic_mem* memory, u8 color)
 {
+    RECORD_DRAW(memory, .type = tic_draw_cls, .cls = {color});
+
     static const tic_clip_data EmptyClip = {0, 0, TIC80_WIDTH, TIC80_HEIGHT};
 
     tic_machine* machine = (tic_machine*)memory;
 
-    if(memcmp(&machine->state.clip, &EmptyClip, sizeof(tic_clip_data)) == 0)
+    if(memcmp(&machine->state.clip, &EmptyClip, sizeof(tic_clip_data)) == 0 && machine->state.target.index >= 0)
+    {
+        color &= 0b00001111;
+        memset(machine->targets[machine->state.target.index].data, color | (color << TIC_PALETTE_BPP), sizeof(tic_screen));
+    }
+    else if(memcmp(&machine->state.clip, &EmptyClip, sizeof(tic_clip_data)) == 0)
     {
         color &= 0b00001111;
         memset(memory->ram.vram.screen.data, color | (color << TIC_PALETTE_BPP), sizeof(memory->ram.vram.screen.data));     
+        invalidateRam(machine, offsetof(tic_ram, vram.screen), sizeof(tic_screen));
+
+        if(machine->state.setpix == setPixelCount)
+            countPixels(machine, 0, TIC80_WIDTH * TIC80_HEIGHT);
     }
     else
     {
@@ -772,7 +1945,8 @@ void tic_api_cls(tic_mem* memory, u8 color)
 
 s32 tic_api_font(tic_mem* memory, const char* text, s32 x, s32 y, u8 chromakey, s32 w, s32 h, bool fixed, s32 scale, bool alt)
 {
-    u8* mapping = getPalette(memory, &chromakey, 1);
+    u8 mapping[TIC_PALETTE_SIZE];
+    getPalette(memory, &chromakey, 1, mapping);
 
     // Compatibility : flip top and bottom of the spritesheet
     // to preserve tic_api_font's default target
@@ -780,7 +1954,16 @@ s32 tic_api_font(tic_mem* memory, const char* text, s32 x, s32 y, u8 chromakey,
     u8 flipmask = 1; while (segment >>= 1) flipmask<<=1;
 
     tic_tilesheet font_face = getTileSheetFromSegment(memory, memory->ram.vram.blit.segment ^ flipmask);
-    return drawText((tic_machine*)memory, &font_face, text, x, y, w, h, fixed, mapping, scale, alt);
+    bool record = recordText((tic_machine*)memory, text);
+
+    if(record)
+    {
+        tic_draw_command cmd = {.type = tic_draw_font, .text = {"", x, y, w, h, scale, chromakey, fixed, alt}};
+        strcpy(cmd.text.text, text);
+        tic_drawlist_push(((tic_machine*)memory)->drawlist, &cmd);
+    }
+
+    return drawText((tic_machine*)memory, &font_face, text, x, y, w, h, fixed, mapping, scale, alt, record);
 }
 
 s32 tic_api_print(tic_mem* memory, const char* text, s32 x, s32 y, u8 color, bool fixed, s32 scale, bool alt)
@@ -790,41 +1973,122 @@ s32 tic_api_print(tic_mem* memory, const char* text, s32 x, s32 y, u8 color, boo
     // Compatibility : print uses reduced width for non-fixed space
     u8 width = alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH;
     if (!fixed) width -= 2;
-    return drawText((tic_machine*)memory, &font_face, text, x, y, width, TIC_FONT_HEIGHT, fixed, mapping, scale, alt);
+
+    bool record = recordText((tic_machine*)memory, text);
+
+    if(record)
+    {
+        tic_draw_command cmd = {.type = tic_draw_print, .text = {"", x, y, 0, 0, scale, color, fixed, alt}};
+        strcpy(cmd.text.text, text);
+        tic_drawlist_push(((tic_machine*)memory)->drawlist, &cmd);
+    }
+
+    return drawText((tic_machine*)memory, &font_face, text, x, y, width, TIC_FONT_HEIGHT, fixed, mapping, scale, alt, record);
 }
 
 void tic_api_spr(tic_mem* memory, s32 index, s32 x, s32 y, s32 w, s32 h, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate)
 {
-    drawSprite((tic_machine*)memory, index, x, y, w, h, colors, count, scale, flip, rotate);
+    RECORD_DRAW(memory, .type = tic_draw_spr, .spr = {index, x, y, w, h, scale, flip, rotate, drawColors(colors, count)});
+
+    u8 mapping[TIC_PALETTE_SIZE];
+    getPalette(memory, colors, count, mapping);
+
+    tic_tilesheet sheet = getTileSheetFromSegment(memory, memory->ram.vram.blit.segment);
+    drawSprite((tic_machine*)memory, &sheet, index, x, y, w, h, mapping, scale, flip, rotate);
+}
+
+void tic_api_oam(tic_mem* memory, s32 address, s32 count)
+{
+    syncDraw((tic_machine*)memory);
+
+    enum {Size = sizeof(tic_oam_entry)};
+
+    if(address < 0 || address >= sizeof(tic_ram) || count <= 0)
+        return;
+
+    tic_machine* machine = (tic_machine*)memory;
+    tic_tilesheet sheet = getTileSheetFromSegment(memory, memory->ram.vram.blit.segment);
+    const u8* ptr = memory->ram.data + address;
+
+    count = MIN(count, ((s32)sizeof(tic_ram) - address) / Size);
+
+    // the mapping is rebuilt only when the colorkey differs from the previous entry
+    u8 mapping[TIC_PALETTE_SIZE];
+    s32 key = -2;
+
+    for(s32 i = 0; i < count; i++, ptr += Size)
+    {
+        tic_oam_entry entry;
+        memcpy(&entry, ptr, Size);
+
+        s32 w = entry.w + 1, h = entry.h + 1;
+        s32 step = TIC_SPRITESIZE * (entry.scale + 1);
+
+        if(entry.rotate & 1)
+        {
+            s32 tmp = w; w = h; h = tmp;
+        }
+
+        if(EARLY_CLIP(entry.x, entry.y, w * step, h * step))
+            continue;
+
+        s32 entryKey = entry.keyed ? entry.colorkey : -1;
+
+        if(entryKey != key)
+        {
+            u8 color = entry.colorkey;
+            getPalette(memory, &color, entry.keyed, mapping);
+            key = entryKey;
+        }
+
+        drawSprite(machine, &sheet, entry.index, entry.x, entry.y, entry.w + 1, entry.h + 1, 
+            mapping, entry.scale + 1, entry.flip, entry.rotate);
+    }
 }
 
 static inline u8* getFlag(tic_mem* memory, s32 index, u8 flag)
 {
-    static u8 stub = 0;
     if(index >= TIC_FLAGS || flag >= BITS_IN_BYTE)
-        return &stub;
+        return NULL;
 
     return memory->ram.flags.data + index;
 }
 
 bool tic_api_fget(tic_mem* memory, s32 index, u8 flag)
 {
-    return *getFlag(memory, index, flag) & (1 << flag);
+    u8* flags = getFlag(memory, index, flag);
+
+    return flags && (*flags & (1 << flag));
 }
 
 void tic_api_fset(tic_mem* memory, s32 index, u8 flag, bool value)
 {
+    u8* flags = getFlag(memory, index, flag);
+
+    if(!flags)
+        return;
+
     if(value)
-        *getFlag(memory, index, flag) |= (1 << flag);
+        *flags |= (1 << flag);
     else 
-        *getFlag(memory, index, flag) &= ~(1 << flag);
+        *flags &= ~(1 << flag);
 }
 
 u8 tic_api_pix(tic_mem* memory, s32 x, s32 y, u8 color, bool get)
 {
     tic_machine* machine = (tic_machine*)memory;
 
-    if(get) return getPixel(machine, x, y);
+    if(get)
+    {
+        syncDraw(machine);
+        return getPixel(machine, x, y);
+    }
+
+    if(recordDraw(machine))
+    {
+        tic_drawlist_push(machine->drawlist, &(tic_draw_command){.type = tic_draw_pix, .pix = {x, y, color}});
+        return 0;
+    }
 
     setPixel(machine, x, y, mapColor(memory, color));
     return 0;
@@ -832,66 +2096,44 @@ u8 tic_api_pix(tic_mem* memory, s32 x, s32 y, u8 color, bool get)
 
 void tic_api_rectb(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, u8 color)
 {
+    RECORD_DRAW(memory, .type = tic_draw_rectb, .rect = {x, y, width, height, color});
+
     tic_machine* machine = (tic_machine*)memory;
 
     drawRectBorder(machine, x, y, width, height, mapColor(memory, color));
 }
 
-static struct
-{
-    s16 Left[TIC80_HEIGHT];
-    s16 Right[TIC80_HEIGHT];    
-    s32 ULeft[TIC80_HEIGHT];
-    s32 VLeft[TIC80_HEIGHT];
-} SidesBuffer;
-
-static void initSidesBuffer()
+static void initSidesBuffer(tic_machine* machine)
 {
-    for(s32 i = 0; i < COUNT_OF(SidesBuffer.Left); i++)
-        SidesBuffer.Left[i] = TIC80_WIDTH, SidesBuffer.Right[i] = -1;   
+    for(s32 i = 0; i < COUNT_OF(machine->sides.Left); i++)
+        machine->sides.Left[i] = TIC80_WIDTH, machine->sides.Right[i] = -1;   
 }
 
-static void setSidePixel(s32 x, s32 y)
+static void setSidePixel(tic_machine* machine, s32 x, s32 y)
 {
     if(y >= 0 && y < TIC80_HEIGHT)
     {
-        if(x < SidesBuffer.Left[y]) SidesBuffer.Left[y] = x;
-        if(x > SidesBuffer.Right[y]) SidesBuffer.Right[y] = x;
-    }
-}
-
-static void setSideTexPixel(s32 x, s32 y, float u, float v)
-{
-    s32 yy = y;
-    if (yy >= 0 && yy < TIC80_HEIGHT)
-    {
-        if (x < SidesBuffer.Left[yy])
-        {
-            SidesBuffer.Left[yy] = x;
-            SidesBuffer.ULeft[yy] = u*65536.0f;
-            SidesBuffer.VLeft[yy] = v*65536.0f;
-        }
-        if (x > SidesBuffer.Right[yy])
-        {
-            SidesBuffer.Right[yy] = x;
-        }
+        if(x < machine->sides.Left[y]) machine->sides.Left[y] = x;
+        if(x > machine->sides.Right[y]) machine->sides.Right[y] = x;
     }
 }
 
 void tic_api_circ(tic_mem* memory, s32 xm, s32 ym, s32 radius, u8 color)
 {
+    RECORD_DRAW(memory, .type = tic_draw_circ, .circ = {xm, ym, radius, color});
+
     tic_machine* machine = (tic_machine*)memory;
 
-    initSidesBuffer();
+    initSidesBuffer(machine);
 
     s32 r = radius;
     s32 x = -r, y = 0, err = 2-2*r;
     do 
     {
-        setSidePixel(xm-x, ym+y);
-        setSidePixel(xm-y, ym-x);
-        setSidePixel(xm+x, ym-y);
-        setSidePixel(xm+y, ym+x);
+        setSidePixel(machine, xm-x, ym+y);
+        setSidePixel(machine, xm-y, ym-x);
+        setSidePixel(machine, xm+x, ym-y);
+        setSidePixel(machine, xm+y, ym+x);
 
         r = err;
         if (r <= y) err += ++y*2+1;
@@ -902,14 +2144,16 @@ void tic_api_circ(tic_mem* memory, s32 xm, s32 ym, s32 radius, u8 color)
     s32 yb = MIN(machine->state.clip.b, ym+radius+1);
     u8 final_color = mapColor(&machine->memory, color);
     for(s32 y = yt; y < yb; y++) {
-        s32 xl = MAX(SidesBuffer.Left[y], machine->state.clip.l);
-        s32 xr = MIN(SidesBuffer.Right[y]+1, machine->state.clip.r);
+        s32 xl = MAX(machine->sides.Left[y], machine->state.clip.l);
+        s32 xr = MIN(machine->sides.Right[y]+1, machine->state.clip.r);
         machine->state.drawhline(&machine->memory, xl, xr, y, final_color);
     }
 }
 
 void tic_api_circb(tic_mem* memory, s32 xm, s32 ym, s32 radius, u8 color)
 {
+    RECORD_DRAW(memory, .type = tic_draw_circb, .circ = {xm, ym, radius, color});
+
     tic_machine* machine = (tic_machine*)memory;
     u8 final_color = mapColor(memory, color);
     s32 r = radius;
@@ -950,14 +2194,16 @@ static void ticLine(tic_mem* memory, s32 x0, s32 y0, s32 x1, s32 y1, u8 color, l
 
 static void triPixelFunc(tic_mem* memory, s32 x, s32 y, u8 color)
 {
-    setSidePixel(x, y);
+    setSidePixel((tic_machine*)memory, x, y);
 }
 
 void tic_api_tri(tic_mem* memory, s32 x1, s32 y1, s32 x2, s32 y2, s32 x3, s32 y3, u8 color)
 {
+    RECORD_DRAW(memory, .type = tic_draw_tri, .tri = {x1, y1, x2, y2, x3, y3, color});
+
     tic_machine* machine = (tic_machine*)memory;
 
-    initSidesBuffer();
+    initSidesBuffer(machine);
 
     ticLine(memory, x1, y1, x2, y2, color, triPixelFunc);
     ticLine(memory, x2, y2, x3, y3, color, triPixelFunc);
@@ -968,184 +2214,333 @@ void tic_api_tri(tic_mem* memory, s32 x1, s32 y1, s32 x2, s32 y2, s32 x3, s32 y3
     s32 yb = MIN(machine->state.clip.b, MAX(y1, MAX(y2, y3)) + 1);
 
     for(s32 y = yt; y < yb; y++) {
-        s32 xl = MAX(SidesBuffer.Left[y], machine->state.clip.l);
-        s32 xr = MIN(SidesBuffer.Right[y]+1, machine->state.clip.r);
+        s32 xl = MAX(machine->sides.Left[y], machine->state.clip.l);
+        s32 xr = MIN(machine->sides.Right[y]+1, machine->state.clip.r);
         machine->state.drawhline(&machine->memory, xl, xr, y, final_color);
     }
 }
 
 
+static u8 getSheetPixel(tic_machine* machine, const tic_tilesheet* sheet, s32 x, s32 y)
+{
+    const tic_blit_segment* segment = sheet->segment;
+    const tic_tiles* tiles = &machine->memory.ram.tiles;
+
+    if(sheet->ptr != (const u8*)tiles)
+        return getTileSheetPixel(sheet, x, y);
+
+    s32 index = ((y >> 3) << 4) + (x / segment->tile_width);
+    s32 addr = (x & (segment->tile_width - 1)) + ((y & 7) * segment->tile_width);
+
+    return getTileCacheData(&machine->tilecache, segment, tiles, index)[addr];
+}
+
+enum
+{
+    TriSubPixel = 16,                   // vertices are snapped to 1/16 of a pixel
+    TriMaxCoord = 1 << 22,              // keeps the edge functions in s64
+    TexSheetWidth = TIC_SPRITESHEET_SIZE,
+    TexSheetHeight = TIC_SPRITESHEET_SIZE * TIC_SPRITE_BANKS,
+    TexSheetRows = TexSheetHeight / TIC_SPRITESIZE,
+};
+
 typedef struct
 {
-    float x, y, u, v;
+    float x, y, u, v, w;
 } TexVert;
 
+typedef struct
+{
+    s64 value;  // edge function at the center of pixel (0, y) less the fill rule bias, inside if value - step * x >= 0
+    s64 step;   // change per column
+    s64 row;    // change per row
+} TriEdge;
+
+static inline s64 floorDiv64(s64 value, s64 divider)
+{
+    return value >= 0 ? value / divider : -((divider - 1 - value) / divider);
+}
 
-static void ticTexLine(tic_mem* memory, TexVert *v0, TexVert *v1)
+static inline s64 floorToInt(double value)
 {
-    TexVert *top = v0;
-    TexVert *bot = v1;
+    s64 result = (s64)value;
+    return result - (value < result);
+}
 
-    if (bot->y < top->y)
-    {
-        top = v1;
-        bot = v0;
-    }
+static inline float clampTriCoord(float value)
+{
+    return value < -TriMaxCoord ? -TriMaxCoord : value > TriMaxCoord ? TriMaxCoord : value;
+}
+
+// edge from a to b, the inside of the triangle is on its left in screen coordinates,
+// the pixel centers right on top and left edges belong to the triangle
+static void initTriEdge(TriEdge* edge, s64 ax, s64 ay, s64 bx, s64 by, s32 y)
+{
+    s64 dx = bx - ax, dy = by - ay;
+    bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+
+    edge->step = dy * TriSubPixel;
+    edge->row = dx * TriSubPixel;
+    edge->value = dx * ((s64)y * TriSubPixel + TriSubPixel / 2 - ay) - dy * (TriSubPixel / 2 - ax) - (topLeft ? 0 : 1);
+}
+
+// narrows [*left, *right] to the columns inside the edge on the current row
+static inline void clipTriSpan(const TriEdge* edge, s32* left, s32* right)
+{
+    if(edge->step > 0)
+        *right = (s32)MIN(*right, floorDiv64(edge->value, edge->step));
+    else if(edge->step < 0)
+        *left = (s32)MAX(*left, -floorDiv64(edge->value, -edge->step));
+    else if(edge->value < 0)
+        *right = *left - 1;
+}
 
-    float dy = bot->y - top->y;
-    float step_x = (bot->x - top->x);
-    float step_u = (bot->u - top->u);
-    float step_v = (bot->v - top->v);
+// decodes the rows of tiles covering the sheet lines [top, bottom], the lines wrap around the sheet
+static void updateSheetTexture(tic_machine* machine, const tic_tilesheet* sheet, s64 top, s64 bottom)
+{
+    tic_sheet_texture* texture = &machine->texture;
 
-    if ((s32)dy != 0)
+    if(texture->segment != machine->memory.ram.vram.blit.segment)
     {
-        step_x /= dy;
-        step_u /= dy;
-        step_v /= dy;
+        memset(texture->valid, 0, sizeof texture->valid);
+        texture->segment = machine->memory.ram.vram.blit.segment;
     }
 
-    float x = top->x;
-    float y = top->y;
-    float u = top->u;
-    float v = top->v;
+    s64 first = floorDiv64(top, TIC_SPRITESIZE);
+    s64 last = floorDiv64(bottom, TIC_SPRITESIZE);
+
+    if(last - first >= TexSheetRows)
+        first = 0, last = TexSheetRows - 1;
 
-    if(y < .0f)
+    for(s64 i = first; i <= last; i++)
     {
-        y = .0f - y;
+        s32 row = (s32)(i - floorDiv64(i, TexSheetRows) * TexSheetRows);
 
-        x += step_x * y;
-        u += step_u * y;
-        v += step_v * y;
+        if(texture->valid[row]) continue;
 
-        y = .0f;
+        texture->valid[row] = true;
+
+        for(s32 y = row * TIC_SPRITESIZE; y < (row + 1) * TIC_SPRITESIZE; y++)
+            for(s32 x = 0; x < TexSheetWidth; x++)
+                texture->pixels[y][x] = getSheetPixel(machine, sheet, x, y);
     }
+}
 
-    s32 botY = bot->y;
-    if(botY > TIC80_HEIGHT)
-        botY = TIC80_HEIGHT;
+static u8 getMapTexel(tic_machine* machine, const tic_tilesheet* sheet, s32 u, s32 v)
+{
+    u = wrapMapCoord(u, MapLayerWidth);
+    v = wrapMapCoord(v, MapLayerHeight);
+
+    const tic_map* map = &machine->memory.ram.map;
+    tic_map_layer* layer = &machine->maplayer;
+    s32 index = (v >> 3) * TIC_MAP_WIDTH + (u >> 3);
 
-    for (; y <botY; ++y)
+    if(!layer->cells)
     {
-        setSideTexPixel(x, y, u, v);
-        x += step_x;
-        u += step_u;
-        v += step_v;
+        tic_tileptr tile = getTile(sheet, map->data[index], true);
+        return getCachedTilePixel(&tile, getTilePixels(machine, &tile), u & 7, v & 7);
     }
+
+    if(layer->cells[index] != getMapLayerCell(layer, map->data[index]))
+        updateMapLayerCell(machine, sheet, map, u >> 3, v >> 3);
+
+    return tic_tool_peek4(layer->pixels, v * MapLayerWidth + u);
 }
 
-static void drawTexturedTriangle(tic_machine* machine, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, bool use_map, u8* colors, s32 count)
+static inline u8 getTriTexel(tic_machine* machine, const tic_tilesheet* sheet, bool use_map, s32 u, s32 v)
+{
+    return use_map
+        ? getMapTexel(machine, sheet, u, v)
+        : machine->texture.pixels[v & (TexSheetHeight - 1)][u & (TexSheetWidth - 1)];
+}
+
+// edge function rasterizer: the vertices are snapped to sub-pixels, every row is clipped analytically
+// against the three edges and the clip rect, u and v are divided by w per pixel when depth is set
+static void drawTexturedTriangle(tic_machine* machine, const TexVert* vertices, bool use_map, bool depth, const u8* mapping)
 {
     tic_mem* memory = &machine->memory;
-    u8* mapping = getPalette(memory, colors, count);
-    TexVert V0, V1, V2;
+    const tic_machine_state_data* state = &machine->state;
+
+    TexVert V[3];
+    s64 X[3], Y[3];
+
+    for(s32 i = 0; i < 3; i++)
+    {
+        V[i] = vertices[i];
+
+        if(V[i].x != V[i].x || V[i].y != V[i].y) return;
+
+        X[i] = floorToInt(clampTriCoord(V[i].x) * TriSubPixel + .5f);
+        Y[i] = floorToInt(clampTriCoord(V[i].y) * TriSubPixel + .5f);
+    }
+
+    s64 area = (X[1] - X[0]) * (Y[2] - Y[0]) - (Y[1] - Y[0]) * (X[2] - X[0]);
+
+    if(area == 0) return;
+
+    if(area < 0)
+    {
+        SWAP(V[1], V[2], TexVert);
+        SWAP(X[1], X[2], s64);
+        SWAP(Y[1], Y[2], s64);
+        area = -area;
+    }
+
+    // early rejection of the triangles outside the clip rect
+    s32 top = (s32)MAX(floorDiv64(MIN(Y[0], MIN(Y[1], Y[2])), TriSubPixel), state->clip.t);
+    s32 bottom = (s32)MIN(floorDiv64(MAX(Y[0], MAX(Y[1], Y[2])), TriSubPixel) + 1, state->clip.b);
+    s32 left = (s32)MAX(floorDiv64(MIN(X[0], MIN(X[1], X[2])), TriSubPixel), state->clip.l);
+    s32 right = (s32)MIN(floorDiv64(MAX(X[0], MAX(X[1], X[2])), TriSubPixel) + 1, state->clip.r);
+
+    if(top >= bottom || left >= right) return;
 
-    const u8* map = memory->ram.map.data;
     tic_tilesheet sheet = getTileSheetFromSegment(memory, memory->ram.vram.blit.segment);
 
-    V0.x = x1;  V0.y = y1;  V0.u = u1;  V0.v = v1;
-    V1.x = x2;  V1.y = y2;  V1.u = u2;  V1.v = v2;
-    V2.x = x3;  V2.y = y3;  V2.u = u3;  V2.v = v3;
+    if(use_map)
+    {
+        if(initMapLayer(&machine->maplayer))
+            checkMapLayerSegment(machine);
+    }
+    else
+    {
+        float vmin = MIN(V[0].v, MIN(V[1].v, V[2].v));
+        float vmax = MAX(V[0].v, MAX(V[1].v, V[2].v));
+
+        if(vmax - vmin < TexSheetHeight)
+            updateSheetTexture(machine, &sheet, floorToInt(vmin) - 1, floorToInt(vmax) + 1);
+        else
+            updateSheetTexture(machine, &sheet, 0, TexSheetHeight - 1);
+    }
+
+    // attributes are planes over the snapped vertices, u and v are premultiplied by w for the perspective
+    double px[3], py[3], attr[3][3];
 
-    //  calculate the slope of the surface 
-    //  use floats here 
-    double denom = (V0.x - V2.x) * (V1.y - V2.y) - (V1.x - V2.x) * (V0.y - V2.y);
-    if (denom == 0.0)
+    for(s32 i = 0; i < 3; i++)
     {
-        return;
+        double w = depth ? V[i].w : 1.0;
+
+        px[i] = (double)X[i] / TriSubPixel;
+        py[i] = (double)Y[i] / TriSubPixel;
+        attr[0][i] = V[i].u * w;
+        attr[1][i] = V[i].v * w;
+        attr[2][i] = w;
+    }
+
+    double id = (double)TriSubPixel * TriSubPixel / area;
+    double dx[3], dy[3];
+
+    for(s32 i = 0; i < 3; i++)
+    {
+        dx[i] = ((attr[i][1] - attr[i][0]) * (py[2] - py[0]) - (attr[i][2] - attr[i][0]) * (py[1] - py[0])) * id;
+        dy[i] = ((attr[i][2] - attr[i][0]) * (px[1] - px[0]) - (attr[i][1] - attr[i][0]) * (px[2] - px[0])) * id;
     }
-    double id = 1.0 / denom;
-    float dudx, dvdx;
-    //  this is the UV slope across the surface
-    dudx = ((V0.u - V2.u) * (V1.y - V2.y) - (V1.u - V2.u) * (V0.y - V2.y)) * id;
-    dvdx = ((V0.v - V2.v) * (V1.y - V2.y) - (V1.v - V2.v) * (V0.y - V2.y)) * id;
-    //  convert to fixed
-    s32 dudxs = dudx * 65536.0f;
-    s32 dvdxs = dvdx * 65536.0f;
-    //  fill the buffer 
-    initSidesBuffer();
-    //  parse each line and decide where in the buffer to store them ( left or right ) 
-    ticTexLine(memory, &V0, &V1);
-    ticTexLine(memory, &V1, &V2);
-    ticTexLine(memory, &V2, &V0);
-
-    for (s32 y = 0; y < TIC80_HEIGHT; y++)
-    {
-        //  if it's backwards skip it
-        s32 width = SidesBuffer.Right[y] - SidesBuffer.Left[y];
-        //  if it's off top or bottom , skip this line
-        if ((y < machine->state.clip.t) || (y > machine->state.clip.b))
-            width = 0;
-        if (width > 0)
+
+    TriEdge edges[3];
+    initTriEdge(&edges[0], X[0], Y[0], X[1], Y[1], top);
+    initTriEdge(&edges[1], X[1], Y[1], X[2], Y[2], top);
+    initTriEdge(&edges[2], X[2], Y[2], X[0], Y[0], top);
+
+    for(s32 y = top; y < bottom; y++)
+    {
+        s32 xl = left, xr = right - 1;
+
+        for(s32 i = 0; i < 3; i++)
         {
-            s32 u = SidesBuffer.ULeft[y];
-            s32 v = SidesBuffer.VLeft[y];
-            s32 left = SidesBuffer.Left[y];
-            s32 right = SidesBuffer.Right[y];
-            //  check right edge, and CLAMP it
-            if (right > machine->state.clip.r)
-                right = machine->state.clip.r;
-            //  check left edge and offset UV's if we are off the left 
-            if (left < machine->state.clip.l)
-            {
-                s32 dist = machine->state.clip.l - SidesBuffer.Left[y];
-                u += dudxs * dist;
-                v += dvdxs * dist;
-                left = machine->state.clip.l;
-            }
-            //  are we drawing from the map . ok then at least check before the inner loop
-            if (use_map == true)
-            {
-                for (s32 x = left; x < right; ++x)
-                {
-                    enum { MapWidth = TIC_MAP_WIDTH * TIC_SPRITESIZE, MapHeight = TIC_MAP_HEIGHT * TIC_SPRITESIZE };
-                    s32 iu = (u >> 16) % MapWidth;
-                    s32 iv = (v >> 16) % MapHeight;
+            clipTriSpan(&edges[i], &xl, &xr);
+            edges[i].value += edges[i].row;
+        }
 
-                    while (iu < 0) iu += MapWidth;
-                    while (iv < 0) iv += MapHeight;
+        if(xl > xr) continue;
 
-                    u8 tileindex = map[(iv >> 3) * TIC_MAP_WIDTH + (iu >> 3)];
-                    tic_tileptr tile = getTile(&sheet, tileindex, true);
+        double cx = xl + .5 - px[0], cy = y + .5 - py[0];
+        double a[3];
 
-                    u8 color = mapping[getTilePixel(&tile, iu & 7, iv & 7)];
-                    if (color != TRANSPARENT_COLOR)
-                        setPixel(machine, x, y, color);
-                    u += dudxs;
-                    v += dvdxs;
-                }
-            }
-            else
+        for(s32 i = 0; i < 3; i++)
+            a[i] = attr[i][0] + dx[i] * cx + dy[i] * cy;
+
+        u8 line[TIC80_WIDTH];
+        s32 count = xr - xl + 1;
+
+        if(depth)
+        {
+            for(s32 i = 0; i < count; i++)
             {
-                //  direct from tile ram 
-                for (s32 x = left; x < right; ++x)
-                {
-                    enum{SheetWidth = TIC_SPRITESHEET_SIZE, SheetHeight = TIC_SPRITESHEET_SIZE * TIC_SPRITE_BANKS};
-                    s32 iu = (u>>16) & (SheetWidth - 1);
-                    s32 iv = (v>>16) & (SheetHeight - 1);
-
-                    u8 color = mapping[getTileSheetPixel(&sheet, iu, iv)];
-                    if (color != TRANSPARENT_COLOR)
-                        setPixel(machine, x, y, color);
-                    u += dudxs;
-                    v += dvdxs;
-                }
+                double z = 1.0 / a[2];
+                line[i] = mapping[getTriTexel(machine, &sheet, use_map, (s32)floorToInt(a[0] * z), (s32)floorToInt(a[1] * z))];
+                a[0] += dx[0], a[1] += dx[1], a[2] += dx[2];
             }
         }
+        else
+        {
+            // 16.16 fixed point steps
+            s64 u = floorToInt(a[0] * 65536.0), du = floorToInt(dx[0] * 65536.0);
+            s64 v = floorToInt(a[1] * 65536.0), dv = floorToInt(dx[1] * 65536.0);
+
+            for(s32 i = 0; i < count; i++, u += du, v += dv)
+                line[i] = mapping[getTriTexel(machine, &sheet, use_map, (s32)(u >> 16), (s32)(v >> 16))];
+        }
+
+        if(isDmaDraw(machine))
+            drawTileLineDma(memory, line, xl, y, 0, count);
+        else
+            for(s32 i = 0; i < count; i++)
+                if(line[i] != TRANSPARENT_COLOR)
+                    state->setpix(memory, xl + i, y, line[i]);
     }
 }
 
-void tic_api_textri(tic_mem* memory, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, bool use_map, u8* colors, s32 count)
+void tic_api_textri(tic_mem* memory, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, bool use_map, u8* colors, s32 count, float z1, float z2, float z3, bool depth)
 {
-    drawTexturedTriangle((tic_machine*)memory, x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, use_map, colors, count);
+    RECORD_DRAW(memory, .type = tic_draw_textri, .textri = {x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, z1, z2, z3, use_map, depth, drawColors(colors, count)});
+
+    u8 mapping[TIC_PALETTE_SIZE];
+    getPalette(memory, colors, count, mapping);
+
+    // perspective needs positive depths, the others are drawn affine
+    depth = depth && z1 > 0 && z2 > 0 && z3 > 0;
+
+    TexVert vertices[] =
+    {
+        {x1, y1, u1, v1, depth ? 1 / z1 : 1},
+        {x2, y2, u2, v2, depth ? 1 / z2 : 1},
+        {x3, y3, u3, v3, depth ? 1 / z3 : 1},
+    };
+
+    drawTexturedTriangle((tic_machine*)memory, vertices, use_map, depth, mapping);
 }
 
 void tic_api_map(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* colors, s32 count, s32 scale, RemapFunc remap, void* data)
 {
-    drawMap((tic_machine*)memory, &memory->ram.map, x, y, width, height, sx, sy, colors, count, scale, remap, data);
+    tic_machine* machine = (tic_machine*)memory;
+
+    // remap calls the script back, so it's drawn right away
+    if(remap)
+    {
+        bool recording = pauseDraw(machine);
+        drawMap(machine, &memory->ram.map, x, y, width, height, sx, sy, colors, count, scale, remap, data);
+        resumeDraw(machine, recording);
+        return;
+    }
+
+    RECORD_DRAW(memory, .type = tic_draw_map, .map = {x, y, width, height, sx, sy, scale, drawColors(colors, count)});
+
+    drawMap(machine, &memory->ram.map, x, y, width, height, sx, sy, colors, count, scale, remap, data);
+}
+
+void tic_core_map_batch(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* colors, s32 count, s32 scale, RemapBatchFunc remap, void* data)
+{
+    tic_machine* machine = (tic_machine*)memory;
+    bool recording = pauseDraw(machine);
+
+    drawMapBatch(machine, &memory->ram.map, x, y, width, height, sx, sy, colors, count, scale, remap, data);
+
+    resumeDraw(machine, recording);
 }
 
 void tic_api_mset(tic_mem* memory, s32 x, s32 y, u8 value)
 {
+    syncDraw((tic_machine*)memory);
+
     if(x < 0 || x >= TIC_MAP_WIDTH || y < 0 || y >= TIC_MAP_HEIGHT) return;
 
     tic_map* src = &memory->ram.map;
@@ -1167,6 +2562,8 @@ static inline void setLinePixel(tic_mem* tic, s32 x, s32 y, u8 color)
 
 void tic_api_line(tic_mem* memory, s32 x0, s32 y0, s32 x1, s32 y1, u8 color)
 {
+    RECORD_DRAW(memory, .type = tic_draw_line, .line = {x0, y0, x1, y1, color});
+
     ticLine(memory, x0, y0, x1, y1, mapColor(memory, color), setLinePixel);
 }
 
@@ -1235,8 +2632,17 @@ static void processMusic(tic_mem* memory)
 
     if(sound_state->flag.music_state == tic_music_stop) return;
 
+    // the sound state is in the RAM, a poked track or frame outside the music stops it
+    if(sound_state->music.track < 0 || sound_state->music.track >= MUSIC_TRACKS
+        || sound_state->music.frame < 0 || sound_state->music.frame >= MUSIC_FRAMES)
+    {
+        stopMusic(memory);
+        return;
+    }
+
     const tic_track* track = &memory->ram.music.tracks.data[sound_state->music.track];
-    s32 row = tick2row(track, machine->state.music.ticks);
+    const tic_music_track* decoded = getMusicTrack(machine, sound_state->music.track);
+    s32 row = trackRow(decoded, track, machine->state.music.ticks);
     tic_jump_command* jumpCmd = &machine->state.music.jump;
 
     if (row != sound_state->music.row 
@@ -1244,11 +2650,11 @@ static void processMusic(tic_mem* memory)
     {
         sound_state->music.frame = jumpCmd->frame;
         sound_state->music.row = jumpCmd->beat * NOTES_PER_BEAT;
-        machine->state.music.ticks = row2tick(track, sound_state->music.row);
+        machine->state.music.ticks = trackTick(decoded, track, sound_state->music.row);
         memset(jumpCmd, 0, sizeof(tic_jump_command));
     }
 
-    s32 rows = MUSIC_PATTERN_ROWS - track->rows;
+    s32 rows = decoded->rows;
     if (row >= rows)
     {
         row = 0;
@@ -1280,12 +2686,8 @@ static void processMusic(tic_mem* memory)
             }
             else
             {
-                s32 val = 0;
-                for (s32 c = 0; c < TIC_SOUND_CHANNELS; c++)
-                    val += tic_tool_get_pattern_id(track, sound_state->music.frame, c);
-
                 // empty frame detected
-                if(!val)
+                if(decoded->empty[sound_state->music.frame])
                 {
                     if(sound_state->flag.music_loop)
                         sound_state->music.frame = 0;
@@ -1313,18 +2715,18 @@ static void processMusic(tic_mem* memory)
 
         for (s32 c = 0; c < TIC_SOUND_CHANNELS; c++)
         {
-            s32 patternId = tic_tool_get_pattern_id(track, sound_state->music.frame, c);
+            s32 patternId = decoded->patterns[sound_state->music.frame][c];
             if (!patternId) continue;
 
-            const tic_track_pattern* pattern = &memory->ram.music.patterns.data[patternId - PATTERN_START];
-            const tic_track_row* trackRow = &pattern->rows[sound_state->music.row];
+            const tic_music_pattern* pattern = getMusicPattern(machine, patternId - PATTERN_START);
+            const tic_music_row* trackRow = &pattern->rows[sound_state->music.row];
             tic_channel_data* channel = &machine->state.music.channels[c];
             tic_command_data* cmdData = &machine->state.music.commands[c];
 
             if(trackRow->command == tic_music_cmd_delay)
             {
                 cmdData->delay.row = trackRow;
-                cmdData->delay.ticks = param2val(trackRow);
+                cmdData->delay.ticks = trackRow->param;
                 trackRow = NULL;
             }
             
@@ -1346,7 +2748,7 @@ static void processMusic(tic_mem* memory)
                 if(trackRow->note == NoteStop)
                     setMusicChannelData(memory, -1, 0, 0, channel->volume.left, channel->volume.right, c);
                 else if (trackRow->note >= NoteStart)
-                    setMusicChannelData(memory, tic_tool_get_track_row_sfx(trackRow), trackRow->note - NoteStart, trackRow->octave, 
+                    setMusicChannelData(memory, trackRow->sfx, trackRow->note - NoteStart, trackRow->octave, 
                         channel->volume.left, channel->volume.right, c);
 
                 switch(trackRow->command)
@@ -1375,11 +2777,11 @@ static void processMusic(tic_mem* memory)
                     break;
 
                 case tic_music_cmd_slide:
-                    cmdData->slide.duration = param2val(trackRow);
+                    cmdData->slide.duration = trackRow->param;
                     break;
 
                 case tic_music_cmd_pitch:
-                    cmdData->finepitch.value = param2val(trackRow) - PITCH_DELTA;
+                    cmdData->finepitch.value = trackRow->param - PITCH_DELTA;
                     break;
 
                 default: break;
@@ -1453,6 +2855,15 @@ void tic_core_tick_start(tic_mem* memory)
 {
     tic_machine* machine = (tic_machine*)memory;
 
+    tic_core_profile_begin(memory, tic_profile_start);
+
+    syncDraw(machine);
+
+    if(memory->overdraw.active)
+        memset(machine->overdraw.counts, 0, sizeof machine->overdraw.counts);
+
+    machine->overdraw.pixels = machine->overdraw.tiles = 0;
+
     for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i )
         memset(&memory->ram.registers[i], 0, sizeof(tic_sound_register));
 
@@ -1492,30 +2903,30 @@ void tic_core_tick_start(tic_mem* memory)
         else *hold = 0;
     }
 
-    machine->state.setpix = setPixelDma;
-    machine->state.getpix = getPixelDma;
+    setDrawTarget(machine, -1, false);
     machine->state.synced = 0;
-    machine->state.drawhline = drawHLineDma;
+
+    tic_core_profile_end(memory, tic_profile_start);
 }
 
-static void stereo_tick_end(tic_mem* memory, tic_sound_register_data* registers, blip_buffer_t* blip, u8 stereoRight)
+// plays the registers for the next clocks, they don't have to make up a whole tick
+static void runSound(tic_sound_synth* synth, const tic_sound_register* registers, const tic_stereo_volume* stereo, s32 clocks)
 {
-    enum {EndTime = CLOCKRATE / TIC80_FRAMERATE};
     for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i )
     {
-        u8 volume = tic_tool_peek4(&memory->ram.stereo.data, stereoRight + i*2);
-
-        const tic_sound_register* reg = &memory->ram.registers[i];
-        tic_sound_register_data* data = registers + i;
+        u8 left = tic_tool_peek4(&stereo->data, i*2);
+        u8 right = tic_tool_peek4(&stereo->data, 1 + i*2);
 
-        tic_tool_is_noise(&reg->waveform)
-            ? runNoise(blip, reg, data, EndTime, volume)
-            : runEnvelope(blip, reg, data, EndTime, volume);
+        tic_tool_is_noise(&registers[i].waveform)
+            ? runNoise(synth, &registers[i], i, clocks, left, right)
+            : runEnvelope(synth, &registers[i], i, clocks, left, right);
 
-        data->time -= EndTime;
+        synth->registers.left[i].time -= clocks;
+        synth->registers.right[i].time -= clocks;
     }
     
-    blip_end_frame(blip, EndTime);
+    blip_end_frame(synth->blip.left, clocks);
+    blip_end_frame(synth->blip.right, clocks);
 }
 
 void tic_core_tick_end(tic_mem* memory)
@@ -1523,18 +2934,36 @@ void tic_core_tick_end(tic_mem* memory)
     tic_machine* machine = (tic_machine*)memory;
     tic80_input* input = &machine->memory.ram.input;
 
+    tic_core_profile_begin(memory, tic_profile_end);
+
     machine->state.gamepads.previous.data = input->gamepads.data;
     machine->state.keyboard.previous.data = input->keyboard.data;
 
-    stereo_tick_end(memory, machine->state.registers.left, machine->blip.left, 0);
-    stereo_tick_end(memory, machine->state.registers.right, machine->blip.right, 1);
+    if(machine->audio.ring)
+    {
+        tic_sound_snapshot snapshot;
+        memcpy(snapshot.registers, memory->ram.registers, sizeof snapshot.registers);
+        snapshot.stereo = memory->ram.stereo;
+
+        // the audio thread is behind by the whole ring, the tick is dropped instead of adding latency
+        tic_audio_ring_push(machine->audio.ring, &snapshot);
+    }
+    else
+    {
+        tic_sound_synth* synth = &machine->synth;
+
+        runSound(synth, memory->ram.registers, &memory->ram.stereo, CLOCKRATE / TIC80_FRAMERATE);
+
+        blip_read_samples(synth->blip.left, memory->samples.buffer, machine->samplerate / TIC80_FRAMERATE, TIC_STEREO_CHANNELS);
+        blip_read_samples(synth->blip.right, memory->samples.buffer + 1, machine->samplerate / TIC80_FRAMERATE, TIC_STEREO_CHANNELS);
+    }
+
+    // the sound above is made while the worker draws the end of the frame
+    syncDraw(machine);
 
-    blip_read_samples(machine->blip.left, machine->memory.samples.buffer, machine->samplerate / TIC80_FRAMERATE, TIC_STEREO_CHANNELS);
-    blip_read_samples(machine->blip.right, machine->memory.samples.buffer + 1, machine->samplerate / TIC80_FRAMERATE, TIC_STEREO_CHANNELS);
+    setDrawTarget(machine, -1, true);
 
-    machine->state.setpix = setPixelOvr;
-    machine->state.getpix = getPixelOvr;
-    machine->state.drawhline = drawHLineOvr;
+    tic_core_profile_end(memory, tic_profile_end);
 }
 
 void tic_api_sfx(tic_mem* memory, s32 index, s32 note, s32 octave, s32 duration, s32 channel, s32 volume, s32 speed)
@@ -1563,6 +2992,8 @@ static void initCover(tic_mem* tic)
                     u8 color = tic_tool_find_closest_color(tic->cart.bank0.palette.scn.colors, c);
                     tic_tool_poke4(tic->ram.vram.screen.data, i, color);
                 }
+
+                invalidateRam((tic_machine*)tic, offsetof(tic_ram, vram.screen), sizeof(tic_screen));
             }
 
             gif_close(image);
@@ -1572,6 +3003,8 @@ static void initCover(tic_mem* tic)
 
 void tic_api_sync(tic_mem* tic, u32 mask, s32 bank, bool toCart)
 {
+    syncDraw((tic_machine*)tic);
+
     tic_machine* machine = (tic_machine*)tic;
 
     static const struct {s32 bank; s32 ram; s32 size;} Sections[] = 
@@ -1596,9 +3029,15 @@ void tic_api_sync(tic_mem* tic, u32 mask, s32 bank, bool toCart)
     for(s32 i = 0; i < Count; i++)
     {
         if(mask & (1 << i))
-            toCart
-                ? memcpy((u8*)&tic->cart.banks[bank] + Sections[i].bank, (u8*)&tic->ram + Sections[i].ram, Sections[i].size)
-                : memcpy((u8*)&tic->ram + Sections[i].ram, (u8*)&tic->cart.banks[bank] + Sections[i].bank, Sections[i].size);
+        {
+            if(toCart)
+                memcpy((u8*)&tic->cart.banks[bank] + Sections[i].bank, (u8*)&tic->ram + Sections[i].ram, Sections[i].size);
+            else
+            {
+                memcpy((u8*)&tic->ram + Sections[i].ram, (u8*)&tic->cart.banks[bank] + Sections[i].bank, Sections[i].size);
+                invalidateRam(machine, Sections[i].ram, Sections[i].size);
+            }
+        }
     }
 
     // copy OVR palette
@@ -1622,6 +3061,7 @@ static void cart2ram(tic_mem* memory)
     };
 
     memcpy(memory->ram.font.data, Font, sizeof Font);
+    invalidateRam((tic_machine*)memory, offsetof(tic_ram, font), sizeof(tic_font));
 
     tic_api_sync(memory, 0, 0, false);
     initCover(memory);
@@ -1771,8 +3211,14 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
                 tic->input.keyboard = 1;
             else tic->input.data = -1;  // default is all enabled
 
-            data->start = data->counter();
-            
+            data->start = data->counter(data->data);
+            tic->profile.trace.lang = config->name;
+
+            // set before the init, the script drops the callbacks it doesn't define
+            machine->state.tick = config->tick;
+            machine->state.scanline = config->scanline;
+            machine->state.ovr.callback = config->overline;
+
             done = config->init(tic, code);
         }
         else
@@ -1781,13 +3227,7 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
         }
 
         if(done)
-        {
-            machine->state.tick = config->tick;
-            machine->state.scanline = config->scanline;
-            machine->state.ovr.callback = config->overline;
-
             machine->state.initialized = true;
-        }
         else return;
     }
 
@@ -1802,13 +3242,116 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
             ZEROMEM(tic->ram.input.mouse);
     }
 
-    machine->state.tick(tic);
+    tic_core_profile_begin(tic, tic_profile_tick);
+    tic_drawlist_begin(machine->drawlist);
+    machine->state.tick(tic);
+    tic_drawlist_end(machine->drawlist);
+    tic_core_profile_end(tic, tic_profile_tick);
+}
+
+// draw calls of TIC() are recorded and rasterized by a worker thread while the script goes on,
+// returns false if the build has no threads
+bool tic_core_draw_thread(tic_mem* memory, bool enable)
+{
+    tic_machine* machine = (tic_machine*)memory;
+
+    if(enable && !machine->drawlist)
+        machine->drawlist = tic_drawlist_create(memory);
+    else if(!enable && machine->drawlist)
+    {
+        tic_drawlist_delete(machine->drawlist);
+        machine->drawlist = NULL;
+    }
+
+    return machine->drawlist != NULL;
+}
+
+// screen writes are counted from the start of every frame and shown by the blit as a heatmap,
+// the fast paths stay selected and count the pixels they write
+void tic_core_overdraw(tic_mem* memory, bool enable)
+{
+    tic_machine* machine = (tic_machine*)memory;
+
+    if(memory->overdraw.active == enable) return;
+
+    syncDraw(machine);
+
+    // the totals of the last frame stay readable after the view goes off
+    memory->overdraw.active = enable;
+    memset(machine->overdraw.counts, 0, sizeof machine->overdraw.counts);
+    machine->overdraw.pixels = 0;
+
+    // the screen is converted again when the view goes off
+    memset(machine->dirty.vram, true, sizeof machine->dirty.vram);
+
+    setDrawTarget(machine, machine->state.target.index, machine->state.target.ovr);
+}
+
+// the ticks queue their sound registers and the audio thread synthesizes them with tic_core_synth_audio,
+// the ring holds up to the given number of ticks, 0 makes tic_core_tick_end fill the samples again;
+// the audio thread must not run while this is called
+bool tic_core_audio_ring(tic_mem* memory, s32 ticks)
+{
+    tic_machine* machine = (tic_machine*)memory;
+
+    tic_audio_ring_delete(machine->audio.ring);
+    machine->audio.ring = ticks > 0 ? tic_audio_ring_create(ticks) : NULL;
+
+    memset(&machine->audio.current, 0, sizeof machine->audio.current);
+    machine->audio.clocks = machine->audio.starved = 0;
+
+    memset(memory->samples.buffer, 0, memory->samples.size);
+
+    return machine->audio.ring != NULL;
+}
+
+// called by the audio thread for as many stereo frames as the device wants, the ticks are consumed
+// clock by clock, so the sound of a tick starts as soon as the device asks for the next few samples
+void tic_core_synth_audio(tic_mem* memory, s16* samples, s32 count)
+{
+    enum {EndTime = CLOCKRATE / TIC80_FRAMERATE};
+
+    tic_machine* machine = (tic_machine*)memory;
+    tic_sound_synth* synth = &machine->synth;
+
+    while(count > 0)
+    {
+        // the blip buffers hold a bit more than a tick
+        s32 frames = MIN(count, machine->samplerate / TIC80_FRAMERATE);
+        s32 clocks = blip_clocks_needed(synth->blip.left, frames);
+
+        while(clocks > 0)
+        {
+            if(machine->audio.clocks == 0)
+            {
+                // a late tick plays the last registers again, the sound stops if the ticks don't come back
+                if(tic_audio_ring_pop(machine->audio.ring, &machine->audio.current))
+                    machine->audio.starved = 0;
+                else if(++machine->audio.starved > tic_audio_ring_capacity(machine->audio.ring))
+                    memset(&machine->audio.current, 0, sizeof machine->audio.current);
+
+                machine->audio.clocks = EndTime;
+            }
+
+            s32 step = MIN(clocks, machine->audio.clocks);
+            runSound(synth, machine->audio.current.registers, &machine->audio.current.stereo, step);
+
+            machine->audio.clocks -= step;
+            clocks -= step;
+        }
+
+        blip_read_samples(synth->blip.left, samples, frames, TIC_STEREO_CHANNELS);
+        blip_read_samples(synth->blip.right, samples + 1, frames, TIC_STEREO_CHANNELS);
+
+        samples += frames * TIC_STEREO_CHANNELS;
+        count -= frames;
+    }
 }
 
 double tic_api_time(tic_mem* memory)
 {
     tic_machine* machine = (tic_machine*)memory;
-    return (double)((machine->data->counter() - machine->data->start)*1000)/machine->data->freq();
+    return (double)((machine->data->counter(machine->data->data) - machine->data->start)*1000)/machine->data->freq(machine->data->data);
 }
 
 s32 tic_api_tstamp(tic_mem* memory)
@@ -1931,88 +3474,432 @@ static inline void memset4(void *dst, u32 val, u32 dwords)
 #endif
 }
 
+static void updateBlitPalette(tic_blit_palette* pal, const tic_palette* src, tic80_pixel_color_format fmt)
+{
+    if(pal->fmt == fmt && memcmp(&pal->src, src, sizeof(tic_palette)) == 0)
+        return;
+
+    pal->src = *src;
+    pal->fmt = fmt;
+    tic_tool_palette_blit(pal->colors, src, fmt);
+
+    for(s32 i = 0; i < COUNT_OF(pal->pairs); i++)
+    {
+        pal->pairs[i][0] = pal->colors[i & 0xf];
+        pal->pairs[i][1] = pal->colors[i >> TIC_PALETTE_BPP];
+    }
+
+    for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+        for(s32 b = 0; b < sizeof(u32); b++)
+            pal->planes[b][i] = ((const u8*)&pal->colors[i])[b];
+
+    pal->version++;
+}
+
+// converts 16 pixels (8 bytes of VRAM) per step with a table lookup for every byte of the output color
+#if defined(__AVX2__) || defined(__SSSE3__)
+
+static inline const u8* blitPixels16(u32** dst, const u8* src, s32* count, const tic_blit_palette* pal)
+{
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i p0 = _mm_loadu_si128((const __m128i*)pal->planes[0]);
+    const __m128i p1 = _mm_loadu_si128((const __m128i*)pal->planes[1]);
+    const __m128i p2 = _mm_loadu_si128((const __m128i*)pal->planes[2]);
+    const __m128i p3 = _mm_loadu_si128((const __m128i*)pal->planes[3]);
+
+    for(; *count >= 16; *count -= 16, src += 8, *dst += 16)
+    {
+        __m128i v = _mm_loadl_epi64((const __m128i*)src);
+        __m128i index = _mm_unpacklo_epi8(_mm_and_si128(v, mask), _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+
+        __m128i b0 = _mm_shuffle_epi8(p0, index);
+        __m128i b1 = _mm_shuffle_epi8(p1, index);
+        __m128i b2 = _mm_shuffle_epi8(p2, index);
+        __m128i b3 = _mm_shuffle_epi8(p3, index);
+
+        __m128i lo01 = _mm_unpacklo_epi8(b0, b1), hi01 = _mm_unpackhi_epi8(b0, b1);
+        __m128i lo23 = _mm_unpacklo_epi8(b2, b3), hi23 = _mm_unpackhi_epi8(b2, b3);
+
+        __m128i* out = (__m128i*)*dst;
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(lo01, lo23));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo01, lo23));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi01, hi23));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi01, hi23));
+    }
+
+    return src;
+}
+
+#elif defined(__ARM_NEON)
+
+static inline const u8* blitPixels16(u32** dst, const u8* src, s32* count, const tic_blit_palette* pal)
+{
+    const uint8x8_t mask = vdup_n_u8(0x0f);
+
+#if defined(__aarch64__)
+    const uint8x16_t p0 = vld1q_u8(pal->planes[0]);
+    const uint8x16_t p1 = vld1q_u8(pal->planes[1]);
+    const uint8x16_t p2 = vld1q_u8(pal->planes[2]);
+    const uint8x16_t p3 = vld1q_u8(pal->planes[3]);
+#   define LOOKUP(P, I) vqtbl1q_u8(P, I)
+#else
+    const uint8x8x2_t p0 = {{vld1_u8(pal->planes[0]), vld1_u8(pal->planes[0] + 8)}};
+    const uint8x8x2_t p1 = {{vld1_u8(pal->planes[1]), vld1_u8(pal->planes[1] + 8)}};
+    const uint8x8x2_t p2 = {{vld1_u8(pal->planes[2]), vld1_u8(pal->planes[2] + 8)}};
+    const uint8x8x2_t p3 = {{vld1_u8(pal->planes[3]), vld1_u8(pal->planes[3] + 8)}};
+#   define LOOKUP(P, I) vcombine_u8(vtbl2_u8(P, vget_low_u8(I)), vtbl2_u8(P, vget_high_u8(I)))
+#endif
+
+    for(; *count >= 16; *count -= 16, src += 8, *dst += 16)
+    {
+        uint8x8_t v = vld1_u8(src);
+        uint8x8x2_t nibbles = vzip_u8(vand_u8(v, mask), vshr_n_u8(v, 4));
+        uint8x16_t index = vcombine_u8(nibbles.val[0], nibbles.val[1]);
+
+        uint8x16x4_t out = {{LOOKUP(p0, index), LOOKUP(p1, index), LOOKUP(p2, index), LOOKUP(p3, index)}};
+        vst4q_u8((u8*)*dst, out);
+    }
+
+#undef LOOKUP
+
+    return src;
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+static inline const u8* blitPixels32(u32** dst, const u8* src, s32* count, const tic_blit_palette* pal)
+{
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m256i p0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)pal->planes[0]));
+    const __m256i p1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)pal->planes[1]));
+    const __m256i p2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)pal->planes[2]));
+    const __m256i p3 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)pal->planes[3]));
+
+    for(; *count >= 32; *count -= 32, src += 16, *dst += 32)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)src);
+        __m128i lo = _mm_and_si128(v, mask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+
+        // lane 0 holds pixels 0-15, lane 1 holds pixels 16-31
+        __m256i index = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(lo, hi)), _mm_unpackhi_epi8(lo, hi), 1);
+
+        __m256i b0 = _mm256_shuffle_epi8(p0, index);
+        __m256i b1 = _mm256_shuffle_epi8(p1, index);
+        __m256i b2 = _mm256_shuffle_epi8(p2, index);
+        __m256i b3 = _mm256_shuffle_epi8(p3, index);
+
+        __m256i lo01 = _mm256_unpacklo_epi8(b0, b1), hi01 = _mm256_unpackhi_epi8(b0, b1);
+        __m256i lo23 = _mm256_unpacklo_epi8(b2, b3), hi23 = _mm256_unpackhi_epi8(b2, b3);
+
+        __m256i c0 = _mm256_unpacklo_epi16(lo01, lo23);
+        __m256i c1 = _mm256_unpackhi_epi16(lo01, lo23);
+        __m256i c2 = _mm256_unpacklo_epi16(hi01, hi23);
+        __m256i c3 = _mm256_unpackhi_epi16(hi01, hi23);
+
+        __m256i* out = (__m256i*)*dst;
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(c0, c1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(c2, c3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(c0, c1, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(c2, c3, 0x31));
+    }
+
+    return src;
+}
+
+#endif
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__ARM_NEON)
+#   define BLIT_SIMD 1
+#else
+#   define BLIT_SIMD 0
+#endif
+
+// converts count pixels of the VRAM row starting from the start pixel, only the table lookup is used when scalar is set
+static void blitPixels(u32* dst, const u8* row, s32 start, s32 count, const tic_blit_palette* pal, bool scalar)
+{
+    if(count <= 0) return;
+
+    if(start & 1)
+    {
+        *dst++ = pal->colors[row[start >> 1] >> TIC_PALETTE_BPP];
+        start++;
+        count--;
+    }
+
+    const u8* src = row + (start >> 1);
+
+#if BLIT_SIMD
+    if(!scalar)
+    {
+#   if defined(__AVX2__)
+        src = blitPixels32(&dst, src, &count, pal);
+#   endif
+        src = blitPixels16(&dst, src, &count, pal);
+    }
+#endif
+
+    for(; count >= 2; count -= 2, dst += 2)
+        memcpy(dst, pal->pairs[*src++], sizeof pal->pairs[0]);
+
+    if(count)
+        *dst = pal->colors[*src & 0xf];
+}
+
+// stores the state the screen buffer row is converted with, returns false if the row is up to date
+static bool updateBlitRow(tic_machine* machine, s32 row, s16 x, s8 y, u8 border, bool force)
+{
+    tic_blit_row* state = &machine->dirty.rows[row];
+    u32 palette = machine->blitpal.version;
+
+    if(!force && state->palette == palette && state->x == x && state->y == y && state->border == border)
+        return false;
+
+    *state = (tic_blit_row){palette, x, y, border};
+    markScreenChanged(machine, row);
+
+    return true;
+}
+
+// applies the raster table entry of the screen row on top of the VRAM state
+static void applyRasterRow(tic_machine* machine, s32 row, s32* x, u8* border, tic80_pixel_color_format fmt)
+{
+    const tic_raster_row* entry = &machine->state.raster.rows[row];
+    const tic_palette* palette = &machine->memory.ram.vram.palette;
+    tic_palette merged;
+
+    if(entry->set)
+    {
+        *x += entry->x;
+
+        if(entry->border >= 0)
+            *border = entry->border;
+
+        if(entry->mask)
+        {
+            merged = *palette;
+
+            for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+                if(entry->mask & (1 << i))
+                    merged.colors[i] = entry->palette.colors[i];
+
+            palette = &merged;
+        }
+    }
+
+    updateBlitPalette(&machine->blitpal, palette, fmt);
+}
+
+// shows the writes counted since the frame started instead of the screen,
+// the rows are converted again by the next blit
+static void blitOverdraw(tic_machine* machine, tic80_pixel_color_format fmt)
+{
+    // black for untouched pixels, then blue to red for 1 to 8 writes and up to white
+    static const tic_palette Heat = {.colors = 
+    {
+        {0x00, 0x00, 0x00}, {0x10, 0x20, 0x80}, {0x10, 0x60, 0xd0}, {0x10, 0xa0, 0xa0},
+        {0x20, 0xc0, 0x40}, {0x90, 0xd0, 0x20}, {0xf0, 0xd0, 0x20}, {0xf0, 0x90, 0x20},
+        {0xf0, 0x40, 0x20}, {0xd0, 0x10, 0x40}, {0xe0, 0x30, 0x90}, {0xf0, 0x60, 0xc0},
+        {0xf0, 0x90, 0xe0}, {0xf0, 0xc0, 0xf0}, {0xf8, 0xe0, 0xf8}, {0xff, 0xff, 0xff},
+    }};
+
+    enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2};
+    enum {Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2};
+
+    tic_mem* tic = &machine->memory;
+    const u16* counts = machine->overdraw.counts;
+    u32 colors[TIC_PALETTE_SIZE];
+    u32 covered = 0;
+    u16 peak = 0;
+
+    tic_tool_palette_blit(colors, &Heat, fmt);
+
+    for(s32 r = 0; r < TIC80_HEIGHT; r++)
+    {
+        u32* dst = tic->screen + (Top + r) * TIC80_FULLWIDTH + Left;
+
+        for(s32 x = 0; x < TIC80_WIDTH; x++)
+        {
+            u16 count = *counts++;
+
+            covered += count > 0;
+            peak = MAX(peak, count);
+            dst[x] = colors[MIN(count, TIC_PALETTE_SIZE - 1)];
+        }
+
+        markScreenChanged(machine, Top + r);
+    }
+
+    memset(machine->dirty.vram, true, sizeof machine->dirty.vram);
+
+    tic->overdraw.pixels = machine->overdraw.pixels;
+    tic->overdraw.covered = covered;
+    tic->overdraw.tiles = machine->overdraw.tiles;
+    tic->overdraw.peak = peak;
+}
+
+// SCN time is taken out of the blit phase
+static void profileScanline(tic_mem* tic, tic_scanline scanline, s32 row, void* data)
+{
+    if(tic->profile.counter)
+    {
+        tic_core_profile_end(tic, tic_profile_blit);
+        tic_core_profile_begin(tic, tic_profile_scanline);
+        scanline(tic, row, data);
+        tic_core_profile_end(tic, tic_profile_scanline);
+        tic_core_profile_begin(tic, tic_profile_blit);
+    }
+    else scanline(tic, row, data);
+}
+
 void tic_core_blit_ex(tic_mem* tic, tic80_pixel_color_format fmt, tic_scanline scanline, tic_overline overline, void* data)
 {
+    tic_machine* machine = (tic_machine*)tic;
+    tic_dirty_rows* dirty = &machine->dirty;
+
+    syncDraw(machine);
+
     // init OVR palette
     {
-        tic_machine* machine = (tic_machine*)tic;
-
         const tic_palette* ovr = &machine->state.ovr.palette;
         bool ovrEmpty = true;
         for(s32 i = 0; i < sizeof(tic_palette); i++)
             if(ovr->data[i])
                 ovrEmpty = false;
 
-        memcpy(machine->state.ovr.raw, tic_tool_palette_blit(ovrEmpty ? &tic->ram.vram.palette : ovr, fmt), sizeof machine->state.ovr.raw);
+        tic_tool_palette_blit(machine->state.ovr.raw, ovrEmpty ? &tic->ram.vram.palette : ovr, fmt);
     }
 
+    // take the rows written so far, the ones written by SCN and OVR below are kept for the next blit
+    bool vramRows[TIC80_HEIGHT], ovrRows[TIC80_HEIGHT];
+    memcpy(vramRows, dirty->vram, sizeof vramRows);
+    memcpy(ovrRows, dirty->ovr, sizeof ovrRows);
+    memset(dirty->vram, 0, sizeof dirty->vram);
+    memset(dirty->ovr, 0, sizeof dirty->ovr);
+    memset(dirty->changed, 0, sizeof dirty->changed);
+    memset(&tic->dirty, 0, sizeof tic->dirty);
+
+    tic_core_profile_begin(tic, tic_profile_blit);
+
     if(scanline)
-        scanline(tic, 0, data);
+        profileScanline(tic, scanline, 0, data);
 
-    const u32* pal = tic_tool_palette_blit(&tic->ram.vram.palette, fmt);
+    tic_blit_palette* pal = &machine->blitpal;
+    updateBlitPalette(pal, &tic->ram.vram.palette, fmt);
 
     enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2, Bottom = Top};
     enum {Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2, Right = Left};
 
     u32* out = tic->screen;
 
-    memset4(&out[0 * TIC80_FULLWIDTH], pal[tic->ram.vram.vars.border], TIC80_FULLWIDTH*Top);
+    for(s32 r = 0; r < Top; r++)
+        if(updateBlitRow(machine, r, 0, 0, tic->ram.vram.vars.border, false))
+            memset4(&out[r * TIC80_FULLWIDTH], pal->colors[tic->ram.vram.vars.border], TIC80_FULLWIDTH);
 
     u32* rowPtr = out + (Top*TIC80_FULLWIDTH);
     for(s32 r = 0; r < TIC80_HEIGHT; r++, rowPtr += TIC80_FULLWIDTH)
     {
-        u32 *colPtr = rowPtr + Left;
-        memset4(rowPtr, pal[tic->ram.vram.vars.border], Left);
+        s32 x = tic->ram.vram.vars.offset.x;
+        s8 y = tic->ram.vram.vars.offset.y;
+        u8 border = tic->ram.vram.vars.border;
+        s32 src = (r + y + TIC80_HEIGHT) % TIC80_HEIGHT;
 
-        s32 pos = (r + tic->ram.vram.vars.offset.y + TIC80_HEIGHT) % TIC80_HEIGHT * TIC80_WIDTH >> 1;
+        if(machine->state.raster.active)
+            applyRasterRow(machine, r, &x, &border, fmt);
 
-        u32 x = (-tic->ram.vram.vars.offset.x + TIC80_WIDTH) % TIC80_WIDTH;
-        for(s32 c = 0; c < TIC80_WIDTH / 2; c++)
+        if(updateBlitRow(machine, Top + r, x, y, border, vramRows[src] || dirty->vram[src] || ovrRows[r] || dirty->ovr[r]))
         {
-            u8 val = ((u8*)tic->ram.vram.screen.data)[pos + c];
-            *(colPtr + (x++ % TIC80_WIDTH)) = pal[val & 0xf];
-            *(colPtr + (x++ % TIC80_WIDTH)) = pal[val >> 4];
+            u32 *colPtr = rowPtr + Left;
+            memset4(rowPtr, pal->colors[border], Left);
+
+            const u8* row = tic->ram.vram.screen.data + (src * TIC80_WIDTH >> 1);
+
+            // the row is rotated by the horizontal offset, so it's copied as two contiguous segments
+            s32 shift = (-x % TIC80_WIDTH + TIC80_WIDTH) % TIC80_WIDTH;
+            blitPixels(colPtr + shift, row, 0, TIC80_WIDTH - shift, pal, machine->blitScalar);
+            blitPixels(colPtr, row, TIC80_WIDTH - shift, shift, pal, machine->blitScalar);
+
+            memset4(rowPtr + (TIC80_FULLWIDTH-Right), pal->colors[border], Right);
         }
 
-        memset4(rowPtr + (TIC80_FULLWIDTH-Right), pal[tic->ram.vram.vars.border], Right);
-            
         if(scanline && (r < TIC80_HEIGHT-1))
         {
-            scanline(tic, r+1, data);
-            pal = tic_tool_palette_blit(&tic->ram.vram.palette, fmt);
+            profileScanline(tic, scanline, r+1, data);
+            updateBlitPalette(pal, &tic->ram.vram.palette, fmt);
         }
     }
 
-    memset4(&out[(TIC80_FULLHEIGHT-Bottom) * TIC80_FULLWIDTH], pal[tic->ram.vram.vars.border], TIC80_FULLWIDTH*Bottom);
+    if(machine->state.raster.active)
+        updateBlitPalette(pal, &tic->ram.vram.palette, fmt);
+
+    for(s32 r = TIC80_FULLHEIGHT-Bottom; r < TIC80_FULLHEIGHT; r++)
+        if(updateBlitRow(machine, r, 0, 0, tic->ram.vram.vars.border, false))
+            memset4(&out[r * TIC80_FULLWIDTH], pal->colors[tic->ram.vram.vars.border], TIC80_FULLWIDTH);
+
+    tic_core_profile_end(tic, tic_profile_blit);
 
     if(overline)
+    {
+        tic_core_profile_begin(tic, tic_profile_overline);
         overline(tic, data);
+        tic_core_profile_end(tic, tic_profile_overline);
+    }
+
+    if(tic->overdraw.active)
+        blitOverdraw(machine, fmt);
+}
+
+// picks the SIMD or the table lookup conversion of the blit, returns false if the SIMD kernels aren't used
+bool tic_core_blit_simd(tic_mem* memory, bool enable)
+{
+    tic_machine* machine = (tic_machine*)memory;
 
+    machine->blitScalar = !enable;
+
+    return BLIT_SIMD && enable;
 }
 
 static inline void scanline(tic_mem* memory, s32 row, void* data)
 {
     tic_machine* machine = (tic_machine*)memory;
 
-    if(machine->state.initialized)
-        machine->state.scanline(memory, row, data);
+    machine->state.scanline(memory, row, data);
 }
 
 static inline void overline(tic_mem* memory, void* data)
 {
     tic_machine* machine = (tic_machine*)memory;
 
-    if(machine->state.initialized)
-        machine->state.ovr.callback(memory, data);
+    machine->state.ovr.callback(memory, data);
 }
 
 void tic_core_blit(tic_mem* tic, tic80_pixel_color_format fmt)
 {
-    tic_core_blit_ex(tic, fmt, scanline, overline, NULL);
+    tic_machine* machine = (tic_machine*)tic;
+    bool initialized = machine->state.initialized;
+
+    // no row is dispatched at all if the script has no SCN
+    tic_core_blit_ex(tic, fmt,
+        initialized && machine->state.scanline ? scanline : NULL,
+        initialized && machine->state.ovr.callback ? overline : NULL, NULL);
+}
+
+// called by the script after the code is loaded or evaluated and after every TIC() with the callbacks it defines
+void tic_core_script_callbacks(tic_mem* memory, bool scanline, bool overline)
+{
+    tic_machine* machine = (tic_machine*)memory;
+    const tic_script_config* config = tic_core_script_config(memory);
+
+    machine->state.scanline = scanline ? config->scanline : NULL;
+    machine->state.ovr.callback = overline ? config->overline : NULL;
 }
 
 u8 tic_api_peek(tic_mem* memory, s32 address)
 {
+    syncDraw((tic_machine*)memory);
+
     if(address >=0 && address < sizeof(tic_ram))
         return *((u8*)&memory->ram + address);
 
@@ -2021,12 +3908,19 @@ u8 tic_api_peek(tic_mem* memory, s32 address)
 
 void tic_api_poke(tic_mem* memory, s32 address, u8 value)
 {
+    syncDraw((tic_machine*)memory);
+
     if(address >=0 && address < sizeof(tic_ram))
+    {
         *((u8*)&memory->ram + address) = value;
+        invalidateRam((tic_machine*)memory, address, 1);
+    }
 }
 
 u8 tic_api_peek4(tic_mem* memory, s32 address)
 {
+    syncDraw((tic_machine*)memory);
+
     if(address >=0 && address < sizeof(tic_ram)*2)
         return tic_tool_peek4((u8*)&memory->ram, address);
 
@@ -2035,12 +3929,19 @@ u8 tic_api_peek4(tic_mem* memory, s32 address)
 
 void tic_api_poke4(tic_mem* memory, s32 address, u8 value)
 {
+    syncDraw((tic_machine*)memory);
+
     if(address >=0 && address < sizeof(tic_ram)*2)
+    {
         tic_tool_poke4((u8*)&memory->ram, address, value);
+        invalidateRam((tic_machine*)memory, address >> 1, 1);
+    }
 }
 
 void tic_api_memcpy(tic_mem* memory, s32 dst, s32 src, s32 size)
 {
+    syncDraw((tic_machine*)memory);
+
     s32 bound = sizeof(tic_ram) - size;
 
     if(size >= 0 
@@ -2052,11 +3953,14 @@ void tic_api_memcpy(tic_mem* memory, s32 dst, s32 src, s32 size)
     {
         u8* base = (u8*)&memory->ram;
         memcpy(base + dst, base + src, size);
+        invalidateRam((tic_machine*)memory, dst, size);
     }
 }
 
 void tic_api_memset(tic_mem* memory, s32 dst, u8 val, s32 size)
 {
+    syncDraw((tic_machine*)memory);
+
     s32 bound = sizeof(tic_ram) - size;
 
     if(size >= 0 
@@ -2066,9 +3970,108 @@ void tic_api_memset(tic_mem* memory, s32 dst, u8 val, s32 size)
     {
         u8* base = (u8*)&memory->ram;
         memset(base + dst, val, size);
+        invalidateRam((tic_machine*)memory, dst, size);
+    }
+}
+
+// clamps [address, address + size) to [0, limit), returns false if nothing is left
+static bool clampRange(s32 address, s32 size, s32 limit, s32* start, s32* end)
+{
+    *start = MAX(address, 0);
+    *end = (s32)MIN((s64)address + MAX(size, 0), limit);
+
+    return *start < *end;
+}
+
+void tic_api_peekbuf(tic_mem* memory, s32 address, u8* buffer, s32 size)
+{
+    syncDraw((tic_machine*)memory);
+
+    s32 start, end;
+
+    // bytes out of RAM read as zero, same as peek()
+    memset(buffer, 0, MAX(size, 0));
+
+    if(clampRange(address, size, sizeof(tic_ram), &start, &end))
+        memcpy(buffer + (start - address), (u8*)&memory->ram + start, end - start);
+}
+
+void tic_api_pokebuf(tic_mem* memory, s32 address, const u8* buffer, s32 size)
+{
+    syncDraw((tic_machine*)memory);
+
+    s32 start, end;
+
+    if(clampRange(address, size, sizeof(tic_ram), &start, &end))
+    {
+        memcpy((u8*)&memory->ram + start, buffer + (start - address), end - start);
+        invalidateRam((tic_machine*)memory, start, end - start);
+    }
+}
+
+void tic_api_peek4buf(tic_mem* memory, s32 address, u8* buffer, s32 size)
+{
+    syncDraw((tic_machine*)memory);
+
+    s32 start, end;
+
+    memset(buffer, 0, MAX(size, 0));
+
+    if(clampRange(address, size, sizeof(tic_ram) * 2, &start, &end))
+    {
+        const u8* ram = (const u8*)&memory->ram;
+        u8* dst = buffer + (start - address);
+
+        for(s32 i = start; i < end; i++)
+            *dst++ = tic_tool_peek4(ram, i);
+    }
+}
+
+void tic_api_poke4buf(tic_mem* memory, s32 address, const u8* buffer, s32 size)
+{
+    syncDraw((tic_machine*)memory);
+
+    s32 start, end;
+
+    if(clampRange(address, size, sizeof(tic_ram) * 2, &start, &end))
+    {
+        u8* ram = (u8*)&memory->ram;
+        const u8* src = buffer + (start - address);
+
+        for(s32 i = start; i < end; i++)
+            tic_tool_poke4(ram, i, *src++);
+
+        invalidateRam((tic_machine*)memory, start >> 1, ((end - 1) >> 1) - (start >> 1) + 1);
+    }
+}
+
+// screen buffer rows drawn over outside of the machine after the blit, they are uploaded
+// with the current frame and converted again by the next blit
+void tic_core_screen_drawn(tic_mem* memory, s32 top, s32 bottom)
+{
+    enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2};
+
+    tic_machine* machine = (tic_machine*)memory;
+
+    for(s32 r = MAX(top, 0); r < MIN(bottom, TIC80_FULLHEIGHT); r++)
+    {
+        if(r >= Top && r < Top + TIC80_HEIGHT)
+            markOvrRow(machine, r - Top);
+        else
+        {
+            // border rows are always converted with no offset, so this state never matches
+            machine->dirty.rows[r].x = -1;
+            markScreenChanged(machine, r);
+        }
     }
 }
 
+void tic_core_invalidate(tic_mem* memory, s32 address, s32 size)
+{
+    syncDraw((tic_machine*)memory);
+    invalidateRam((tic_machine*)memory, address, size);
+}
+
 void tic_api_trace(tic_mem* memory, const char* text, u8 color)
 {
     tic_machine* machine = (tic_machine*)memory;
@@ -2093,6 +4096,139 @@ void tic_api_exit(tic_mem* tic)
 
 void tic_api_mouse(tic_mem* memory) {}
 
+void tic_core_profile_enable(tic_mem* memory, u64 (*counter)(void*), u64 freq, void* data)
+{
+    tic_profile* profile = &memory->profile;
+
+    if(counter && !profile->counter)
+    {
+        memset(profile->frames, 0, sizeof profile->frames);
+        profile->frame = 0;
+    }
+
+    profile->counter = counter;
+    profile->freq = freq;
+    profile->data = data;
+}
+
+void tic_core_profile_frame(tic_mem* memory)
+{
+    tic_profile* profile = &memory->profile;
+
+    if(profile->counter)
+    {
+        profile->frame++;
+        memset(profile->frames[profile->frame % TIC_PROFILE_FRAMES], 0, sizeof profile->frames[0]);
+    }
+}
+
+void tic_core_profile_begin(tic_mem* memory, tic_profile_phase phase)
+{
+    tic_profile* profile = &memory->profile;
+
+    if(profile->counter)
+        profile->start[phase] = profile->counter(profile->data);
+}
+
+static void pushTraceEvent(tic_profile* profile, u16 id, const char* lang, u64 start, u64 end)
+{
+    if(profile->trace.count == profile->trace.size)
+    {
+        s32 size = profile->trace.size ? profile->trace.size * 2 : 4096;
+        tic_trace_event* events = size <= TIC_TRACE_MAX_EVENTS 
+            ? realloc(profile->trace.events, size * sizeof(tic_trace_event)) 
+            : NULL;
+
+        if(!events)
+        {
+            profile->trace.dropped++;
+            return;
+        }
+
+        profile->trace.events = events;
+        profile->trace.size = size;
+    }
+
+    profile->trace.events[profile->trace.count++] = (tic_trace_event){start, end - start, lang, id};
+}
+
+void tic_core_profile_end(tic_mem* memory, tic_profile_phase phase)
+{
+    tic_profile* profile = &memory->profile;
+
+    if(profile->counter)
+    {
+        u64 end = profile->counter(profile->data);
+        profile->frames[profile->frame % TIC_PROFILE_FRAMES][phase] += end - profile->start[phase];
+
+        if(profile->trace.active)
+            pushTraceEvent(profile, phase, NULL, profile->start[phase], end);
+    }
+}
+
+void tic_core_trace_start(tic_mem* memory, bool api)
+{
+    tic_profile* profile = &memory->profile;
+
+    free(profile->trace.events);
+    profile->trace.events = NULL;
+    profile->trace.count = profile->trace.size = profile->trace.dropped = 0;
+
+    profile->trace.active = true;
+    profile->trace.api = api;
+}
+
+void tic_core_trace_stop(tic_mem* memory)
+{
+    tic_profile* profile = &memory->profile;
+
+    profile->trace.active = false;
+    profile->trace.api = false;
+}
+
+u64 tic_core_trace_begin(tic_mem* memory)
+{
+    tic_profile* profile = &memory->profile;
+
+    return profile->trace.active && profile->counter ? profile->counter(profile->data) : 0;
+}
+
+void tic_core_trace_end(tic_mem* memory, tic_api_index index, u64 start)
+{
+    tic_profile* profile = &memory->profile;
+
+    if(profile->trace.active && profile->counter)
+        pushTraceEvent(profile, index, profile->trace.lang ? profile->trace.lang : "", start, profile->counter(profile->data));
+}
+
+// every machine has its own generator behind the random functions of the scripts,
+// so machines on different threads neither share nor race on the C library one
+void tic_core_random_seed(tic_mem* memory, u64 seed)
+{
+    tic_machine* machine = (tic_machine*)memory;
+
+    // a splitmix64 step, so close seeds give unrelated states and the state is never zero
+    u64 z = seed + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+    machine->random = (z ^ (z >> 31)) | 1;
+}
+
+// xorshift64*
+u32 tic_core_random(tic_mem* memory)
+{
+    tic_machine* machine = (tic_machine*)memory;
+    u64 x = machine->random;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    machine->random = x;
+
+    return (x * 0x2545f4914f6cdd1dull) >> 32;
+}
+
 tic_mem* tic_core_create(s32 samplerate)
 {
     tic_machine* machine = (tic_machine*)malloc(sizeof(tic_machine));
@@ -2115,11 +4251,13 @@ tic_mem* tic_core_create(s32 samplerate)
     machine->memory.samples.size = samplerate * TIC_STEREO_CHANNELS / TIC80_FRAMERATE * sizeof(s16);
     machine->memory.samples.buffer = malloc(machine->memory.samples.size);
 
-    machine->blip.left = blip_new(samplerate / 10);
-    machine->blip.right = blip_new(samplerate / 10);
+    machine->synth.blip.left = blip_new(samplerate / 10);
+    machine->synth.blip.right = blip_new(samplerate / 10);
+
+    blip_set_rates(machine->synth.blip.left, CLOCKRATE, samplerate);
+    blip_set_rates(machine->synth.blip.right, CLOCKRATE, samplerate);
 
-    blip_set_rates(machine->blip.left, CLOCKRATE, samplerate);
-    blip_set_rates(machine->blip.right, CLOCKRATE, samplerate);
+    tic_core_random_seed(&machine->memory, (u64)time(NULL) ^ (uintptr_t)machine);
 
     tic_api_reset(&machine->memory);
 
@@ -44,6 +44,7 @@
 #define TIC_SPRITES (TIC_BANK_SPRITES * TIC_SPRITE_BANKS)
 
 #define TIC_SPRITESHEET_SIZE 128
+#define TIC_TARGETS 4
 
 #define TIC_MAP_ROWS (TIC_SPRITESIZE)
 #define TIC_MAP_COLS (TIC_SPRITESIZE)
@@ -492,6 +493,33 @@ typedef struct
     u32 data[TIC_PERSISTENT_SIZE];
 } tic_persistent;
 
+// sprite attributes read by oam() from any RAM address
+typedef struct
+{
+    u16 index;
+    s16 x;
+    s16 y;
+
+    u8 flip:2;
+    u8 rotate:2;
+    u8 w:2; // width in tiles - 1
+    u8 h:2; // height in tiles - 1
+
+    u8 colorkey:4;
+    u8 keyed:1;
+    u8 scale:3; // scale - 1
+} tic_oam_entry;
+
+// raster row overrides read by rasterbuf() from any RAM address
+typedef struct
+{
+    u8 row;
+    s8 x;           // added to the horizontal screen offset
+    s8 border;      // border color, -1 keeps the VRAM one
+    u8 color;       // palette entry replaced on the row, 16 and above replace none
+    tic_rgb rgb;
+} tic_raster_entry;
+
 typedef union
 {
     struct
@@ -54,16 +54,16 @@ static void onExit(void* data)
         tic->callback.exit();
 }
 
-static u64 getFreq()
+static u64 getFreq(void* data)
 {
     return TIC80_FRAMERATE;
 }
 
-static u64 TickCounter = 0;
-
-static u64 getCounter()
+static u64 getCounter(void* data)
 {
-    return TickCounter;
+    tic80_local* tic80 = (tic80_local*)data;
+
+    return tic80->tickCounter;
 }
 
 tic80* tic80_create(s32 samplerate)
@@ -101,7 +101,7 @@ TIC80_API void tic80_load(tic80* tic, void* cart, s32 size)
         tic80->tickData.start = 0;
         tic80->tickData.freq = getFreq;
         tic80->tickData.counter = getCounter;
-        TickCounter = 0;
+        tic80->tickCounter = 0;
     }
 
     {
@@ -122,8 +122,9 @@ TIC80_API void tic80_tick(tic80* tic, const tic80_input* input)
     tic_core_tick_end(tic80->memory);
 
     tic_core_blit(tic80->memory, tic80->memory->screen_format);
+    tic80->tic.dirty = tic80->memory->dirty.count;
 
-    TickCounter++;
+    tic80->tickCounter++;
 }
 
 TIC80_API void tic80_delete(tic80* tic)
@@ -26,11 +26,15 @@
 
 typedef struct { u8 index; tic_flip flip; tic_rotate rotate; } RemapResult;
 typedef void(*RemapFunc)(void*, s32 x, s32 y, RemapResult* result);
+typedef struct { s32 x; s32 y; RemapResult result; } RemapCell;
+typedef void(*RemapBatchFunc)(void*, RemapCell* cells, s32 count);
 
 typedef void(*TraceOutput)(void*, const char*, u8 color);
 typedef void(*ErrorOutput)(void*, const char*);
 typedef void(*ExitCallback)(void*);
 typedef bool(*CheckForceExit)(void*);
+typedef void*(*LoadCodeCache)(void*, const char* name, const char* code, s32* size);
+typedef void(*SaveCodeCache)(void*, const char* name, const char* code, const void* buffer, s32 size);
 
 typedef struct
 {
@@ -39,10 +43,15 @@ typedef struct
     ExitCallback exit;
     CheckForceExit forceExit;
     
-    u64 (*counter)();
-    u64 (*freq)();
+    u64 (*counter)(void*);
+    u64 (*freq)(void*);
     u64 start;
 
+    // optional, the compiled code is kept by the host under the name and the source it was made from,
+    // the loaded buffer is allocated with malloc and freed by the caller
+    LoadCodeCache loadCache;
+    SaveCodeCache saveCache;
+
     void* data;
 } tic_tick_data;
 
@@ -82,12 +91,17 @@ typedef struct
 
     const char* const * keywords;
     s32 keywordsCount;
+
+    const char* name;
 } tic_script_config;
 
 #define TIC_FN "TIC"
 #define SCN_FN "SCN"
 #define OVR_FN "OVR"
 
+// raster() field that leaves the row as it is
+#define TIC_RASTER_KEEP INT32_MIN
+
 //                  API DEFINITION TABLE
 //      .----------------------------------------------- - - - 
 //      |   NAME  | COUNT | RETURN  |     ARGUMENTS     
@@ -101,10 +115,11 @@ typedef struct
     macro(rect,         5,  void,   tic_mem*, s32 x, s32 y, s32 width, s32 height, u8 color) \
     macro(rectb,        5,  void,   tic_mem*, s32 x, s32 y, s32 width, s32 height, u8 color) \
     macro(spr,          9,  void,   tic_mem*, s32 index, s32 x, s32 y, s32 w, s32 h, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate) \
+    macro(oam,          2,  void,   tic_mem*, s32 address, s32 count) \
     macro(btn,          1,  u32,    tic_mem*, s32 id) \
     macro(btnp,         3,  u32,    tic_mem*, s32 id, s32 hold, s32 period) \
     macro(sfx,          6,  void,   tic_mem*, s32 index, s32 note, s32 octave, s32 duration, s32 channel, s32 volume, s32 speed) \
-    macro(map,          9,  void,   tic_mem*, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* colors, s32 count, s32 scale, RemapFunc remap, void* data) \
+    macro(map,          10, void,   tic_mem*, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* colors, s32 count, s32 scale, RemapFunc remap, void* data) \
     macro(mget,         2,  u8,     tic_mem*, s32 x, s32 y) \
     macro(mset,         3,  void,   tic_mem*, s32 x, s32 y, u8 value) \
     macro(peek,         1,  u8,     tic_mem*, s32 address) \
@@ -113,6 +128,10 @@ typedef struct
     macro(poke4,        2,  void,   tic_mem*, s32 address, u8 value) \
     macro(memcpy,       3,  void,   tic_mem*, s32 dst, s32 src, s32 size) \
     macro(memset,       3,  void,   tic_mem*, s32 dst, u8 val, s32 size) \
+    macro(peekbuf,      2,  void,   tic_mem*, s32 address, u8* buffer, s32 size) \
+    macro(pokebuf,      2,  void,   tic_mem*, s32 address, const u8* buffer, s32 size) \
+    macro(peek4buf,     2,  void,   tic_mem*, s32 address, u8* buffer, s32 size) \
+    macro(poke4buf,     2,  void,   tic_mem*, s32 address, const u8* buffer, s32 size) \
     macro(trace,        2,  void,   tic_mem*, const char* text, u8 color) \
     macro(pmem,         2,  u32,    tic_mem*, s32 index, u32 value, bool get) \
     macro(time,         0,  double, tic_mem*) \
@@ -123,8 +142,12 @@ typedef struct
     macro(circ,         4,  void,   tic_mem*, s32 x, s32 y, s32 radius, u8 color) \
     macro(circb,        4,  void,   tic_mem*, s32 x, s32 y, s32 radius, u8 color) \
     macro(tri,          7,  void,   tic_mem*, s32 x1, s32 y1, s32 x2, s32 y2, s32 x3, s32 y3, u8 color) \
-    macro(textri,       14, void,   tic_mem*, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, bool use_map, u8* colors, s32 count) \
+    macro(textri,       17, void,   tic_mem*, float x1, float y1, float x2, float y2, float x3, float y3, float u1, float v1, float u2, float v2, float u3, float v3, bool use_map, u8* colors, s32 count, float z1, float z2, float z3, bool depth) \
     macro(clip,         4,  void,   tic_mem*, s32 x, s32 y, s32 width, s32 height) \
+    macro(target,       1,  void,   tic_mem*, s32 index) \
+    macro(blit,         6,  void,   tic_mem*, s32 src, s32 x, s32 y, u8* colors, s32 count, s32 dst, const u8* remap) \
+    macro(raster,       5,  void,   tic_mem*, s32 row, s32 x, s32 border, s32 color, u32 rgb) \
+    macro(rasterbuf,    2,  void,   tic_mem*, s32 address, s32 count) \
     macro(music,        4,  void,   tic_mem*, s32 track, s32 frame, s32 row, bool loop, bool sustain) \
     macro(sync,         3,  void,   tic_mem*, u32 mask, s32 bank, bool toCart) \
     macro(reset,        0,  void,   tic_mem*) \
@@ -139,6 +162,81 @@ typedef struct
 TIC_API_LIST(TIC_API_DEF)
 #undef TIC_API_DEF
 
+typedef enum
+{
+#define TIC_API_DEF(name, ...) tic_api_index_##name,
+    TIC_API_LIST(TIC_API_DEF)
+#undef TIC_API_DEF
+    tic_api_count,
+} tic_api_index;
+
+// frame phases measured by the profiler
+#define TIC_PROFILE_LIST(macro) \
+    macro(start,    "START") \
+    macro(tick,     "TIC") \
+    macro(scanline, "SCN") \
+    macro(overline, "OVR") \
+    macro(end,      "END") \
+    macro(blit,     "BLIT") \
+    macro(present,  "PRESENT")
+
+typedef enum
+{
+#define TIC_PROFILE_DEF(name, _) tic_profile_##name,
+    TIC_PROFILE_LIST(TIC_PROFILE_DEF)
+#undef TIC_PROFILE_DEF
+    tic_profile_phases,
+} tic_profile_phase;
+
+#define TIC_PROFILE_FRAMES 256
+#define TIC_TRACE_MAX_EVENTS (1 << 20)
+
+typedef struct
+{
+    u64 start;
+    u64 duration;
+    const char* lang;   // script language of the API calls, NULL for the frame phases
+    u16 id;             // tic_profile_phase or tic_api_index
+} tic_trace_event;
+
+typedef struct
+{
+    // profiling is off while the counter is NULL
+    u64 (*counter)(void*);
+    u64 freq;
+    void* data;
+
+    u64 start[tic_profile_phases];
+
+    // ring of counter ticks spent in every phase, frame % TIC_PROFILE_FRAMES is being recorded
+    u32 frame;
+    u64 frames[TIC_PROFILE_FRAMES][tic_profile_phases];
+
+    // events captured between tic_core_trace_start and tic_core_trace_stop
+    struct
+    {
+        tic_trace_event* events;
+        s32 count;
+        s32 size;
+        s32 dropped;
+        bool active;
+
+        // script bindings register traced API functions on init when it's set
+        bool api;
+        const char* lang;
+    } trace;
+} tic_profile;
+
+// totals of the last blitted frame, updated while the overdraw view is on, see tic_core_overdraw
+typedef struct
+{
+    bool active;
+    u32 pixels;     // pixel writes to the screen, a pixel drawn twice counts twice
+    u32 covered;    // screen pixels written at least once
+    u32 tiles;      // 8x8 tiles drawn by spr(), map(), oam() and text
+    u16 peak;       // most writes to a single pixel
+} tic_overdraw;
+
 struct tic_mem
 {
     tic_ram             ram;
@@ -170,6 +268,17 @@ struct tic_mem
     u32 screen[TIC80_FULLWIDTH * TIC80_FULLHEIGHT];
 #endif
     tic80_pixel_color_format screen_format;
+
+    // screen buffer rows changed by the last blit and OVR drawing after it
+    struct
+    {
+        s32 top;
+        s32 bottom;
+        s32 count;
+    } dirty;
+
+    tic_profile profile;
+    tic_overdraw overdraw;
 };
 
 tic_mem* tic_core_create(s32 samplerate);
@@ -181,11 +290,31 @@ void tic_core_tick(tic_mem* memory, tic_tick_data* data);
 void tic_core_tick_end(tic_mem* memory);
 void tic_core_blit(tic_mem* tic, tic80_pixel_color_format fmt);
 void tic_core_blit_ex(tic_mem* tic, tic80_pixel_color_format fmt, tic_scanline scanline, tic_overline overline, void* data);
+void tic_core_invalidate(tic_mem* memory, s32 address, s32 size);
+void tic_core_screen_drawn(tic_mem* memory, s32 top, s32 bottom);
+bool tic_core_draw_thread(tic_mem* memory, bool enable);
+void tic_core_random_seed(tic_mem* memory, u64 seed);
+u32 tic_core_random(tic_mem* memory);
+bool tic_core_blit_simd(tic_mem* memory, bool enable);
+void tic_core_overdraw(tic_mem* memory, bool enable);
+bool tic_core_audio_ring(tic_mem* memory, s32 ticks);
+void tic_core_synth_audio(tic_mem* memory, s16* samples, s32 count);
+void tic_core_map_batch(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* colors, s32 count, s32 scale, RemapBatchFunc remap, void* data);
 const tic_script_config* tic_core_script_config(tic_mem* memory);
+void tic_core_script_callbacks(tic_mem* memory, bool scanline, bool overline);
+void tic_core_profile_enable(tic_mem* memory, u64 (*counter)(void*), u64 freq, void* data);
+void tic_core_profile_frame(tic_mem* memory);
+void tic_core_profile_begin(tic_mem* memory, tic_profile_phase phase);
+void tic_core_profile_end(tic_mem* memory, tic_profile_phase phase);
+void tic_core_trace_start(tic_mem* memory, bool api);
+void tic_core_trace_stop(tic_mem* memory);
+u64 tic_core_trace_begin(tic_mem* memory);
+void tic_core_trace_end(tic_mem* memory, tic_api_index index, u64 start);
 
 typedef struct
 {
     tic80 tic;
     tic_mem* memory;
     tic_tick_data tickData;
+    u64 tickCounter;
 } tic80_local;
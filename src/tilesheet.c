@@ -29,24 +29,25 @@ static const tic_blit_segment segments[] = {
 //   |  +bank +bank_size
 //   |  |  |  |     +sheet_width
 //   |  |  |  |     |   +tile_width
-    {0, 0, 1, 256,  16, 8,  TIC_SPRITESIZE,   tic_tool_peek1, tic_tool_poke1}, // system gfx
-    {0, 0, 1, 256,  16, 8,  TIC_SPRITESIZE,   tic_tool_peek1, tic_tool_poke1}, // system font
-    {0, 0, 1, 256,  16, 8,  sizeof(tic_tile), tic_tool_peek4, tic_tool_poke4}, // 4bpp p0 bg
-    {0, 1, 1, 256,  16, 8,  sizeof(tic_tile), tic_tool_peek4, tic_tool_poke4}, // 4bpp p0 fg
+//   |  |  |  |     |   |   +bpp
+    {0, 0, 1, 256,  16, 8,  1, TIC_SPRITESIZE,   tic_tool_peek1, tic_tool_poke1}, // system gfx
+    {0, 0, 1, 256,  16, 8,  1, TIC_SPRITESIZE,   tic_tool_peek1, tic_tool_poke1}, // system font
+    {0, 0, 1, 256,  16, 8,  4, sizeof(tic_tile), tic_tool_peek4, tic_tool_poke4}, // 4bpp p0 bg
+    {0, 1, 1, 256,  16, 8,  4, sizeof(tic_tile), tic_tool_peek4, tic_tool_poke4}, // 4bpp p0 fg
               
-    {0, 0, 2, 512,  32, 16, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p0 bg
-    {1, 0, 2, 512,  32, 16, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p1 bg
-    {0, 1, 2, 512,  32, 16, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p0 fg
-    {1, 1, 2, 512,  32, 16, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p1 fg
+    {0, 0, 2, 512,  32, 16, 2, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p0 bg
+    {1, 0, 2, 512,  32, 16, 2, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p1 bg
+    {0, 1, 2, 512,  32, 16, 2, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p0 fg
+    {1, 1, 2, 512,  32, 16, 2, sizeof(tic_tile), tic_tool_peek2, tic_tool_poke2}, // 2bpp p1 fg
               
-    {0, 0, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p0 bg
-    {1, 0, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p1 bg
-    {2, 0, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p2 bg
-    {3, 0, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p3 bg
-    {0, 1, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p0 fg
-    {1, 1, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p1 fg
-    {2, 1, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p2 fg
-    {3, 1, 4, 1024, 64, 32, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p3 fg
+    {0, 0, 4, 1024, 64, 32, 1, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p0 bg
+    {1, 0, 4, 1024, 64, 32, 1, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p1 bg
+    {2, 0, 4, 1024, 64, 32, 1, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p2 bg
+    {3, 0, 4, 1024, 64, 32, 1, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p3 bg
+    {0, 1, 4, 1024, 64, 32, 1, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p0 fg
+    {1, 1, 4, 1024, 64, 32, 1, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p1 fg
+    {2, 1, 4, 1024, 64, 32, 1, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p2 fg
+    {3, 1, 4, 1024, 64, 32, 1, sizeof(tic_tile), tic_tool_peek1, tic_tool_poke1}, // 1bpp p3 fg
 };
 
 extern u8 getTileSheetPixel(const tic_tilesheet* sheet, s32 x, s32 y);
@@ -91,3 +92,44 @@ tic_tileptr getTile(const tic_tilesheet* sheet, s32 index, bool local)
 
     return (tic_tileptr){segment, offset, ptr};
 }
+
+void invalidateTileCache(tic_tilecache* cache, s32 offset, s32 size)
+{
+    enum {Size = sizeof(tic_tile)};
+
+    s32 first = MAX(offset, 0) / Size;
+    s32 last = MIN(offset + size, TIC_SPRITES * Size);
+
+    for(s32 i = first; i * Size < last; i++)
+        cache->valid[i] = 0;
+}
+
+const u8* getTileCacheData(tic_tilecache* cache, const tic_blit_segment* segment, const tic_tiles* tiles, s32 index)
+{
+    u8* data = segment->bpp == 4 ? cache->bpp4[index]
+        : segment->bpp == 2 ? cache->bpp2[index]
+        : cache->bpp1[index];
+
+    if(!(cache->valid[index] & segment->bpp))
+    {
+        const tic_tile* tile = &tiles->data[index];
+        enum {Bits = sizeof(tic_tile) * BITS_IN_BYTE};
+
+        for(s32 i = 0, count = Bits / segment->bpp; i < count; i++)
+            data[i] = segment->peek(tile, i);
+
+        cache->valid[index] |= segment->bpp;
+    }
+
+    return data;
+}
+
+const u8* getTileCachePixels(tic_tilecache* cache, const tic_tiles* tiles, const tic_tileptr* tile)
+{
+    s32 offset = (s32)(tile->ptr - (const u8*)tiles);
+
+    if(tile->segment->ptr_size != sizeof(tic_tile) || offset < 0 || offset >= TIC_SPRITES * sizeof(tic_tile))
+        return NULL;
+
+    return getTileCacheData(cache, tile->segment, tiles, offset / sizeof(tic_tile)) + tile->offset;
+}
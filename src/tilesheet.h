@@ -34,6 +34,7 @@ typedef struct
     u32    bank_size;
     u32    sheet_width;
     u32    tile_width;
+    u8     bpp;
     size_t ptr_size;
     u8     (*peek)(const void*, u32);
     void   (*poke)(void*, u32, u8);
@@ -52,9 +53,23 @@ typedef struct
     u8* ptr;
 } tic_tileptr;
 
+typedef struct
+{
+    // tiles and sprites RAM decoded to one byte per pixel, bpp bits mark the decoded tiles
+    u8 valid[TIC_SPRITES];
+
+    u8 bpp4[TIC_SPRITES][TIC_SPRITESIZE * TIC_SPRITESIZE];
+    u8 bpp2[TIC_SPRITES][TIC_SPRITESIZE * TIC_SPRITESIZE * 2];
+    u8 bpp1[TIC_SPRITES][TIC_SPRITESIZE * TIC_SPRITESIZE * 4];
+} tic_tilecache;
+
 tic_tilesheet getTileSheet(u8 segment, u8* ptr);
 tic_tileptr getTile(const tic_tilesheet* sheet, s32 index, bool local);
 
+void invalidateTileCache(tic_tilecache* cache, s32 offset, s32 size);
+const u8* getTileCacheData(tic_tilecache* cache, const tic_blit_segment* segment, const tic_tiles* tiles, s32 index);
+const u8* getTileCachePixels(tic_tilecache* cache, const tic_tiles* tiles, const tic_tileptr* tile);
+
 inline u8 getTileSheetPixel(const tic_tilesheet* sheet, s32 x, s32 y)
 {
     // tile coord
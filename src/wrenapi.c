@@ -31,14 +31,7 @@
 
 #include "tools.h"
 #include "wren.h"
-
-static WrenHandle* game_class;
-static WrenHandle* new_handle;
-static WrenHandle* update_handle;
-static WrenHandle* scanline_handle;
-static WrenHandle* overline_handle;
-
-static bool loaded = false;
+#include "wren_vm.h"
 
 static char const* tic_wren_api = "\n\
 class TIC {\n\
@@ -62,6 +55,14 @@ class TIC {\n\
     foreign static spr(id, x, y, alpha_color, scale, flip)\n\
     foreign static spr(id, x, y, alpha_color, scale, flip, rotate)\n\
     foreign static spr(id, x, y, alpha_color, scale, flip, rotate, cell_width, cell_height)\n\
+    foreign static oam(addr, count)\n\
+    foreign static target()\n\
+    foreign static target(index)\n\
+    foreign static blit(src)\n\
+    foreign static blit(src, x, y)\n\
+    foreign static blit(src, x, y, alpha_color)\n\
+    foreign static blit(src, x, y, alpha_color, dst)\n\
+    foreign static blit(src, x, y, alpha_color, dst, remap)\n\
     foreign static map(cell_x, cell_y)\n\
     foreign static map(cell_x, cell_y, cell_w, cell_h)\n\
     foreign static map(cell_x, cell_y, cell_w, cell_h, x, y)\n\
@@ -73,6 +74,7 @@ class TIC {\n\
     foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3)\n\
     foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, use_map)\n\
     foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, use_map, alpha_color)\n\
+    foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, use_map, alpha_color, z1, z2, z3)\n\
     foreign static pix(x, y)\n\
     foreign static pix(x, y, color)\n\
     foreign static line(x0, y0, x1, y1, color)\n\
@@ -85,12 +87,22 @@ class TIC {\n\
     foreign static cls(color)\n\
     foreign static clip()\n\
     foreign static clip(x, y, w, h)\n\
+    foreign static raster()\n\
+    foreign static raster(row)\n\
+    foreign static raster(row, x)\n\
+    foreign static raster(row, x, border)\n\
+    foreign static raster(row, x, border, color, rgb)\n\
+    foreign static rasterbuf(addr, count)\n\
     foreign static peek(addr)\n\
     foreign static poke(addr, val)\n\
     foreign static peek4(addr)\n\
     foreign static poke4(addr, val)\n\
     foreign static memcpy(dst, src, size)\n\
     foreign static memset(dst, src, size)\n\
+    foreign static peekbuf(addr, size)\n\
+    foreign static pokebuf(addr, data)\n\
+    foreign static peek4buf(addr, size)\n\
+    foreign static poke4buf(addr, data)\n\
     foreign static pmem(index)\n\
     foreign static pmem(index, val)\n\
     foreign static sfx(id)\n\
@@ -200,15 +212,15 @@ static void closeWren(tic_mem* tic)
     if(machine->wren)
     {   
         // release handles
-        if (loaded)
+        if (machine->wrenHandles.loaded)
         {
-            wrenReleaseHandle(machine->wren, new_handle);
-            wrenReleaseHandle(machine->wren, update_handle);
-            wrenReleaseHandle(machine->wren, scanline_handle);
-            wrenReleaseHandle(machine->wren, overline_handle);
-            if (game_class != NULL) 
+            wrenReleaseHandle(machine->wren, machine->wrenHandles.create);
+            wrenReleaseHandle(machine->wren, machine->wrenHandles.update);
+            wrenReleaseHandle(machine->wren, machine->wrenHandles.scanline);
+            wrenReleaseHandle(machine->wren, machine->wrenHandles.overline);
+            if (machine->wrenHandles.game != NULL) 
             {
-                wrenReleaseHandle(machine->wren, game_class);
+                wrenReleaseHandle(machine->wren, machine->wrenHandles.game);
             }
         }
 
@@ -216,7 +228,7 @@ static void closeWren(tic_mem* tic)
         machine->wren = NULL;
 
     }
-    loaded = false;
+    machine->wrenHandles.loaded = false;
 }
 
 static tic_machine* getWrenMachine(WrenVM* vm)
@@ -489,6 +501,80 @@ static void wren_trace(WrenVM* vm)
     tic_api_trace(tic, text, color);
 }
 
+static void wren_target(WrenVM* vm)
+{
+    tic_mem* tic = (tic_mem*)getWrenMachine(vm);
+
+    tic_api_target(tic, wrenGetSlotCount(vm) > 1 ? getWrenNumber(vm, 1) : -1);
+}
+
+// reads a number or a list of up to 16 numbers, the slot after the arguments is used for the items
+static s32 getWrenColors(WrenVM* vm, s32 index, s32 top, u8* colors)
+{
+    s32 count = 0;
+
+    if(isList(vm, index))
+    {
+        wrenEnsureSlots(vm, top + 1);
+        s32 listCount = MIN(wrenGetListCount(vm, index), TIC_PALETTE_SIZE);
+
+        for(s32 i = 0; i < listCount; i++)
+        {
+            wrenGetListElement(vm, index, i, top);
+            if(!isNumber(vm, top)) break;
+            colors[count++] = getWrenNumber(vm, top);
+        }
+    }
+    else if(isNumber(vm, index))
+        colors[count++] = getWrenNumber(vm, index);
+
+    return count;
+}
+
+static void wren_blit(WrenVM* vm)
+{
+    s32 top = wrenGetSlotCount(vm);
+    tic_mem* tic = (tic_mem*)getWrenMachine(vm);
+
+    s32 src = getWrenNumber(vm, 1);
+    s32 x = top > 3 ? getWrenNumber(vm, 2) : 0;
+    s32 y = top > 3 ? getWrenNumber(vm, 3) : 0;
+    u8 colors[TIC_PALETTE_SIZE];
+    s32 count = top > 4 ? getWrenColors(vm, 4, top, colors) : 0;
+    s32 dst = top > 5 && isNumber(vm, 5) ? getWrenNumber(vm, 5) : -1;
+    u8 remap[TIC_PALETTE_SIZE];
+    bool hasRemap = top > 6 && isList(vm, 6);
+
+    if(hasRemap)
+    {
+        wrenEnsureSlots(vm, top + 1);
+        s32 listCount = wrenGetListCount(vm, 6);
+
+        for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+        {
+            remap[i] = i;
+
+            if(i < listCount)
+            {
+                wrenGetListElement(vm, 6, i, top);
+                if(isNumber(vm, top)) remap[i] = getWrenNumber(vm, top);
+            }
+        }
+    }
+
+    tic_api_blit(tic, src, x, y, colors, count, dst, hasRemap ? remap : NULL);
+}
+
+static void wren_oam(WrenVM* vm)
+{
+    tic_mem* tic = (tic_mem*)getWrenMachine(vm);
+
+    s32 address = getWrenNumber(vm, 1);
+    s32 count = getWrenNumber(vm, 2);
+
+    tic_api_oam(tic, address, count);
+}
+
 static void wren_spr(WrenVM* vm)
 {   
     s32 top = wrenGetSlotCount(vm);
@@ -501,7 +587,7 @@ static void wren_spr(WrenVM* vm)
     s32 scale = 1;
     tic_flip flip = tic_no_flip;
     tic_rotate rotate = tic_no_rotate;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     if(top > 1) 
@@ -576,7 +662,7 @@ static void wren_spr_internal(WrenVM* vm)
     s32 x = getWrenNumber(vm, 2);
     s32 y = getWrenNumber(vm, 3);
 
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
             
     if(isList(vm, 4))
@@ -621,7 +707,7 @@ static void wren_map(WrenVM* vm)
     s32 sx = 0;
     s32 sy = 0;
     s32 scale = 1;
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
 
     s32 top = wrenGetSlotCount(vm);
@@ -715,7 +801,7 @@ static void wren_textri(WrenVM* vm)
     }
 
     tic_mem* tic = (tic_mem*)getWrenMachine(vm);
-    static u8 colors[TIC_PALETTE_SIZE];
+    u8 colors[TIC_PALETTE_SIZE];
     s32 count = 0;
     bool use_map = false;
 
@@ -750,6 +836,14 @@ static void wren_textri(WrenVM* vm)
         count = 1;
     }
 
+    //  check for depth
+    float z[3] = {0};
+    bool depth = top > 17;
+
+    if(depth)
+        for(s32 i = 0; i < COUNT_OF(z); i++)
+            z[i] = (float)getWrenNumber(vm, i + 15);
+
     tic_api_textri(tic, pt[0], pt[1],   //  xy 1
                                 pt[2], pt[3],   //  xy 2
                                 pt[4], pt[5],   //  xy 3
@@ -757,7 +851,8 @@ static void wren_textri(WrenVM* vm)
                                 pt[8], pt[9],   //  uv 2
                                 pt[10], pt[11], //  uv 3
                                 use_map,        // use map
-                                colors, count);        // chroma
+                                colors, count,  // chroma
+                                z[0], z[1], z[2], depth);
 }
 
 static void wren_pix(WrenVM* vm)
@@ -899,6 +994,39 @@ static void wren_clip(WrenVM* vm)
     }
 }
 
+static void wren_raster(WrenVM* vm)
+{
+    s32 top = wrenGetSlotCount(vm);
+
+    tic_mem* tic = (tic_mem*)getWrenMachine(vm);
+
+    if(top == 1)
+    {
+        tic_api_raster(tic, -1, 0, -1, -1, 0);
+    }
+    else
+    {
+        // missing or null fields leave the row as it is
+        s32 row = getWrenNumber(vm, 1);
+        s32 x = top > 2 && wrenGetSlotType(vm, 2) != WREN_TYPE_NULL ? getWrenNumber(vm, 2) : TIC_RASTER_KEEP;
+        s32 border = top > 3 && wrenGetSlotType(vm, 3) != WREN_TYPE_NULL ? getWrenNumber(vm, 3) : TIC_RASTER_KEEP;
+        s32 color = top > 5 && wrenGetSlotType(vm, 4) != WREN_TYPE_NULL ? getWrenNumber(vm, 4) : -1;
+        u32 rgb = top > 5 ? getWrenNumber(vm, 5) : 0;
+
+        tic_api_raster(tic, row, x, border, color, rgb);
+    }
+}
+
+static void wren_rasterbuf(WrenVM* vm)
+{
+    tic_mem* tic = (tic_mem*)getWrenMachine(vm);
+
+    s32 address = getWrenNumber(vm, 1);
+    s32 count = getWrenNumber(vm, 2);
+
+    tic_api_rasterbuf(tic, address, count);
+}
+
 static void wren_peek(WrenVM* vm)
 {
     tic_mem* tic = (tic_mem*)getWrenMachine(vm);
@@ -937,6 +1065,87 @@ static void wren_poke4(WrenVM* vm)
     tic_api_poke4(tic, address, value);
 }
 
+typedef void(*PeekBuffer)(tic_mem*, s32 address, u8* buffer, s32 size);
+typedef void(*PokeBuffer)(tic_mem*, s32 address, const u8* buffer, s32 size);
+
+// wren has no blob type, the range is returned as a byte string
+static void peekWrenBuffer(WrenVM* vm, PeekBuffer peek, s32 limit)
+{
+    s32 address = getWrenNumber(vm, 1);
+    s32 size = getWrenNumber(vm, 2);
+
+    if(size < 0 || size > limit)
+    {
+        wrenError(vm, "invalid buffer size");
+        return;
+    }
+
+    u8* buffer = malloc(MAX(size, 1));
+
+    if(buffer)
+    {
+        tic_mem* tic = (tic_mem*)getWrenMachine(vm);
+        peek(tic, address, buffer, size);
+        wrenSetSlotBytes(vm, 0, (const char*)buffer, size);
+        free(buffer);
+    }
+}
+
+// accepts a byte string or a list of numbers
+static void pokeWrenBuffer(WrenVM* vm, PokeBuffer poke, s32 limit)
+{
+    s32 address = getWrenNumber(vm, 1);
+    tic_mem* tic = (tic_mem*)getWrenMachine(vm);
+
+    if(isString(vm, 2))
+    {
+        s32 size = 0;
+        const char* data = wrenGetSlotBytes(vm, 2, &size);
+
+        poke(tic, address, (const u8*)data, MIN(size, limit));
+    }
+    else if(isList(vm, 2))
+    {
+        s32 size = MIN(wrenGetListCount(vm, 2), limit);
+        u8* buffer = malloc(MAX(size, 1));
+
+        if(buffer)
+        {
+            wrenEnsureSlots(vm, 4);
+
+            for(s32 i = 0; i < size; i++)
+            {
+                wrenGetListElement(vm, 2, i, 3);
+                buffer[i] = isNumber(vm, 3) ? getWrenNumber(vm, 3) : 0;
+            }
+
+            poke(tic, address, buffer, size);
+            free(buffer);
+        }
+    }
+    else wrenError(vm, "invalid buffer, use a string or a list");
+}
+
+static void wren_peekbuf(WrenVM* vm)
+{
+    peekWrenBuffer(vm, tic_api_peekbuf, sizeof(tic_ram));
+}
+
+static void wren_pokebuf(WrenVM* vm)
+{
+    pokeWrenBuffer(vm, tic_api_pokebuf, sizeof(tic_ram));
+}
+
+static void wren_peek4buf(WrenVM* vm)
+{
+    peekWrenBuffer(vm, tic_api_peek4buf, sizeof(tic_ram) * 2);
+}
+
+static void wren_poke4buf(WrenVM* vm)
+{
+    pokeWrenBuffer(vm, tic_api_poke4buf, sizeof(tic_ram) * 2);
+}
+
 static void wren_memcpy(WrenVM* vm)
 {
     s32 dest = getWrenNumber(vm, 1);
@@ -1220,6 +1429,14 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
     if (strcmp(signature, "static TIC.spr(_,_,_,_,_,_)"         ) == 0) return wren_spr;
     if (strcmp(signature, "static TIC.spr(_,_,_,_,_,_,_)"       ) == 0) return wren_spr;
     if (strcmp(signature, "static TIC.spr(_,_,_,_,_,_,_,_,_)"   ) == 0) return wren_spr;
+    if (strcmp(signature, "static TIC.oam(_,_)"                 ) == 0) return wren_oam;
+    if (strcmp(signature, "static TIC.target()"                 ) == 0) return wren_target;
+    if (strcmp(signature, "static TIC.target(_)"                ) == 0) return wren_target;
+    if (strcmp(signature, "static TIC.blit(_)"                  ) == 0) return wren_blit;
+    if (strcmp(signature, "static TIC.blit(_,_,_)"              ) == 0) return wren_blit;
+    if (strcmp(signature, "static TIC.blit(_,_,_,_)"            ) == 0) return wren_blit;
+    if (strcmp(signature, "static TIC.blit(_,_,_,_,_)"          ) == 0) return wren_blit;
+    if (strcmp(signature, "static TIC.blit(_,_,_,_,_,_)"        ) == 0) return wren_blit;
 
     if (strcmp(signature, "static TIC.map(_,_)"                 ) == 0) return wren_map;
     if (strcmp(signature, "static TIC.map(_,_,_,_)"             ) == 0) return wren_map;
@@ -1234,6 +1451,7 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
     if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_)"       ) == 0) return wren_textri;
     if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_,_)"     ) == 0) return wren_textri;
     if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_,_,_)"   ) == 0) return wren_textri;
+    if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_,_,_,_,_,_)") == 0) return wren_textri;
 
     if (strcmp(signature, "static TIC.pix(_,_)"                 ) == 0) return wren_pix;
     if (strcmp(signature, "static TIC.pix(_,_,_)"               ) == 0) return wren_pix;
@@ -1248,11 +1466,21 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
     if (strcmp(signature, "static TIC.cls(_)"                   ) == 0) return wren_cls;
     if (strcmp(signature, "static TIC.clip()"                   ) == 0) return wren_clip;
     if (strcmp(signature, "static TIC.clip(_,_,_,_)"            ) == 0) return wren_clip;
+    if (strcmp(signature, "static TIC.raster()"                 ) == 0) return wren_raster;
+    if (strcmp(signature, "static TIC.raster(_)"                ) == 0) return wren_raster;
+    if (strcmp(signature, "static TIC.raster(_,_)"              ) == 0) return wren_raster;
+    if (strcmp(signature, "static TIC.raster(_,_,_)"            ) == 0) return wren_raster;
+    if (strcmp(signature, "static TIC.raster(_,_,_,_,_)"        ) == 0) return wren_raster;
+    if (strcmp(signature, "static TIC.rasterbuf(_,_)"           ) == 0) return wren_rasterbuf;
 
     if (strcmp(signature, "static TIC.peek(_)"                  ) == 0) return wren_peek;
     if (strcmp(signature, "static TIC.poke(_,_)"                ) == 0) return wren_poke;
     if (strcmp(signature, "static TIC.peek4(_)"                 ) == 0) return wren_peek4;
     if (strcmp(signature, "static TIC.poke4(_,_)"               ) == 0) return wren_poke4;
+    if (strcmp(signature, "static TIC.peekbuf(_,_)"             ) == 0) return wren_peekbuf;
+    if (strcmp(signature, "static TIC.pokebuf(_,_)"             ) == 0) return wren_pokebuf;
+    if (strcmp(signature, "static TIC.peek4buf(_,_)"            ) == 0) return wren_peek4buf;
+    if (strcmp(signature, "static TIC.poke4buf(_,_)"            ) == 0) return wren_poke4buf;
     if (strcmp(signature, "static TIC.memcpy(_,_,_)"            ) == 0) return wren_memcpy;
     if (strcmp(signature, "static TIC.memset(_,_,_)"            ) == 0) return wren_memset;
     if (strcmp(signature, "static TIC.pmem(_)"                  ) == 0) return wren_pmem;
@@ -1297,6 +1525,32 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
 static const WrenForeignMethodFn ApiFuncList[] = {TIC_API_LIST(API_FUNC_DEF)};
 #undef API_FUNC_DEF
 
+// API functions recording trace spans, bound instead of the plain ones while tracing
+#define API_TRACE_DEF(name, ...)                                    \
+    static void wren_trace_ ## name(WrenVM* vm)                     \
+    {                                                               \
+        tic_mem* tic = (tic_mem*)getWrenMachine(vm);                \
+        u64 start = tic_core_trace_begin(tic);                      \
+        wren_ ## name(vm);                                          \
+        tic_core_trace_end(tic, tic_api_index_ ## name, start);     \
+    }
+TIC_API_LIST(API_TRACE_DEF)
+#undef API_TRACE_DEF
+
+#define API_FUNC_DEF(name, ...) wren_trace_##name,
+static const WrenForeignMethodFn ApiTraceList[] = {TIC_API_LIST(API_FUNC_DEF)};
+#undef API_FUNC_DEF
+
+static WrenForeignMethodFn traceForeignMethod(WrenVM* vm, WrenForeignMethodFn func)
+{
+    if(getWrenMachine(vm)->memory.profile.trace.api)
+        for(s32 i = 0; i < COUNT_OF(ApiFuncList); i++)
+            if(ApiFuncList[i] == func)
+                return ApiTraceList[i];
+
+    return func;
+}
+
 static WrenForeignMethodFn bindForeignMethod(
     WrenVM* vm, const char* module, const char* className,
     bool isStatic, const char* signature)
@@ -1315,7 +1569,7 @@ static WrenForeignMethodFn bindForeignMethod(
     strcat(fullName, ".");
     strcat(fullName, signature);
 
-    return foreignTicMethods(fullName);
+    return traceForeignMethod(vm, foreignTicMethods(fullName));
 }
 
 static void initAPI(tic_machine* machine)
@@ -1351,6 +1605,21 @@ static void writeFn(WrenVM* vm, const char* text)
     machine->data->trace(machine->data->data, text ? text : "null", color);
 }
 
+// the TIC class has empty SCN/OVR, the game only defines them if its class doesn't inherit those
+static bool isMethodOverridden(WrenVM* vm, WrenHandle* game, WrenHandle* base, const char* signature)
+{
+    s32 symbol = wrenSymbolTableFind(&vm->methodNames, signature, strlen(signature));
+
+    ObjClass* gameClass = wrenGetClass(vm, game->value);
+    ObjClass* baseClass = AS_CLASS(base->value);
+
+    if(symbol < 0 || symbol >= gameClass->methods.count || gameClass->methods.data[symbol].type == METHOD_NONE)
+        return false;
+
+    return symbol >= baseClass->methods.count
+        || gameClass->methods.data[symbol].as.closure != baseClass->methods.data[symbol].as.closure;
+}
+
 static bool initWren(tic_mem* tic, const char* code)
 {
     tic_machine* machine = (tic_machine*)tic;
@@ -1373,32 +1642,42 @@ static bool initWren(tic_mem* tic, const char* code)
         return false;
     }
 
-    loaded = true;
+    machine->wrenHandles.loaded = true;
 
     // make handles
     wrenEnsureSlots(vm, 1);
     wrenGetVariable(vm, "main", "Game", 0);
-    game_class = wrenGetSlotHandle(vm, 0); // handle from game class 
+    machine->wrenHandles.game = wrenGetSlotHandle(vm, 0); // handle from game class 
 
-    new_handle = wrenMakeCallHandle(vm, "new()");
-    update_handle = wrenMakeCallHandle(vm, TIC_FN "()");
-    scanline_handle = wrenMakeCallHandle(vm, SCN_FN "(_)");
-    overline_handle = wrenMakeCallHandle(vm, OVR_FN "()");
+    machine->wrenHandles.create = wrenMakeCallHandle(vm, "new()");
+    machine->wrenHandles.update = wrenMakeCallHandle(vm, TIC_FN "()");
+    machine->wrenHandles.scanline = wrenMakeCallHandle(vm, SCN_FN "(_)");
+    machine->wrenHandles.overline = wrenMakeCallHandle(vm, OVR_FN "()");
 
     // create game class
-    if (game_class)
+    if (machine->wrenHandles.game)
     {
         wrenEnsureSlots(vm, 1);
-        wrenSetSlotHandle(vm, 0, game_class);
-        wrenCall(vm, new_handle);
-        wrenReleaseHandle(machine->wren, game_class); // release game class handle
-        game_class = NULL;
+        wrenSetSlotHandle(vm, 0, machine->wrenHandles.game);
+        wrenCall(vm, machine->wrenHandles.create);
+        wrenReleaseHandle(machine->wren, machine->wrenHandles.game); // release game class handle
+        machine->wrenHandles.game = NULL;
         if (wrenGetSlotCount(vm) == 0) 
         {
             machine->data->error(machine->data->data, "Error in game class :(");
             return false;
         }
-        game_class = wrenGetSlotHandle(vm, 0); // handle from game object 
+        machine->wrenHandles.game = wrenGetSlotHandle(vm, 0); // handle from game object 
+
+        // methods are bound with the class, so the callbacks are resolved once
+        wrenGetVariable(vm, "main", "TIC", 0);
+        WrenHandle* base = wrenGetSlotHandle(vm, 0);
+
+        tic_core_script_callbacks(tic,
+            isMethodOverridden(vm, machine->wrenHandles.game, base, SCN_FN "(_)"),
+            isMethodOverridden(vm, machine->wrenHandles.game, base, OVR_FN "()"));
+
+        wrenReleaseHandle(vm, base);
     } else {
         machine->data->error(machine->data->data, "'Game class' isn't found :(");   
         return false;
@@ -1412,11 +1691,11 @@ static void callWrenTick(tic_mem* tic)
     tic_machine* machine = (tic_machine*)tic;
     WrenVM* vm = machine->wren;
 
-    if(vm && game_class)
+    if(vm && machine->wrenHandles.game)
     {
         wrenEnsureSlots(vm, 1);
-        wrenSetSlotHandle(vm, 0, game_class);
-        wrenCall(vm, update_handle);
+        wrenSetSlotHandle(vm, 0, machine->wrenHandles.game);
+        wrenCall(vm, machine->wrenHandles.update);
     }
 }
 
@@ -1425,12 +1704,12 @@ static void callWrenScanline(tic_mem* tic, s32 row, void* data)
     tic_machine* machine = (tic_machine*)tic;
     WrenVM* vm = machine->wren;
 
-    if(vm && game_class)
+    if(vm && machine->wrenHandles.game)
     {
         wrenEnsureSlots(vm, 2);
-        wrenSetSlotHandle(vm, 0, game_class);
+        wrenSetSlotHandle(vm, 0, machine->wrenHandles.game);
         wrenSetSlotDouble(vm, 1, row);
-        wrenCall(vm, scanline_handle);
+        wrenCall(vm, machine->wrenHandles.scanline);
     }
 }
 
@@ -1439,11 +1718,11 @@ static void callWrenOverline(tic_mem* tic, void* data)
     tic_machine* machine = (tic_machine*)tic;
     WrenVM* vm = machine->wren;
 
-    if (vm && game_class)
+    if (vm && machine->wrenHandles.game)
     {
         wrenEnsureSlots(vm, 1);
-        wrenSetSlotHandle(vm, 0, game_class);
-        wrenCall(vm, overline_handle);
+        wrenSetSlotHandle(vm, 0, machine->wrenHandles.game);
+        wrenCall(vm, machine->wrenHandles.overline);
     }
 }
 
@@ -1543,6 +1822,8 @@ static const tic_script_config WrenSyntaxConfig =
 
     .keywords           = WrenKeywords,
     .keywordsCount      = COUNT_OF(WrenKeywords),
+
+    .name               = "wren",
 };
 
 const tic_script_config* getWrenScriptConfig()